@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include "scheduler/scheduler.h"
+#include "detail/task_queue_impl.h"
+#include "detail/timing_wheel.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+// End-to-end time from Scheduler::schedule() until the task starts
+void ScheduleToStartLatency(benchmark::State& state)
+{
+    scheduler::Scheduler sched{2};
+    std::atomic<int64_t> started{0};
+
+    for (auto _ : state) {
+        started.store(0, std::memory_order_relaxed);
+        auto submitted = clock_type::now();
+        sched.schedule([&started] {
+            started.store(clock_type::now().time_since_epoch().count(),
+                          std::memory_order_release);
+        }, 1);
+        int64_t at;
+        while ((at = started.load(std::memory_order_acquire)) == 0) {}
+        state.SetIterationTime(std::chrono::duration<double>(
+            clock_type::time_point(clock_type::duration(at)) - submitted)
+                                   .count());
+    }
+    state.counters["p99_us"] = sched.getLatencyPercentile(99.0);
+}
+
+// Tasks per second through schedule() or scheduleBatch()
+void ScheduleThroughput(benchmark::State& state)
+{
+    const int64_t tasks = 1024;
+    const bool batched = state.range(0) != 0;
+    scheduler::Scheduler sched{4};
+    std::atomic<int64_t> done{0};
+    std::vector<scheduler::BatchTask> batch;
+
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        if (batched) {
+            batch.clear();
+            for (int64_t i = 0; i < tasks; ++i) {
+                batch.push_back({[&done] { done.fetch_add(1); },
+                                 int(i % 8), std::nullopt});
+            }
+            sched.scheduleBatch(batch);
+        } else {
+            for (int64_t i = 0; i < tasks; ++i) {
+                sched.schedule([&done] { done.fetch_add(1); }, int(i % 8));
+            }
+        }
+        while (done.load() < tasks) {}
+    }
+    state.SetItemsProcessed(state.iterations() * tasks);
+}
+
+// Cost of firing and re-arming range(0) recurring timers on one tick
+void RecurringRearm(benchmark::State& state)
+{
+    using namespace scheduler::detail;
+    std::atomic<uint64_t> sequence{0};
+    auto origin = clock_type::now();
+    TimingWheel wheel{sequence, 1ms, origin};
+    TaskQueue queue;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        wheel.schedule(Task([] {}, 1, sequence++, 1ms, origin, std::nullopt),
+                       origin + 1ms);
+    }
+
+    auto now = origin;
+    for (auto _ : state) {
+        now += 1ms;
+        benchmark::DoNotOptimize(wheel.advance(now, queue));
+        state.PauseTiming();
+        while (queue.pop()) {}
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(ScheduleToStartLatency)->UseManualTime();
+BENCHMARK(ScheduleThroughput)->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(RecurringRearm)->RangeMultiplier(16)->Range(1, 4096);
@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include "detail/task_queue_impl.h"
+#include "detail/multi_queue_impl.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace scheduler::detail;
+
+namespace {
+Task makeTask(uint64_t seq)
+{
+    return Task([] {}, static_cast<int>(seq % 16), seq,
+                std::chrono::milliseconds{0}, time_point{}, std::nullopt);
+}
+
+// Keeps `depth` tasks queued and measures one push plus one pop against it
+template <typename Queue>
+void PushPopAtDepth(benchmark::State& state)
+{
+    Queue queue;
+    uint64_t seq = 0;
+    for (int64_t i = 0; i < state.range(0); ++i) queue.push(makeTask(seq++));
+
+    for (auto _ : state) {
+        queue.push(makeTask(seq++));
+        benchmark::DoNotOptimize(queue.pop());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Every thread pushes a burst and pops it again, all on one shared queue
+template <typename Queue>
+void MultiProducerPushPop(benchmark::State& state)
+{
+    static std::unique_ptr<Queue> queue;
+    constexpr uint64_t kBurst = 64;
+    if (state.thread_index() == 0) queue = std::make_unique<Queue>();
+
+    uint64_t seq = uint64_t(state.thread_index()) << 40;
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < kBurst; ++i) queue->push(makeTask(seq++));
+        for (uint64_t i = 0; i < kBurst; ++i) {
+            benchmark::DoNotOptimize(queue->pop());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst);
+
+    if (state.thread_index() == 0) {
+        while (queue->pop()) {}
+    }
+}
+
+void BatchPush(benchmark::State& state)
+{
+    TaskQueue queue;
+    std::vector<Task> batch;
+    uint64_t seq = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        batch.clear();
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            batch.push_back(makeTask(seq++));
+        }
+        state.ResumeTiming();
+        queue.pushBatch(batch);
+        state.PauseTiming();
+        while (queue.pop()) {}
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK_TEMPLATE(PushPopAtDepth, TaskQueue)->RangeMultiplier(16)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(PushPopAtDepth, MultiQueue)->RangeMultiplier(16)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(MultiProducerPushPop, TaskQueue)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(MultiProducerPushPop, MultiQueue)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BatchPush)->RangeMultiplier(8)->Range(8, 4096);
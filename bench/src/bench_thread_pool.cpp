@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+#include "detail/thread_pool_impl.h"
+#include "detail/work_stealing_thread_pool_impl.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+using namespace scheduler::detail;
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+// Jobs per second through a pool of range(0) workers, fed by one thread
+template <typename Pool>
+void SubmitThroughput(benchmark::State& state)
+{
+    constexpr int kJobs = 1000;
+    Pool pool(static_cast<size_t>(state.range(0)));
+    pool.start();
+    std::atomic<int> done{0};
+
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < kJobs; ++i) {
+            pool.submit([&done] {
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (done.load(std::memory_order_acquire) < kJobs) {}
+    }
+    pool.stop();
+    state.SetItemsProcessed(state.iterations() * kJobs);
+}
+
+// Time from submit() until the job starts running on an idle pool, with the
+// latency optimized (0) or the CPU frugal (1) idle policy
+template <typename Pool>
+void SubmitToStartLatency(benchmark::State& state)
+{
+    Pool pool(2, state.range(0) == 0 ? IdlePolicy::latencyOptimized()
+                                     : IdlePolicy::cpuFrugal());
+    pool.start();
+    std::atomic<int64_t> started{0};
+
+    for (auto _ : state) {
+        started.store(0, std::memory_order_relaxed);
+        auto submitted = clock_type::now();
+        pool.submit([&started] {
+            started.store(clock_type::now().time_since_epoch().count(),
+                          std::memory_order_release);
+        });
+        int64_t at;
+        while ((at = started.load(std::memory_order_acquire)) == 0) {}
+        state.SetIterationTime(std::chrono::duration<double>(
+            clock_type::time_point(clock_type::duration(at)) - submitted)
+                                   .count());
+    }
+    pool.stop();
+}
+
+// Several submitting threads contending on one pool
+template <typename Pool>
+void ContendedSubmit(benchmark::State& state)
+{
+    static std::unique_ptr<Pool> pool;
+    static std::atomic<int64_t> done{0};
+    if (state.thread_index() == 0) {
+        pool = std::make_unique<Pool>(4);
+        pool->start();
+        done.store(0);
+    }
+
+    int64_t submitted = 0;
+    for (auto _ : state) {
+        pool->submit([] { done.fetch_add(1, std::memory_order_relaxed); });
+        ++submitted;
+    }
+    state.SetItemsProcessed(submitted);
+
+    if (state.thread_index() == 0) {
+        // stop() drains whatever is still queued
+        pool->stop();
+        pool.reset();
+    }
+}
+}
+
+BENCHMARK_TEMPLATE(SubmitThroughput, ThreadPool)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(SubmitThroughput, WorkStealingThreadPool)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(SubmitToStartLatency, ThreadPool)->Arg(0)->Arg(1)->UseManualTime();
+BENCHMARK_TEMPLATE(SubmitToStartLatency, WorkStealingThreadPool)->Arg(0)->Arg(1)->UseManualTime();
+BENCHMARK_TEMPLATE(ContendedSubmit, ThreadPool)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(ContendedSubmit, WorkStealingThreadPool)->ThreadRange(1, 16)->UseRealTime();
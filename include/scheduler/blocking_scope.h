@@ -0,0 +1,36 @@
+#pragma once
+
+namespace scheduler {
+
+namespace detail {
+    class IBlockingObserver;
+}
+
+/**
+ * Marks part of a task body as potentially blocking, e.g. synchronous I/O.
+ *
+ *     void readConfig() {
+ *         scheduler::BlockingScope blocking;
+ *         std::ifstream file{path};
+ *         ...
+ *     }
+ *
+ * While a worker is inside a scope, its pool counts it as blocked. If
+ * runnable jobs are waiting, the pool wakes an idle worker or starts a
+ * compensating one, up to a cap, so CPU-bound work keeps every core busy.
+ * Compensating workers retire once the blocked ones are done. Nested
+ * scopes on one thread count once. On a thread that is not a pool worker,
+ * or on a pool without compensation, a scope does nothing.
+ */
+class BlockingScope {
+public:
+    BlockingScope() noexcept;
+    ~BlockingScope();
+    BlockingScope(BlockingScope const&) = delete;
+    BlockingScope& operator=(BlockingScope const&) = delete;
+
+private:
+    detail::IBlockingObserver* observer_;
+};
+
+} // namespace scheduler
@@ -0,0 +1,66 @@
+#pragma once
+#include "scheduler/inplace_task.h"
+#include <chrono>
+#include <coroutine>
+#include <optional>
+
+namespace scheduler {
+
+class Scheduler;
+
+/**
+ * Return type of a fire-and-forget scheduler coroutine.
+ *
+ * The coroutine starts right away on the calling thread and runs until its
+ * first co_await on one of the Scheduler awaitables; from then on every
+ * step runs on a pool worker. Frames come from the task storage pool.
+ * Exceptions that escape the body end the coroutine, like they end a
+ * plain task.
+ */
+struct CoTask {
+    struct promise_type {
+        CoTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+
+        static void* operator new(std::size_t size) {
+            return detail::allocateTaskStorage(size);
+        }
+        static void operator delete(void* frame, std::size_t size) noexcept {
+            detail::deallocateTaskStorage(frame, size);
+        }
+    };
+};
+
+/**
+ * Awaitable returned by Scheduler::yield, sleepUntil and atDeadline.
+ *
+ * Suspending hands the coroutine back to the scheduler as a task with the
+ * given priority and deadline, queued right away or, with a wake up time,
+ * once the timer fires; no thread is held while it waits. A coroutine that
+ * is still waiting when its scheduler is destroyed is destroyed without
+ * being resumed.
+ */
+class ScheduleAwaiter {
+public:
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+
+private:
+    friend class Scheduler;
+    ScheduleAwaiter(Scheduler& sched, int priority,
+        std::optional<std::chrono::steady_clock::time_point> deadline,
+        std::optional<std::chrono::steady_clock::time_point> wake_at) noexcept
+    : sched_{sched}, priority_{priority}, deadline_{deadline},
+      wake_at_{wake_at} {}
+
+    Scheduler& sched_;
+    int priority_;
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
+    std::optional<std::chrono::steady_clock::time_point> wake_at_;
+};
+
+} // namespace scheduler
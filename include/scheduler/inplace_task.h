@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifndef SCHEDULER_TASK_BUFFER_SIZE
+#define SCHEDULER_TASK_BUFFER_SIZE 64
+#endif
+
+namespace scheduler {
+
+namespace detail {
+    // Size-classed block pool backing callables too large for the inline
+    // buffer. Blocks are recycled through per-thread caches, so steady-state
+    // scheduling does not reach the global allocator.
+    void* allocateTaskStorage(std::size_t size);
+    void deallocateTaskStorage(void* block, std::size_t size) noexcept;
+}
+
+/**
+ * Move-only `void()` callable with `Capacity` bytes of inline storage.
+ *
+ * Callables that fit the buffer and are nothrow-movable are stored in place;
+ * anything else lives in a block taken from the task storage pool. Unlike
+ * std::function the wrapped callable does not need to be copyable.
+ */
+template <std::size_t Capacity>
+class BasicInplaceTask {
+    static_assert(Capacity >= sizeof(void*),
+                  "the inline buffer must at least hold a pointer");
+public:
+    static constexpr std::size_t capacity = Capacity;
+
+    BasicInplaceTask() noexcept = default;
+    BasicInplaceTask(std::nullptr_t) noexcept {}
+
+    template <typename F,
+              typename = std::enable_if_t<
+                  !std::is_same_v<std::decay_t<F>, BasicInplaceTask> &&
+                  std::is_invocable_r_v<void, std::decay_t<F>&>>>
+    BasicInplaceTask(F&& f) {
+        using Fn = std::decay_t<F>;
+        static_assert(alignof(Fn) <= alignof(std::max_align_t),
+                      "over-aligned callables are not supported");
+        if constexpr (fitsInline<Fn>()) {
+            ::new (static_cast<void*>(buffer_)) Fn(std::forward<F>(f));
+            vtable_ = &inlineVTable<Fn>;
+        } else {
+            void* block = detail::allocateTaskStorage(sizeof(Fn));
+            try {
+                ::new (block) Fn(std::forward<F>(f));
+            } catch (...) {
+                detail::deallocateTaskStorage(block, sizeof(Fn));
+                throw;
+            }
+            ::new (static_cast<void*>(buffer_)) void*(block);
+            vtable_ = &pooledVTable<Fn>;
+        }
+    }
+
+    BasicInplaceTask(BasicInplaceTask&& other) noexcept
+      : vtable_{other.vtable_} {
+        if (vtable_) {
+            vtable_->move(buffer_, other.buffer_);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    BasicInplaceTask& operator=(BasicInplaceTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            vtable_ = other.vtable_;
+            if (vtable_) {
+                vtable_->move(buffer_, other.buffer_);
+                other.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    BasicInplaceTask(BasicInplaceTask const&) = delete;
+    BasicInplaceTask& operator=(BasicInplaceTask const&) = delete;
+
+    ~BasicInplaceTask() { reset(); }
+
+    void operator()() {
+        if (!vtable_) throw std::bad_function_call{};
+        vtable_->invoke(buffer_);
+    }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    // true if the callable lives in the inline buffer
+    bool isInline() const noexcept { return vtable_ && !vtable_->pooled; }
+    // bytes of the pool block holding the callable, 0 if it is inline
+    std::size_t pooledSize() const noexcept {
+        return vtable_ ? vtable_->pooled : 0;
+    }
+
+    void reset() noexcept {
+        if (vtable_) {
+            vtable_->destroy(buffer_);
+            vtable_ = nullptr;
+        }
+    }
+
+private:
+    struct VTable {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+        std::size_t pooled;  // size of the pooled callable, 0 if inline
+    };
+
+    template <typename Fn>
+    static constexpr bool fitsInline() {
+        return sizeof(Fn) <= Capacity &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static Fn* pooledTarget(void* storage) noexcept {
+        return static_cast<Fn*>(*static_cast<void**>(storage));
+    }
+
+    template <typename Fn>
+    static constexpr VTable inlineVTable{
+        [](void* s) { (*std::launder(static_cast<Fn*>(s)))(); },
+        [](void* dst, void* src) noexcept {
+            Fn* from = std::launder(static_cast<Fn*>(src));
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        },
+        [](void* s) noexcept { std::launder(static_cast<Fn*>(s))->~Fn(); },
+        0};
+
+    template <typename Fn>
+    static constexpr VTable pooledVTable{
+        [](void* s) { (*pooledTarget<Fn>(s))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) void*(*static_cast<void**>(src));
+        },
+        [](void* s) noexcept {
+            Fn* target = pooledTarget<Fn>(s);
+            target->~Fn();
+            detail::deallocateTaskStorage(target, sizeof(Fn));
+        },
+        sizeof(Fn)};
+
+    alignas(std::max_align_t) unsigned char buffer_[Capacity];
+    VTable const* vtable_ = nullptr;
+};
+
+// The callable type used from Scheduler::schedule down to the worker.
+using InplaceTask = BasicInplaceTask<SCHEDULER_TASK_BUFFER_SIZE>;
+
+namespace detail {
+// A pool job carries the user's task plus the scheduler's bookkeeping
+// around it, so it gets a larger inline buffer than InplaceTask.
+using Job = BasicInplaceTask<SCHEDULER_TASK_BUFFER_SIZE + 64>;
+}
+
+} // namespace scheduler
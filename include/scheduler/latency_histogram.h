@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace scheduler {
+
+/**
+ * Log-linear (HDR-style) latency histogram, values in microseconds.
+ *
+ * Values below 2^kSubBucketBits get a bucket each. Every power-of-two range
+ * above that is split into 2^(kSubBucketBits - 1) equal buckets, so a
+ * reported value is never more than 1/64 away from the recorded one. Values
+ * of 2^kMaxValueBits and above are counted in the last bucket, negative
+ * values in the first.
+ *
+ * min(), max() and valueAtPercentile() report bucket bounds: the lowest
+ * equivalent value for min() and the highest for the others.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr int kMaxValueBits = 36;  // ~19 hours
+    static constexpr std::size_t kBucketCount =
+        std::size_t(kMaxValueBits - kSubBucketBits + 2)
+        << (kSubBucketBits - 1);
+
+    static std::size_t bucketIndex(std::int64_t value) noexcept;
+    static std::int64_t bucketLowest(std::size_t bucket) noexcept;
+    static std::int64_t bucketHighest(std::size_t bucket) noexcept;
+
+    LatencyHistogram();
+    // builds a histogram from per-bucket counts and the sum of the values
+    LatencyHistogram(std::vector<std::uint64_t> counts, std::int64_t sum);
+
+    void record(std::int64_t value);
+    void merge(LatencyHistogram const& other);
+
+    std::uint64_t count() const noexcept { return total_; }
+    std::uint64_t countAt(std::size_t bucket) const noexcept;
+    // 0 for an empty histogram
+    std::int64_t min() const noexcept;
+    std::int64_t max() const noexcept;
+    double mean() const noexcept;
+    // smallest value that `percentile` percent of the samples are at or
+    // below, `percentile` in [0, 100]; 0 for an empty histogram
+    std::int64_t valueAtPercentile(double percentile) const noexcept;
+
+private:
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t total_ = 0;
+    std::int64_t sum_ = 0;
+};
+
+} // namespace scheduler
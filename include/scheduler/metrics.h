@@ -0,0 +1,88 @@
+#pragma once
+#include "scheduler/latency_histogram.h"
+#include "scheduler/scheduler_options.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace scheduler {
+
+/**
+ * Point-in-time view of a scheduler, see Scheduler::getMetrics().
+ *
+ * Counters only go up over the scheduler's life. Gauges are sampled when
+ * the snapshot is taken, and the histograms cover the interval since
+ * their last reset.
+ */
+struct MetricsSnapshot {
+    // counters
+    uint64_t submitted = 0;    // tasks queued by callers, graphs, coroutines
+    uint64_t timer_fires = 0;  // recurring and sleepUntil() fires queued
+    uint64_t dispatched = 0;   // handed to the worker pool
+    uint64_t completed = 0;
+    uint64_t rejected = 0;     // refused by the pool
+    uint64_t refused = 0;      // not queued for QueueLimits
+    uint64_t cancelled = 0;    // dropped by the dispatcher after a cancel
+    uint64_t dispatcher_wakeups = 0;
+    std::chrono::nanoseconds busy_time{0};  // summed over the workers
+    std::chrono::nanoseconds parked_time{0};  // idle workers asleep, summed
+    uint64_t worker_wakeups = 0;  // parked workers woken for new work
+    DeadlineCounts deadlines;
+
+    // gauges
+    size_t queue_depth = 0;
+    size_t queue_bytes = 0;    // as counted by QueueLimits, else 0
+    size_t in_flight = 0;      // dispatched but not yet finished
+    WorkerCounts workers;
+    std::chrono::nanoseconds uptime{0};
+
+    LatencyHistogram latency;
+    LatencyHistogram timer_jitter;
+};
+
+// Renders the snapshot in the Prometheus text exposition format, with every
+// metric name starting with `prefix` and an underscore
+std::string toPrometheusText(MetricsSnapshot const& snapshot,
+                             std::string_view prefix = "scheduler");
+
+// Replaces `path` with the rendered snapshot through a rename, so that a
+// textfile collector never reads half a file. false if it failed.
+bool writePrometheusFile(MetricsSnapshot const& snapshot,
+                         std::string const& path,
+                         std::string_view prefix = "scheduler");
+
+/**
+ * Serves the metrics on a UNIX domain socket.
+ *
+ * Every connection gets one plain HTTP/1.0 response with the current
+ * snapshot from `source` and is closed, so both a scraper speaking HTTP
+ * and a plain `nc -U` can read it. The socket file is replaced on start and
+ * removed on destruction. Throws std::system_error if the socket cannot be
+ * set up.
+ */
+class MetricsServer {
+public:
+    MetricsServer(std::string socket_path,
+                  std::function<MetricsSnapshot()> source,
+                  std::string prefix = "scheduler");
+    ~MetricsServer();
+
+    MetricsServer(MetricsServer const&) = delete;
+    MetricsServer& operator=(MetricsServer const&) = delete;
+
+private:
+    void serve();
+
+    std::string path_;
+    std::function<MetricsSnapshot()> source_;
+    std::string prefix_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+} // namespace scheduler
@@ -1,51 +1,252 @@
 #pragma once
-#include <functional>
+#include "scheduler/blocking_scope.h"
+#include "scheduler/coroutine.h"
+#include "scheduler/inplace_task.h"
+#include "scheduler/latency_histogram.h"
+#include "scheduler/metrics.h"
+#include "scheduler/scheduler_options.h"
+#include "scheduler/task_graph.h"
+#include "scheduler/task_handle.h"
+#include "scheduler/worker_placement.h"
+#include <string>
 #include <tuple>
+#include <span>
+#include <vector>
 #include <optional>
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <coroutine>
 
 namespace scheduler {
 
 namespace detail {
     class IClock;
+    class BoundedQueue;
+    class DeadlineMonitor;
+    class GroupQueue;
+    class MetricsRecorder;
+    class QueueBudget;
     class ITaskQueue;
     class IThreadPool;
+    class IStatisticsCalculator;
+    class TimingWheel;
+    class TimerThread;
+    class Tracer;
+    struct Task;
+    struct GraphState;
 }
 
+// One entry of Scheduler::scheduleBatch
+struct BatchTask {
+    InplaceTask task;
+    int priority = 0;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    int node = kAnyNode;
+    size_t group = 0;
+};
+
 class Scheduler {
 public:
     // Constructor/Destructor
     explicit Scheduler(size_t numThreads =
                        std::thread::hardware_concurrency());
+    // Places the workers as described by `placement`
+    Scheduler(size_t numThreads, WorkerPlacement placement);
+    explicit Scheduler(SchedulerOptions options);
     ~Scheduler(); // joins and cleans up threads
 
     // Scheduling tasks
     // Schedules a task with a specific priority
     // and an optional deadline
     // (e.g., a time_point from std::chrono).
-    void schedule(std::function<void()> task, int priority,
+    // The handle can cancel or re-key the task until it is dispatched.
+    // `node` asks for a worker on that NUMA node, see WorkerPlacement.
+    // `group` is an index into SchedulerOptions::groups; throws
+    // std::out_of_range if there is no such group.
+    // When QueueLimits refuse the task the handle is empty, see
+    // QueueLimits::on_reject.
+    TaskHandle schedule(InplaceTask task, int priority,
+      std::optional<std::chrono::steady_clock::time_point> deadline =
+                                                       std::nullopt,
+      int node = kAnyNode, size_t group = 0);
+
+    // Like schedule(), but returns nothing if QueueLimits refuse the task,
+    // in which case `task` is left as it was
+    std::optional<TaskHandle> trySchedule(InplaceTask&& task, int priority,
+      std::optional<std::chrono::steady_clock::time_point> deadline =
+                                                       std::nullopt,
+      int node = kAnyNode, size_t group = 0);
+    // Like trySchedule(), but waits up to `timeout` for room, polling with
+    // a backoff from 10us up to 1ms
+    std::optional<TaskHandle> tryScheduleFor(std::chrono::microseconds timeout,
+      InplaceTask&& task, int priority,
       std::optional<std::chrono::steady_clock::time_point> deadline =
-                                                       std::nullopt);
+                                                       std::nullopt,
+      int node = kAnyNode, size_t group = 0);
+
+    // Schedules many tasks at once: the queue lock of every lane is taken
+    // once and the dispatcher woken once for the whole batch. The callables are moved
+    // out of `tasks`. Batched tasks get no handles. Throws
+    // std::out_of_range, queueing none of them, if a group does not exist.
+    // Tasks that QueueLimits refuse go to QueueLimits::on_reject.
+    void scheduleBatch(std::span<BatchTask> tasks);
+
+    // Runs every task of the graph once its predecessors have finished.
+    // The future is ready when all of them are done, and carries the first
+    // exception a task threw; after one, the remaining tasks are skipped.
+    // Throws std::invalid_argument if the graph has a cycle.
+    std::future<void> submit(TaskGraph graph);
 
     // Allow tasks that run repeatedly on an interval
-    void scheduleRecurring(std::function<void()> task, int priority,
-                           std::chrono::milliseconds interval);
+    // The first run happens one interval from now; a non-positive interval
+    // schedules a single run. Cancelling the handle stops further runs.
+    // See RecurringOptions for slack and drift.
+    TaskHandle scheduleRecurring(InplaceTask task, int priority,
+                           std::chrono::milliseconds interval,
+                           RecurringOptions options = {});
+
+    // Coroutine front-end, for use inside a CoTask coroutine:
+    //   co_await sched.yield(priority);
+    // Resumes the coroutine as a task with the given priority
+    ScheduleAwaiter yield(int priority = 0);
+    // Resumes it once `wake_at` has passed; no worker is held meanwhile
+    ScheduleAwaiter sleepUntil(std::chrono::steady_clock::time_point wake_at,
+                               int priority = 0);
+    // Resumes it as a task ordered by the given deadline
+    ScheduleAwaiter atDeadline(std::chrono::steady_clock::time_point deadline,
+                               int priority = 0);
 
     // Performance metrics
-    // Returns average, min, max latency so far
+    // Returns average, min, max latency so far, in microseconds from
+    // enqueue (or timer fire) to the start of execution
     std::tuple<double, double, double> getLatencyStatistics() const;
 
+    // Latency in microseconds at the given percentile (e.g. 99.9) of the
+    // tasks started since the last resetLatencyHistogram()
+    double getLatencyPercentile(double percentile) const;
+    // Latency distribution since the last resetLatencyHistogram()
+    LatencyHistogram getLatencyHistogram() const;
+    // Returns the distribution of the interval that ends now and starts a
+    // new one
+    LatencyHistogram resetLatencyHistogram();
+
+    // How many microseconds after their due time timers were moved into the
+    // queue, for recurring tasks and sleepUntil(), since the last reset.
+    // Timers are due on whole milliseconds, never before their time.
+    LatencyHistogram getTimerJitterHistogram() const;
+    LatencyHistogram resetTimerJitterHistogram();
+
+    // Worker pool size and how often it grew or shrank, see ElasticThreads
+    WorkerCounts getWorkerCounts() const;
+
+    // true from when the queues filled up to the high watermark until
+    // they drained to the low one, see QueueLimits; false without limits
+    bool underPressure() const noexcept;
+
+    // Counters, gauges and histograms in one go, see MetricsSnapshot
+    MetricsSnapshot getMetrics() const;
+
+    // Writes the tasks recorded so far as Chrome trace event JSON, see
+    // TraceOptions. False if tracing is off or the file could not be
+    // written.
+    bool writeTrace(std::string const& path) const;
+
+    // How the tasks with a deadline fared, see DeadlinePolicy
+    DeadlineCounts getDeadlineCounts() const;
+
+    // Task groups, see TaskGroup; there is one group without them
+    size_t groupCount() const noexcept;
+    GroupStats getGroupStats(size_t group) const;
+    LatencyHistogram resetGroupLatencyHistogram(size_t group);
+
+    // Priority lanes, see PriorityLane; there is one lane without them
+    size_t laneCount() const noexcept;
+    // lane that takes tasks of `priority`, 0 being the highest lane
+    size_t laneOf(int priority) const noexcept;
+    // latency distribution of one lane since its last reset
+    LatencyHistogram getLaneLatencyHistogram(size_t lane) const;
+    LatencyHistogram resetLaneLatencyHistogram(size_t lane);
+
 private:
     // Implementation details
     Scheduler(std::shared_ptr<detail::IClock> clock,
         std::shared_ptr<detail::ITaskQueue> queue,
         std::shared_ptr<detail::IThreadPool> thread_pool);
 
+    friend class ScheduleAwaiter;
+    void resumeLater(std::coroutine_handle<> handle, int priority,
+        std::optional<std::chrono::steady_clock::time_point> deadline,
+        std::optional<std::chrono::steady_clock::time_point> wake_at);
+
+    void runGraphNode(std::shared_ptr<detail::GraphState> const& graph,
+                      size_t node);
+    void queueGraphNodes(std::shared_ptr<detail::GraphState> const& graph,
+                         std::span<size_t const> nodes);
+
+    std::optional<TaskHandle> enqueue(InplaceTask& task, int priority,
+        std::optional<std::chrono::steady_clock::time_point> deadline,
+        int node, size_t group);
+    void refuse(InplaceTask&& task, int priority,
+        std::optional<std::chrono::steady_clock::time_point> deadline);
+
+    void start();
+    void dispatchLoop();
+    void dispatch(std::vector<detail::Task>& batch, size_t lane);
+    void onTaskFinished(size_t lane);
+    void shed(std::vector<detail::Task>& late);
+    void wakeDispatcher();
+
+    // Every lane has its own queue, latency statistics and dispatch limit.
+    // `data` routes pushes to the lanes; without lanes it is lanes[0].queue
+    // and lanes[0].stats is `stats`. With QueueLimits, `bounded` is the
+    // lane's queue, counting against `budget`.
+    struct Lane {
+        std::shared_ptr<detail::ITaskQueue> queue;
+        std::shared_ptr<detail::BoundedQueue> bounded;
+        std::shared_ptr<detail::IStatisticsCalculator> stats;
+        size_t in_flight = 0;
+        size_t capacity = 1;
+    };
+    std::vector<Lane> lanes;
+    std::vector<int> lane_floors;  // minimum priority of every lane
+
+    // `data` when there are task groups, null otherwise
+    std::shared_ptr<detail::GroupQueue> groups;
+    // latency of every group; without groups it is `stats`
+    std::vector<std::shared_ptr<detail::IStatisticsCalculator>> group_stats;
+
     std::shared_ptr<detail::ITaskQueue> data;
     std::shared_ptr<detail::IThreadPool> thread_pool;
+    // `clock` drives the timers, the others are chosen by ClockOptions
     std::shared_ptr<detail::IClock> clock;
+    std::shared_ptr<detail::IClock> enqueue_clock;
+    std::shared_ptr<detail::IClock> deadline_clock;
+    std::shared_ptr<detail::IClock> latency_clock;
+    std::shared_ptr<detail::IStatisticsCalculator> stats;
+    std::shared_ptr<detail::TimingWheel> timers;
+    std::shared_ptr<detail::TimerThread> timer_thread;
+    std::shared_ptr<detail::DeadlineMonitor> deadlines;
+    std::shared_ptr<detail::MetricsRecorder> metrics;
+    std::shared_ptr<detail::QueueBudget> budget;  // null without limits
+    std::shared_ptr<detail::Tracer> tracer;  // null unless tracing
+    std::string trace_path;
+    std::chrono::steady_clock::time_point started_at;
+
+    // Dispatcher: moves the best queued tasks of every lane into the pool,
+    // keeping at most one task per worker that may run it in flight so that
+    // queue order is what decides which task runs next.
+    std::atomic<uint64_t> sequence{0};
+    std::thread dispatcher;
+    std::vector<detail::Job> jobs;  // dispatch()'s buffer, kept between batches
+    mutable std::mutex dispatch_mutex;
+    std::condition_variable dispatch_cv;
+    bool running = false;
+    bool wakeup = false;
 };
 
-}; // namespace Scheduler
\ No newline at end of file
+}; // namespace Scheduler
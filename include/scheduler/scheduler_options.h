@@ -0,0 +1,278 @@
+#pragma once
+#include "scheduler/inplace_task.h"
+#include "scheduler/latency_histogram.h"
+#include "scheduler/worker_placement.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace scheduler {
+
+/**
+ * A band of priorities with its own queue and workers.
+ *
+ * A lane takes every priority from `min_priority` up to the next higher
+ * lane's minimum. Its reserved workers serve it first. When the lane is
+ * empty they may borrow from lower lanes, unless `borrow` is off. Keep
+ * `borrow` off when work in the lower lanes is long, or a new task for
+ * this lane may wait for a borrowed job to finish. Workers that are not
+ * reserved serve all lanes, highest first.
+ *
+ * A task stays in the lane it was scheduled into, even if it is
+ * reprioritized later.
+ */
+struct PriorityLane {
+    int min_priority;
+    size_t reserved_workers = 0;
+    bool borrow = true;
+};
+
+/**
+ * Lets the worker pool grow and shrink between `min_threads` and
+ * `max_threads`.
+ *
+ * A worker is added when more than `grow_queue_depth` jobs wait for a
+ * worker, or a job waited longer than `grow_wait`, and no worker is idle.
+ * A worker retires after `idle_timeout` without work. Resizes are at
+ * least `cooldown` apart, which keeps the pool from flapping under a
+ * bursty load.
+ */
+struct ElasticThreads {
+    size_t min_threads = 1;
+    size_t max_threads = std::thread::hardware_concurrency();
+    size_t grow_queue_depth = 2;
+    std::chrono::microseconds grow_wait{500};
+    std::chrono::milliseconds idle_timeout{2000};
+    std::chrono::milliseconds cooldown{50};
+};
+
+// How a recurring task keeps to its interval
+enum class Cadence {
+    // fires are one interval apart however long the runs take
+    FixedRate,
+    // the next fire is one interval after the previous run returned
+    FixedDelay,
+};
+
+// What a fixed-rate task does about the fires it missed during a stall
+enum class MissedFires {
+    CatchUp,  // runs every one of them, back to back
+    Skip,     // runs once and goes on with the fires still ahead
+};
+
+/**
+ * Options of Scheduler::scheduleRecurring.
+ *
+ * With a `slack`, a fire may be up to that much late. Fires are then moved
+ * to the next multiple of the largest power of two milliseconds within the
+ * slack, so timers with similar slack share a wakeup instead of firing one
+ * by one.
+ */
+struct RecurringOptions {
+    std::chrono::milliseconds slack{0};
+    Cadence cadence = Cadence::FixedRate;
+    MissedFires missed = MissedFires::CatchUp;
+};
+
+// Current pool size and the resize events so far
+struct WorkerCounts {
+    size_t live = 0;
+    uint64_t grown = 0;
+    uint64_t retired = 0;
+    // workers started to stand in for ones inside a BlockingScope
+    uint64_t compensating = 0;
+};
+
+// What happens to a task that can no longer meet its deadline
+enum class DeadlineAction {
+    Drop,    // destroyed without running
+    Divert,  // handed to DeadlinePolicy::divert
+    Demote,  // requeued without its deadline
+};
+
+// A task the scheduler gave up on, as passed to DeadlinePolicy::divert
+struct ShedTask {
+    InplaceTask task;
+    int priority;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+/**
+ * Sheds tasks whose deadline is out of reach when they are dequeued.
+ *
+ * A task is out of reach when now plus the expected run time of its
+ * priority class is past its deadline. Run times are learned per
+ * priority from the tasks with a deadline that ran, starting from
+ * `initial_estimate`; with the default of zero only tasks that are late
+ * already are shed. Tasks without a deadline are never shed.
+ *
+ * `divert` runs on the dispatcher thread and holds up all dispatching
+ * while it runs, so it should only hand the task on. A shed task's handle
+ * behaves as if the task had been dispatched; a demoted task is queued
+ * again and its handle can still cancel or re-key it.
+ */
+struct DeadlinePolicy {
+    DeadlineAction action = DeadlineAction::Drop;
+    std::function<void(ShedTask&&)> divert;
+    // the priority a demoted task is requeued with
+    int demoted_priority = std::numeric_limits<int>::min();
+    std::chrono::microseconds initial_estimate{0};
+};
+
+// Outcome of the tasks scheduled with a deadline
+struct DeadlineCounts {
+    uint64_t met = 0;
+    uint64_t missed = 0;
+    // dropped or diverted by a DeadlinePolicy
+    uint64_t shed = 0;
+    uint64_t demoted = 0;
+};
+
+// CPU time a task group may use per period
+struct CpuQuota {
+    std::chrono::microseconds budget;
+    std::chrono::milliseconds period{100};
+};
+
+/**
+ * A tenant's share of the workers, see SchedulerOptions::groups.
+ *
+ * Groups take turns by weighted fair queueing: every group has a virtual
+ * time that a dispatched task advances by the group's average run time
+ * divided by its weight, and the group with the earliest virtual time goes
+ * next. Busy groups therefore get worker time in proportion to their
+ * weights, however many tasks or whatever priorities they queue. A group
+ * that was idle starts at the current virtual time and gets no credit for
+ * the time it was idle. Within a group, tasks keep the deadline, priority
+ * and FIFO order of a single queue.
+ *
+ * A group with a `quota` is held back once its tasks ran for `budget`
+ * within a `period` until the period is over. Running tasks are not
+ * interrupted, so a long task may overshoot; the overshoot is taken out of
+ * the next period.
+ */
+struct TaskGroup {
+    std::string name;
+    uint32_t weight = 1;
+    std::optional<CpuQuota> quota;
+};
+
+// What a task group got so far
+struct GroupStats {
+    uint64_t completed = 0;
+    std::chrono::nanoseconds busy_time{0};
+    // how often the group ran out of its CpuQuota
+    uint64_t throttled = 0;
+    size_t queued = 0;
+    // since the last Scheduler::resetGroupLatencyHistogram
+    LatencyHistogram latency;
+};
+
+// A task refused by QueueLimits, as passed to QueueLimits::on_reject
+struct RejectedTask {
+    InplaceTask task;
+    int priority;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+};
+
+/**
+ * Caps on the tasks waiting in the scheduler's queues.
+ *
+ * A task counts with its size in the queue plus the pool block of a
+ * callable that does not fit inline; captured containers and other memory
+ * the callable owns are not seen. A zero cap is no cap.
+ *
+ * When a cap is reached, Scheduler::trySchedule fails, tryScheduleFor
+ * waits for room, and schedule() and scheduleBatch hand the task to
+ * `on_reject`, or drop it without one. Timer fires, coroutine resumptions
+ * and graph successors are always queued, though they count toward the
+ * caps.
+ *
+ * `on_pressure(true)` is called once the queues fill up to
+ * `high_watermark` of either cap, and `on_pressure(false)` once they
+ * drained to `low_watermark` of both, so producers can slow down before
+ * tasks get refused. Both callbacks run on the thread that queued or
+ * dispatched the task that crossed the line, and must not schedule tasks.
+ */
+struct QueueLimits {
+    size_t max_tasks = 0;
+    size_t max_bytes = 0;
+    double high_watermark = 0.8;
+    double low_watermark = 0.5;
+    std::function<void(RejectedTask&&)> on_reject;
+    std::function<void(bool)> on_pressure;
+};
+
+// Where the scheduler takes a timestamp from
+enum class ClockSource {
+    Steady,  // std::chrono::steady_clock
+    // the CPU's invariant time stamp counter, steady_clock where there is none
+    Tsc,
+    // a time a ticker thread refreshes every coarse_resolution
+    Coarse,
+};
+
+// Clock per use of a timestamp. All sources share steady_clock's timeline,
+// so they can be mixed; timers always run on steady_clock.
+struct ClockOptions {
+    // stamped on a task when it is queued, where its latency starts
+    ClockSource enqueue = ClockSource::Steady;
+    // checked against deadlines, see DeadlinePolicy and DeadlineCounts
+    ClockSource deadline = ClockSource::Steady;
+    // read when a task starts, where its latency ends
+    ClockSource latency = ClockSource::Steady;
+    std::chrono::microseconds coarse_resolution{1000};
+};
+
+/**
+ * Records when every task was queued, dispatched, started and ended, for
+ * Scheduler::writeTrace. Traces are Chrome trace event JSON, which
+ * Perfetto (ui.perfetto.dev) and chrome://tracing open.
+ *
+ * Every thread keeps its latest `events_per_thread` events, rounded up to
+ * a power of two; a task takes one event on the dispatcher and one on its
+ * worker. Without the SCHEDULER_TRACING build option nothing is recorded.
+ */
+struct TraceOptions {
+    size_t events_per_thread = size_t{1} << 16;
+    // written when the scheduler is destroyed, unless empty
+    std::string path;
+};
+
+struct SchedulerOptions {
+    // the starting size when `elastic` is set
+    size_t threads = std::thread::hardware_concurrency();
+    WorkerPlacement placement;
+    // Empty means one queue for all priorities. Priorities below the
+    // lowest lane's minimum go to that lane. At least one worker is always
+    // left unreserved. Lanes keep one queue each rather than one per NUMA
+    // node, so `placement.numa` is turned off and per-task node hints are
+    // ignored; `cpus` and `pin` still apply.
+    std::vector<PriorityLane> lanes;
+    // not supported together with lanes, which need a fixed pool; the
+    // constructor throws std::invalid_argument for the combination
+    std::optional<ElasticThreads> elastic;
+    // Extra workers started while others sit in a BlockingScope; defaults
+    // to `threads`, 0 turns compensation off. Lanes never compensate, and
+    // the constructor throws std::invalid_argument for a nonzero value.
+    std::optional<size_t> max_compensating_threads;
+    // unset runs every task however late it is
+    std::optional<DeadlinePolicy> deadlines;
+    ClockOptions clocks;
+    // Tenants sharing the workers fairly; tasks name theirs by index, and
+    // tasks that do not, like timer fires, go to the first one. Empty is a
+    // single group. Not supported together with lanes.
+    std::vector<TaskGroup> groups;
+    // unset queues without limits
+    std::optional<QueueLimits> limits;
+    // unset records no trace
+    std::optional<TraceOptions> tracing;
+};
+
+} // namespace scheduler
@@ -0,0 +1,53 @@
+#pragma once
+#include "scheduler/inplace_task.h"
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace scheduler {
+
+/**
+ * A DAG of tasks, handed to Scheduler::submit in one go.
+ *
+ *     TaskGraph graph;
+ *     auto load  = graph.add(loadInput);
+ *     auto left  = graph.add(processLeft, 5);
+ *     auto right = graph.add(processRight);
+ *     auto merge = graph.add(mergeResults);
+ *     graph.precede(load, {left, right});   // fan-out
+ *     graph.succeed(merge, {left, right});  // fan-in
+ *     sched.submit(std::move(graph)).get();
+ *
+ * Tasks without predecessors are queued with their priorities like any
+ * scheduled task. When a task finishes, every successor whose last
+ * predecessor it was becomes ready. The ready successor with the highest
+ * priority runs right away on the same worker, and the others are queued.
+ * A chain of tasks therefore runs on one worker without going back
+ * through the queue.
+ */
+class TaskGraph {
+public:
+    using Node = std::size_t;
+
+    Node add(InplaceTask task, int priority = 0);
+    // `after` starts once `before` has finished
+    void precede(Node before, Node after);
+    void precede(Node before, std::initializer_list<Node> after);
+    void succeed(Node after, std::initializer_list<Node> before);
+
+    std::size_t size() const noexcept { return entries_.size(); }
+    bool empty() const noexcept { return entries_.empty(); }
+
+private:
+    friend class Scheduler;
+
+    struct Entry {
+        InplaceTask task;
+        int priority;
+        std::vector<Node> successors;
+        std::size_t predecessors = 0;
+    };
+    std::vector<Entry> entries_;
+};
+
+} // namespace scheduler
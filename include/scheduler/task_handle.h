@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <optional>
+
+namespace scheduler {
+
+namespace detail {
+    struct TaskState;
+}
+
+/**
+ * Handle to a task returned by Scheduler::schedule and scheduleRecurring.
+ *
+ * A one-off task can be cancelled or re-keyed while it waits in the queue;
+ * once the dispatcher has taken it every call returns false. For a
+ * recurring task the calls apply to all fires that have not been queued
+ * yet, and cancel() also drops fires that are queued but not dispatched.
+ *
+ * Handles are cheap to copy and may outlive the scheduler, in which case
+ * every call returns false.
+ */
+class TaskHandle {
+public:
+    TaskHandle() = default;
+
+    // true if the task will not be dispatched (again)
+    bool cancel();
+    bool reprioritize(int priority);
+    bool changeDeadline(
+        std::optional<std::chrono::steady_clock::time_point> deadline);
+
+    // false for a default constructed handle
+    explicit operator bool() const noexcept { return state_ != nullptr; }
+
+private:
+    friend class Scheduler;
+    explicit TaskHandle(std::shared_ptr<detail::TaskState> state) noexcept;
+
+    std::shared_ptr<detail::TaskState> state_;
+};
+
+} // namespace scheduler
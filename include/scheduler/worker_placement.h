@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+namespace scheduler {
+
+// Locality hint that lets any worker run the task
+inline constexpr int kAnyNode = -1;
+
+/**
+ * Where the scheduler's workers run.
+ *
+ * By default the OS places the workers. `cpus` limits them to a set of
+ * CPUs, and `pin` binds each worker to a single one of those CPUs, handed
+ * out round robin. With `numa` set, the workers are spread over the NUMA
+ * nodes that own those CPUs, and every node gets its own queue. A task
+ * scheduled with a node hint goes to that node's queue. Workers only take
+ * work queued for another node once their own node has none left.
+ *
+ * Placement is best effort. CPUs the process may not run on are skipped,
+ * and hosts whose topology cannot be read count as a single node.
+ */
+struct WorkerPlacement {
+    std::vector<int> cpus;  // empty means every online CPU
+    bool pin = false;
+    bool numa = false;
+};
+
+} // namespace scheduler
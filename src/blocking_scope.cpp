@@ -0,0 +1,22 @@
+#include "scheduler/blocking_scope.h"
+#include "detail/thread_pool.h"
+
+using namespace scheduler;
+using namespace detail;
+
+namespace {
+thread_local IBlockingObserver* current_observer = nullptr;
+thread_local unsigned blocking_depth = 0;
+}
+
+IBlockingObserver*& IBlockingObserver::current() noexcept {
+    return current_observer;
+}
+
+BlockingScope::BlockingScope() noexcept : observer_{current_observer} {
+    if (observer_ && blocking_depth++ == 0) observer_->enterBlocking();
+}
+
+BlockingScope::~BlockingScope() {
+    if (observer_ && --blocking_depth == 0) observer_->leaveBlocking();
+}
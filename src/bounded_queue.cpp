@@ -0,0 +1,47 @@
+#include "detail/bounded_queue_impl.h"
+
+using namespace scheduler::detail;
+
+BoundedQueue::BoundedQueue(std::shared_ptr<ITaskQueue> inner,
+                           std::shared_ptr<QueueBudget> budget)
+: inner_{std::move(inner)}, budget_{std::move(budget)} {}
+
+bool BoundedQueue::tryPush(Task&& task) {
+    if (!budget_->tryAcquire(1, QueueBudget::footprint(task))) return false;
+    inner_->push(std::move(task));
+    return true;
+}
+
+size_t BoundedQueue::tryPushBatch(std::span<Task> tasks) {
+    size_t fits = 0;
+    for (Task const& task : tasks) {
+        if (!budget_->tryAcquire(1, QueueBudget::footprint(task))) break;
+        ++fits;
+    }
+    inner_->pushBatch(tasks.first(fits));
+    return fits;
+}
+
+void BoundedQueue::push(Task&& task) {
+    budget_->acquire(1, QueueBudget::footprint(task));
+    inner_->push(std::move(task));
+}
+
+void BoundedQueue::pushBatch(std::span<Task> tasks) {
+    size_t bytes = 0;
+    for (Task const& task : tasks) bytes += QueueBudget::footprint(task);
+    budget_->acquire(tasks.size(), bytes);
+    inner_->pushBatch(tasks);
+}
+
+std::optional<Task> BoundedQueue::pop() {
+    auto task = inner_->pop();
+    if (task) budget_->release(1, QueueBudget::footprint(*task));
+    return task;
+}
+
+std::optional<Task> BoundedQueue::erase(TaskState const& state) {
+    auto task = inner_->erase(state);
+    if (task) budget_->release(1, QueueBudget::footprint(*task));
+    return task;
+}
@@ -0,0 +1,29 @@
+#include "detail/coarse_clock_impl.h"
+#include <algorithm>
+
+using namespace scheduler::detail;
+
+CoarseClock::CoarseClock(std::chrono::microseconds resolution)
+: resolution_{std::max(resolution, std::chrono::microseconds{1})} {
+    tick();
+    ticker_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock{mutex_};
+        while (!cv_.wait_for(lock, resolution_, [this] { return stopping_; })) {
+            tick();
+        }
+    });
+}
+
+CoarseClock::~CoarseClock() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    ticker_.join();
+}
+
+void CoarseClock::tick() noexcept {
+    now_.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+               std::memory_order_relaxed);
+}
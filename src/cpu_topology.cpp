@@ -0,0 +1,151 @@
+#include "detail/cpu_topology.h"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace scheduler;
+using namespace scheduler::detail;
+
+namespace {
+bool parseInt(std::string_view text, int& value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(),
+                                     value);
+    return ec == std::errc{} && end == text.data() + text.size() && value >= 0;
+}
+
+std::vector<int> allCpus() {
+    std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t i = 0; i < cpus.size(); ++i) cpus[i] = static_cast<int>(i);
+    return cpus;
+}
+}
+
+std::vector<int> scheduler::detail::parseCpuList(std::string_view list) {
+    while (!list.empty() && (list.back() == '\n' || list.back() == ' ')) {
+        list.remove_suffix(1);
+    }
+
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        auto comma = list.find(',');
+        auto range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{}
+                                               : list.substr(comma + 1);
+
+        auto dash = range.find('-');
+        int first, last;
+        if (!parseInt(range.substr(0, dash), first)) return {};
+        if (dash == std::string_view::npos) {
+            last = first;
+        } else if (!parseInt(range.substr(dash + 1), last) || last < first) {
+            return {};
+        }
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::vector<NumaNode> scheduler::detail::detectNumaNodes() {
+    std::vector<NumaNode> nodes;
+#if defined(__linux__)
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for (auto const& entry :
+         fs::directory_iterator{"/sys/devices/system/node", ec}) {
+        auto name = entry.path().filename().string();
+        int id;
+        if (name.rfind("node", 0) != 0 ||
+            !parseInt(std::string_view{name}.substr(4), id)) {
+            continue;
+        }
+        std::ifstream file{entry.path() / "cpulist"};
+        std::string list;
+        std::getline(file, list);
+        auto cpus = parseCpuList(list);
+        // memory-only nodes have no CPUs to run workers on
+        if (!cpus.empty()) nodes.push_back({id, std::move(cpus)});
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](NumaNode const& a, NumaNode const& b) { return a.id < b.id; });
+#endif
+    if (nodes.empty()) nodes.push_back({0, allCpus()});
+    return nodes;
+}
+
+bool scheduler::detail::pinCurrentThread(std::vector<int> const& cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 &&
+           pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+size_t WorkerPlan::nodeIndex(int id, size_t fallback) const noexcept {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].id == id) return i;
+    }
+    return fallback;
+}
+
+WorkerPlan scheduler::detail::planWorkers(size_t num_threads,
+                                          WorkerPlacement const& placement,
+                                          std::vector<NumaNode> topology) {
+    WorkerPlan plan;
+    std::vector<int> allowed = placement.cpus;
+    std::sort(allowed.begin(), allowed.end());
+
+    for (NumaNode& node : topology) {
+        if (!allowed.empty()) {
+            std::erase_if(node.cpus, [&](int cpu) {
+                return !std::binary_search(allowed.begin(), allowed.end(), cpu);
+            });
+        }
+        if (!node.cpus.empty()) plan.nodes.push_back(std::move(node));
+    }
+    // none of the requested CPUs is known, trust the caller
+    if (plan.nodes.empty()) {
+        plan.nodes.push_back({0, allowed.empty() ? allCpus() : allowed});
+    }
+
+    if (!placement.numa) {
+        NumaNode merged{kAnyNode, {}};
+        for (NumaNode const& node : plan.nodes) {
+            merged.cpus.insert(merged.cpus.end(), node.cpus.begin(),
+                               node.cpus.end());
+        }
+        std::sort(merged.cpus.begin(), merged.cpus.end());
+        plan.nodes.assign(1, std::move(merged));
+    }
+
+    bool bound = placement.numa || !placement.cpus.empty();
+    size_t node_count = plan.nodes.size();
+    for (size_t i = 0; i < std::max<size_t>(num_threads, 1); ++i) {
+        size_t node = i % node_count;
+        auto const& cpus = plan.nodes[node].cpus;
+        WorkerPlan::Worker worker{node, {}};
+        if (placement.pin) {
+            worker.cpus = {cpus[(i / node_count) % cpus.size()]};
+        } else if (bound) {
+            worker.cpus = cpus;
+        }
+        plan.workers.push_back(std::move(worker));
+    }
+    return plan;
+}
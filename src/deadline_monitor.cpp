@@ -0,0 +1,52 @@
+#include "detail/deadline_monitor.h"
+#include <algorithm>
+
+using namespace scheduler;
+using namespace detail;
+
+DeadlineMonitor::DeadlineMonitor(std::optional<DeadlinePolicy> policy)
+: policy_{std::move(policy)} {
+    for (auto& estimate : estimates_) {
+        estimate.store(kNoSample, std::memory_order_relaxed);
+    }
+}
+
+std::atomic<int64_t>& DeadlineMonitor::bucket(int priority) const noexcept {
+    return estimates_[size_t(std::clamp(priority, kMinClass, kMaxClass) -
+                             kMinClass)];
+}
+
+std::chrono::nanoseconds DeadlineMonitor::estimate(int priority) const {
+    int64_t estimate = bucket(priority).load(std::memory_order_relaxed);
+    if (estimate != kNoSample) return std::chrono::nanoseconds{estimate};
+    return policy_ ? policy_->initial_estimate : std::chrono::nanoseconds{0};
+}
+
+bool DeadlineMonitor::reachable(int priority, time_point deadline,
+                                time_point now) const {
+    if (!policy_) return true;
+    return now + estimate(priority) <= deadline;
+}
+
+void DeadlineMonitor::finished(int priority, std::chrono::nanoseconds ran,
+                               time_point ended, time_point deadline) {
+    (ended <= deadline ? met_ : missed_)
+        .fetch_add(1, std::memory_order_relaxed);
+    if (!policy_) return;
+
+    int64_t sample = std::max<int64_t>(ran.count(), 0);
+    auto& estimate = bucket(priority);
+    int64_t current = estimate.load(std::memory_order_relaxed);
+    int64_t next;
+    do {
+        next = current == kNoSample ? sample : current + (sample - current) / 8;
+    } while (!estimate.compare_exchange_weak(current, next,
+                                             std::memory_order_relaxed));
+}
+
+DeadlineCounts DeadlineMonitor::counts() const noexcept {
+    return DeadlineCounts{met_.load(std::memory_order_relaxed),
+                          missed_.load(std::memory_order_relaxed),
+                          shed_.load(std::memory_order_relaxed),
+                          demoted_.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "queue_budget.h"
+#include "task_queue.h"
+#include "task.h"
+#include <memory>
+
+namespace scheduler::detail {
+
+/**
+ * Counts the tasks of another queue against a QueueBudget.
+ *
+ * push() and pushBatch() always go through, tryPush() and tryPushBatch()
+ * only as far as the budget has room. Whatever leaves through pop() or
+ * erase() gives its room back. Lanes each get their own BoundedQueue over
+ * one shared budget, so that handles, which talk to their lane's queue,
+ * are counted too.
+ */
+class BoundedQueue : public ITaskQueue {
+public:
+    BoundedQueue(std::shared_ptr<ITaskQueue> inner,
+                 std::shared_ptr<QueueBudget> budget);
+
+    // false, leaving the task as it was, if it does not fit
+    bool tryPush(Task&& task);
+    // queues the longest prefix of `tasks` that fits, returns its length
+    size_t tryPushBatch(std::span<Task> tasks);
+
+    void push(Task&& task) override;
+    void pushBatch(std::span<Task> tasks) override;
+    std::optional<Task> pop() override;
+    std::optional<std::reference_wrapper<const Task>> peek() const override {
+        return inner_->peek();
+    }
+    std::optional<Task> erase(TaskState const& state) override;
+    bool reprioritize(TaskState const& state, int priority) override {
+        return inner_->reprioritize(state, priority);
+    }
+    bool changeDeadline(TaskState const& state,
+                        std::optional<time_point> deadline) override {
+        return inner_->changeDeadline(state, deadline);
+    }
+    bool empty() const override { return inner_->empty(); }
+    size_t size() const override { return inner_->size(); }
+
+private:
+    std::shared_ptr<ITaskQueue> inner_;
+    std::shared_ptr<QueueBudget> budget_;
+};
+} // namespace scheduler::detail
@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Lock-free single-owner work-stealing deque (Chase-Lev, with the C11
+ * memory orderings from Le et al., "Correct and Efficient Work-Stealing for
+ * Weak Memory Models").
+ *
+ * The owning thread pushes and pops at the bottom (LIFO), any other thread
+ * may steal from the top (FIFO). The deque stores raw pointers and never
+ * owns the pointees.
+ *
+ * @warning push() and pop() must only be called from the owning thread.
+ * Buffers replaced on growth are retired and kept alive until the deque is
+ * destroyed, since a concurrent thief may still be reading from them.
+ */
+template <typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(std::size_t initialCapacity = 256)
+      : top_{0}, bottom_{0}
+    {
+        std::size_t capacity = 1;
+        while (capacity < initialCapacity) capacity <<= 1;
+        buffers_.push_back(std::make_unique<Buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(ChaseLevDeque const&) = delete;
+    ChaseLevDeque& operator=(ChaseLevDeque const&) = delete;
+
+    void push(T* item) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(buffer->capacity) - 1) {
+            buffer = grow(buffer, b, t);
+        }
+        buffer->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // returns nullptr when the deque is empty
+    T* pop() {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = buffer->get(b);
+        if (t == b) {
+            // last element, race against thieves for it
+            if (!top_.compare_exchange_strong(t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // returns nullptr when the deque is empty or the race was lost
+    T* steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        T* item = buffer->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // approximate when called concurrently with push/pop/steal
+    std::size_t size() const noexcept {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+private:
+    struct Buffer {
+        explicit Buffer(std::size_t cap)
+          : capacity{cap}, mask{cap - 1},
+            slots{std::make_unique<std::atomic<T*>[]>(cap)} {}
+
+        T* get(std::int64_t i) const noexcept {
+            return slots[static_cast<std::size_t>(i) & mask]
+                .load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, T* item) noexcept {
+            slots[static_cast<std::size_t>(i) & mask]
+                .store(item, std::memory_order_relaxed);
+        }
+
+        std::size_t capacity;
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    Buffer* grow(Buffer* old, std::int64_t b, std::int64_t t) {
+        auto bigger = std::make_unique<Buffer>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        Buffer* raw = bigger.get();
+        buffers_.push_back(std::move(bigger));
+        buffer_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_;
+    alignas(64) std::atomic<std::int64_t> bottom_;
+    std::atomic<Buffer*> buffer_;
+    std::vector<std::unique_ptr<Buffer>> buffers_; // owner only
+};
+} // namespace scheduler::detail
@@ -0,0 +1,45 @@
+#pragma once
+#include "detail/clock.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace scheduler::detail {
+
+/**
+ * Clock whose reading is a single relaxed load of a time a ticker thread
+ * refreshes every `resolution`.
+ *
+ * It lags steady_clock by up to one resolution plus however late the
+ * ticker gets to run, and never runs ahead of it. The ticker wakes up even
+ * when nothing reads the clock, so it trades idle wakeups for cheap
+ * reads.
+ */
+class CoarseClock : public IClock {
+public:
+    explicit CoarseClock(std::chrono::microseconds resolution =
+                             std::chrono::milliseconds{1});
+    ~CoarseClock();
+
+    CoarseClock(CoarseClock const&) = delete;
+    CoarseClock& operator=(CoarseClock const&) = delete;
+
+    std::chrono::steady_clock::time_point now() const noexcept override {
+        return std::chrono::steady_clock::time_point{
+            std::chrono::steady_clock::duration{
+                now_.load(std::memory_order_relaxed)}};
+    }
+
+private:
+    void tick() noexcept;
+
+    std::atomic<std::chrono::steady_clock::rep> now_;
+    std::chrono::microseconds resolution_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread ticker_;
+};
+} // namespace scheduler::detail
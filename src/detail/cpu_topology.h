@@ -0,0 +1,46 @@
+#pragma once
+#include "scheduler/worker_placement.h"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace scheduler::detail {
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// Parses a Linux cpulist such as "0-3,8,10-11"; empty if malformed
+std::vector<int> parseCpuList(std::string_view list);
+
+// Online CPUs grouped by NUMA node. Where the topology cannot be read this
+// is a single node 0 holding every CPU.
+std::vector<NumaNode> detectNumaNodes();
+
+// Binds the calling thread to `cpus`, false if the OS refused
+bool pinCurrentThread(std::vector<int> const& cpus);
+
+/**
+ * Which node queue every worker serves and where it may run.
+ *
+ * Without WorkerPlacement::numa all CPUs form one node with the id
+ * kAnyNode. Workers are dealt out to the nodes round robin.
+ */
+struct WorkerPlan {
+    struct Worker {
+        size_t node;            // index into `nodes`
+        std::vector<int> cpus;  // affinity, empty to leave it to the OS
+    };
+
+    std::vector<NumaNode> nodes;
+    std::vector<Worker> workers;
+
+    // index of the node with the given id, or `fallback` if there is none
+    size_t nodeIndex(int id, size_t fallback) const noexcept;
+};
+
+WorkerPlan planWorkers(size_t num_threads, WorkerPlacement const& placement,
+                       std::vector<NumaNode> topology);
+
+} // namespace scheduler::detail
@@ -0,0 +1,67 @@
+#pragma once
+#include "scheduler/scheduler_options.h"
+#include <atomic>
+#include <chrono>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace scheduler::detail {
+
+/**
+ * Deadline bookkeeping of a scheduler: counts met and missed deadlines and,
+ * with a DeadlinePolicy, learns how long each priority class runs so the
+ * dispatcher can tell which tasks cannot make it any more.
+ *
+ * Estimates are an exponentially weighted moving average with a weight of
+ * 1/8 for the newest sample. Only tasks with a deadline are sampled, so
+ * tasks without one pay nothing. They live in a fixed table of atomics, one
+ * per priority from kMinClass to kMaxClass, so neither the dispatcher nor
+ * the workers take a lock; priorities outside that range share the bucket
+ * at its nearer end.
+ */
+class DeadlineMonitor {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    explicit DeadlineMonitor(std::optional<DeadlinePolicy> policy);
+
+    bool shedding() const noexcept { return policy_.has_value(); }
+    DeadlinePolicy const& policy() const noexcept { return *policy_; }
+
+    std::chrono::nanoseconds estimate(int priority) const;
+    // false if a task of `priority` started at `now` would finish late;
+    // always true without a policy
+    bool reachable(int priority, time_point deadline, time_point now) const;
+
+    // `ran` is measured on one clock, `ended` is read from the clock the
+    // deadline is kept on
+    void finished(int priority, std::chrono::nanoseconds ran,
+                  time_point ended, time_point deadline);
+    void shed() noexcept { shed_.fetch_add(1, std::memory_order_relaxed); }
+    void demoted() noexcept {
+        demoted_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DeadlineCounts counts() const noexcept;
+
+    static constexpr int kMinClass = -32;
+    static constexpr int kMaxClass = 31;
+
+private:
+    static constexpr int64_t kNoSample = -1;
+
+    std::atomic<int64_t>& bucket(int priority) const noexcept;
+
+    std::optional<DeadlinePolicy> policy_;
+
+    // nanoseconds, or kNoSample
+    mutable std::array<std::atomic<int64_t>, kMaxClass - kMinClass + 1>
+        estimates_;
+
+    std::atomic<uint64_t> met_{0};
+    std::atomic<uint64_t> missed_{0};
+    std::atomic<uint64_t> shed_{0};
+    std::atomic<uint64_t> demoted_{0};
+};
+} // namespace scheduler::detail
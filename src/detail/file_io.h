@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace scheduler::detail {
+
+// Writes `text` to a temporary file next to `path` and renames it over
+// `path`, so readers see the old contents or the new ones, never a partial
+// file. False, with the temporary removed, if any step failed.
+bool writeFileAtomically(std::string const& path, std::string_view text);
+} // namespace scheduler::detail
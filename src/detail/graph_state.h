@@ -0,0 +1,31 @@
+#pragma once
+#include "scheduler/inplace_task.h"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace scheduler::detail {
+
+// Shared by every queued or running task of one submitted TaskGraph.
+struct GraphState {
+    struct Node {
+        InplaceTask task;
+        int priority = 0;
+        std::vector<size_t> successors;
+        std::atomic<size_t> pending{0};  // predecessors still to finish
+    };
+
+    explicit GraphState(size_t count)
+    : nodes{std::make_unique<Node[]>(count)}, remaining{count} {}
+
+    std::unique_ptr<Node[]> nodes;
+    std::atomic<size_t> remaining;  // nodes not finished or skipped yet
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;       // written once, by whoever set `failed`
+    std::promise<void> done;
+};
+} // namespace scheduler::detail
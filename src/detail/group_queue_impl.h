@@ -0,0 +1,98 @@
+#pragma once
+#include "scheduler/scheduler_options.h"
+#include "clock.h"
+#include "task_queue.h"
+#include "task.h"
+#include "task_heap.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Weighted fair queueing between task groups, see TaskGroup.
+ *
+ * Every group has its own TaskHeap, all under one lock. pop() takes the
+ * head of the group with the earliest virtual time, skipping groups that
+ * are out of quota, and charges that group the average run time of its
+ * tasks divided by its weight. finished() settles the difference to the
+ * actual run time and updates the average, an exponentially weighted
+ * moving average with a weight of 1/8 for the newest sample. Charging up
+ * front keeps the dispatcher from filling a batch from a single group.
+ * empty() is true when no group may run a task right now,
+ * while size() counts every queued task.
+ *
+ * finished() runs on every worker after every task, so it stays off the
+ * lock: it only adds to per-group atomics, which the next call under the
+ * lock folds into the virtual times and quotas.
+ *
+ * Groups are picked by a linear scan, which beats a tree for the few
+ * dozen tenants a scheduler is shared by.
+ */
+class GroupQueue : public ITaskQueue {
+public:
+    GroupQueue(std::vector<TaskGroup> const& groups,
+               std::shared_ptr<IClock> clock);
+
+    size_t groupCount() const noexcept { return groups_.size(); }
+
+    // reports a task of `group` that ran for `ran`
+    void finished(uint32_t group, std::chrono::nanoseconds ran);
+    // when the first throttled group with queued tasks may run again
+    std::optional<time_point> nextRefill() const;
+    // stops enforcing quotas, so that the queue can be drained
+    void liftQuotas();
+    // without the latency, which the scheduler keeps
+    GroupStats stats(uint32_t group) const;
+
+    void push(Task&& task) override;
+    void pushBatch(std::span<Task> tasks) override;
+    std::optional<Task> pop() override;
+    std::optional<std::reference_wrapper<const Task>> peek() const override;
+    std::optional<Task> erase(TaskState const& state) override;
+    bool reprioritize(TaskState const& state, int priority) override;
+    bool changeDeadline(TaskState const& state,
+                        std::optional<time_point> deadline) override;
+    bool empty() const override;
+    size_t size() const override;
+
+private:
+    struct Group {
+        TaskHeap heap;
+        double vtime = 0;
+        double weight = 1;
+        // quota, a zero budget being none
+        std::chrono::nanoseconds budget{0};
+        std::chrono::nanoseconds period{0};
+        time_point period_end;
+        bool throttled = false;
+        uint64_t throttles = 0;
+
+        // written by finished() without the lock, all in nanoseconds
+        alignas(64) std::atomic<int64_t> estimate{0};
+        std::atomic<int64_t> owed{0};  // run time beyond the up-front charges
+        std::atomic<int64_t> used{0};  // against the quota
+        std::atomic<uint64_t> completed{0};
+        std::atomic<int64_t> busy{0};
+    };
+
+    void enqueue(Task&& task);
+    void refill(Group& group, time_point now) const;
+    void settle(Group& group, time_point now) const;
+    void settleAll() const;
+    Group* next() const;
+    Task* find(TaskState const& state);
+
+    std::shared_ptr<IClock> clock_;
+    mutable std::mutex mtx_;
+    // mutable so that empty() and peek() can end quota periods
+    mutable std::vector<Group> groups_;
+    mutable size_t throttled_ = 0;
+    bool quotas_ = false;
+    double virtual_now_ = 0;
+    std::atomic<size_t> size_{0};
+};
+} // namespace scheduler::detail
@@ -0,0 +1,45 @@
+#pragma once
+#include "task_queue.h"
+#include "task.h"
+#include <memory>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Routes tasks to one queue per priority lane.
+ *
+ * Lane 0 holds the highest priorities. A push goes to the lane that covers
+ * the task's priority. pop() and peek() look at the lanes in order, so
+ * they favour higher lanes over the queue order of a single TaskQueue. The
+ * dispatcher pops from each lane itself through lane(). Handle operations
+ * try every lane; a TaskHeap only ever finds its own tasks.
+ */
+class LaneQueue : public ITaskQueue {
+public:
+    // `floors` are the lanes' minimum priorities, highest lane first
+    LaneQueue(std::vector<int> floors,
+              std::vector<std::shared_ptr<ITaskQueue>> lanes);
+
+    size_t laneOf(int priority) const noexcept;
+    size_t laneCount() const noexcept { return lanes_.size(); }
+    std::shared_ptr<ITaskQueue> const& lane(size_t index) const noexcept {
+        return lanes_[index];
+    }
+
+    void push(Task&& task) override;
+    void pushBatch(std::span<Task> tasks) override;
+    std::optional<Task> pop() override;
+    std::optional<std::reference_wrapper<const Task>> peek() const override;
+    std::optional<Task> erase(TaskState const& state) override;
+    bool reprioritize(TaskState const& state, int priority) override;
+    bool changeDeadline(TaskState const& state,
+                        std::optional<time_point> deadline) override;
+    bool empty() const override;
+    size_t size() const override;
+
+private:
+    std::vector<int> floors_;
+    std::vector<std::shared_ptr<ITaskQueue>> lanes_;
+};
+} // namespace scheduler::detail
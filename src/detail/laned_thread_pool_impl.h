@@ -0,0 +1,78 @@
+#pragma once
+#include "detail/thread_pool.h"
+#include "detail/cpu_topology.h"
+#include "detail/ring_queue.h"
+#include "detail/worker_parking.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scheduler::detail {
+
+// Workers set aside for one lane of a LanedThreadPool
+struct LaneWorkers {
+    size_t reserved = 0;
+    bool borrow = true;  // may run lower lanes' jobs when its own are done
+};
+
+/**
+ * Thread pool with one FIFO queue per priority lane, lane 0 highest.
+ *
+ * The first workers are reserved to the lanes, in lane order. Reserved
+ * workers serve their own lane and, if they borrow, the lanes below it.
+ * All other workers serve every lane, highest first. The number of
+ * reserved workers is capped so that at least one worker is unreserved.
+ *
+ * Every lane's reserved workers park on their own WorkerParking, and so do
+ * the unreserved workers. A submit wakes every group that may run the
+ * jobs, so a worker that cannot help never swallows a wake up.
+ */
+class LanedThreadPool : public IThreadPool {
+public:
+    LanedThreadPool(size_t numThreads, std::vector<LaneWorkers> lanes,
+                    IdlePolicy idle = IdlePolicy::latencyOptimized(),
+                    WorkerPlacement placement = {});
+    ~LanedThreadPool();
+    // plain submissions go to the lowest lane
+    bool submit(Job job) override;
+    bool submitBatch(std::span<Job> jobs) override;
+    bool submitToLane(std::span<Job> jobs, size_t lane) override;
+    size_t laneCapacity(size_t lane) const noexcept override;
+    void recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                    std::shared_ptr<IClock> clock) override;
+    void start() override;
+    void stop() override;
+    size_t threadCount() const noexcept override;
+
+    // reserved workers actually given to `lane` after capping
+    size_t reservedWorkers(size_t lane) const noexcept;
+
+private:
+    struct alignas(64) LaneJobs {
+        RingQueue<Job> jobs;
+        std::atomic<size_t> queued{0};
+    };
+    struct Role {
+        std::vector<size_t> lanes;  // served in this order
+        size_t group;               // index into `parkings`
+    };
+
+    void workerLoop(Role const& role);
+    bool pop(Role const& role, Job& job, size_t& lane);
+    bool hasWork(Role const& role) const noexcept;
+    void wakeFor(size_t lane, size_t count);
+
+    std::vector<std::unique_ptr<LaneJobs>> lanes;
+    std::vector<LaneWorkers> lane_workers;
+    std::vector<Role> roles;  // one per worker
+    // one group per lane for its reserved workers, the last one for the rest
+    std::vector<std::unique_ptr<WorkerParking>> parkings;
+    std::vector<std::thread> threads;
+    std::mutex queue_mutex;  // guards every lane queue and start/stop
+    std::atomic<bool> running;
+    size_t thread_num;
+    WorkerPlan worker_plan;
+};
+} // namespace scheduler::detail
@@ -0,0 +1,58 @@
+#pragma once
+#include "detail/thread_slot_cache.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace scheduler::detail {
+
+enum class Counter : size_t {
+    Submitted,
+    TimerFires,
+    Dispatched,
+    Completed,
+    Rejected,
+    Refused,
+    Cancelled,
+    DispatcherWakeups,
+    BusyNanos,
+    ParkedNanos,
+    WorkerWakeups,
+    kCount
+};
+
+/**
+ * Event counters with a cache line of counters per recording thread.
+ *
+ * Works like StatisticsCalculator: a thread claims a block the first time
+ * it records, after which add() is a relaxed load and store on memory no
+ * other writer touches. total() sums up every block.
+ */
+class MetricsRecorder {
+public:
+    static constexpr size_t kCounters = static_cast<size_t>(Counter::kCount);
+
+    MetricsRecorder() = default;
+
+    void add(Counter counter, uint64_t delta = 1) {
+        auto& cell = local().values[static_cast<size_t>(counter)];
+        cell.store(cell.load(std::memory_order_relaxed) + delta,
+                   std::memory_order_relaxed);
+    }
+
+    uint64_t total(Counter counter) const;
+
+    // Written by one thread at a time; a thread that exits or runs out of
+    // cache entries hands its block back for reuse.
+    struct alignas(64) Block {
+        std::array<std::atomic<uint64_t>, kCounters> values{};
+        std::atomic<bool> owned{true};
+    };
+
+private:
+    Block& local();
+
+    ThreadSlotCache<Block> blocks_;
+};
+} // namespace scheduler::detail
@@ -0,0 +1,84 @@
+#pragma once
+#include "task_queue.h"
+#include "task.h"
+#include "task_heap.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Sharded concurrent priority queue (MultiQueue).
+ *
+ * Tasks are spread over `shardCount` independently locked binary heaps.
+ * In Mode::Relaxed, pop() samples two random shards, compares their cached
+ * heads without locking and pops from the better one, so producers and
+ * consumers rarely meet on the same lock.
+ *
+ * Ordering bound (Mode::Relaxed): every shard is a strict heap, so a task is
+ * only ever overtaken by tasks that sit in other shards. With two-choice
+ * sampling over S shards the expected rank of a popped task among all queued
+ * tasks is O(S) and the expected worst rank is O(S log S) (Alistarh et al.,
+ * "The Power of Choice in Priority Scheduling", PODC 2017). No task is lost or
+ * starved: pop() falls back to a full scan when sampling finds nothing.
+ *
+ * Mode::Strict locks every shard and pops the global best according to
+ * Task::operator<, matching TaskQueue exactly at the cost of scalability.
+ */
+class MultiQueue : public ITaskQueue {
+public:
+    enum class Mode { Relaxed, Strict };
+
+    explicit MultiQueue(size_t shardCount =
+                            2 * std::thread::hardware_concurrency(),
+                        Mode mode = Mode::Relaxed);
+    ~MultiQueue() = default;
+    void push(Task&& task) override;
+    // splits the batch evenly over the shards, one lock per shard
+    void pushBatch(std::span<Task> tasks) override;
+    std::optional<Task> pop() override;
+    /**
+     * takes a look at the globally best task, locking every shard
+     * @warning same as TaskQueue::peek, the reference is invalidated by
+     * any pop()
+    */
+    std::optional<std::reference_wrapper<const Task>> peek() const override;
+    std::optional<Task> erase(TaskState const& state) override;
+    bool reprioritize(TaskState const& state, int priority) override;
+    bool changeDeadline(TaskState const& state,
+                        std::optional<time_point> deadline) override;
+    // approximate under concurrent modification, never takes a lock
+    bool empty() const override;
+    size_t size() const override;
+
+    size_t shardCount() const noexcept;
+    Mode mode() const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mtx;
+        TaskHeap heap;
+        // snapshot of the head used for lock-free sampling
+        std::atomic<uint64_t> top_deadline{UINT64_MAX};
+        std::atomic<uint32_t> top_priority{0};
+        std::atomic<bool> has_top{false};
+    };
+
+    static void refreshTop(Shard& shard) noexcept;
+    static bool headBetter(Shard const& a, Shard const& b) noexcept;
+    static Task popLocked(Shard& shard);
+    size_t randomShard() const noexcept;
+    template <typename Fn>
+    bool updateQueued(TaskState const& state, Fn&& mutate);
+    std::optional<Task> popRelaxed();
+    std::optional<Task> popStrict();
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    Mode mode_;
+    alignas(64) std::atomic<size_t> size_;
+};
+} // namespace scheduler::detail
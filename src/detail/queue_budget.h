@@ -0,0 +1,56 @@
+#pragma once
+#include "scheduler/scheduler_options.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace scheduler::detail {
+
+struct Task;
+
+/**
+ * Counts the tasks and bytes queued under QueueLimits and tells when the
+ * watermarks are crossed.
+ *
+ * tryAcquire() reserves room without ever going past a cap, acquire()
+ * always succeeds. Watermark changes are serialized under a mutex so that
+ * on_pressure sees them in order; the counters themselves are lock-free.
+ */
+class QueueBudget {
+public:
+    explicit QueueBudget(QueueLimits limits);
+
+    // what a queued task counts as
+    static size_t footprint(Task const& task) noexcept;
+
+    bool tryAcquire(size_t tasks, size_t bytes);
+    void acquire(size_t tasks, size_t bytes);
+    void release(size_t tasks, size_t bytes);
+
+    size_t tasks() const noexcept {
+        return tasks_.load(std::memory_order_relaxed);
+    }
+    size_t bytes() const noexcept {
+        return bytes_.load(std::memory_order_relaxed);
+    }
+    bool pressured() const noexcept {
+        return pressured_.load(std::memory_order_relaxed);
+    }
+
+    void reject(RejectedTask&& task) const;
+
+private:
+    void checkPressure();
+
+    QueueLimits limits_;
+    size_t high_tasks_;
+    size_t low_tasks_;
+    size_t high_bytes_;
+    size_t low_bytes_;
+
+    std::atomic<size_t> tasks_{0};
+    std::atomic<size_t> bytes_{0};
+    std::atomic<bool> pressured_{false};
+    std::mutex pressure_mtx_;
+};
+} // namespace scheduler::detail
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace scheduler::detail {
+
+/**
+ * FIFO on a power-of-two ring that only ever grows.
+ *
+ * std::deque hands a block back to the allocator and takes a new one every
+ * few elements as its ends move; a ring that has reached the working size
+ * of its queue does not allocate again.
+ */
+template <typename T>
+class RingQueue {
+public:
+    RingQueue() = default;
+    RingQueue(RingQueue const&) = delete;
+    RingQueue& operator=(RingQueue const&) = delete;
+    ~RingQueue() { clear(); }
+
+    bool empty() const noexcept { return head_ == tail_; }
+    std::size_t size() const noexcept { return tail_ - head_; }
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    T& front() noexcept { return *at(head_); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size() == capacity_) grow();
+        Slot& slot = slots_[tail_ & (capacity_ - 1)];
+        T* item = ::new (static_cast<void*>(slot.bytes))
+            T(std::forward<Args>(args)...);
+        ++tail_;
+        return *item;
+    }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_front() noexcept {
+        at(head_)->~T();
+        ++head_;
+    }
+
+    void clear() noexcept {
+        while (!empty()) pop_front();
+    }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    T* at(std::size_t index) const noexcept {
+        return std::launder(reinterpret_cast<T*>(
+            slots_[index & (capacity_ - 1)].bytes));
+    }
+
+    void grow() {
+        std::size_t capacity = capacity_ ? capacity_ * 2 : 16;
+        auto slots = std::make_unique<Slot[]>(capacity);
+        std::size_t count = size();
+        for (std::size_t i = 0; i < count; ++i) {
+            T* item = at(head_ + i);
+            ::new (static_cast<void*>(slots[i].bytes)) T(std::move(*item));
+            item->~T();
+        }
+        slots_ = std::move(slots);
+        capacity_ = capacity;
+        head_ = 0;
+        tail_ = count;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t capacity_ = 0;
+    std::size_t head_ = 0;  // both count up forever and wrap by the mask
+    std::size_t tail_ = 0;
+};
+} // namespace scheduler::detail
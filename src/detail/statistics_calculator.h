@@ -1,4 +1,5 @@
 #pragma once
+#include "scheduler/latency_histogram.h"
 #include <tuple>
 #include <cstdint>
 
@@ -8,5 +9,9 @@ public:
     virtual ~IStatisticsCalculator() = default;
     virtual std::tuple<double, double, double> getLatencyStatistics() const = 0;
     virtual void updateLatencyStatistics(std::int64_t latency) = 0;
+    // samples recorded since the last reset (or since construction)
+    virtual LatencyHistogram getLatencyHistogram() const = 0;
+    // returns the samples of the interval that ends now and starts a new one
+    virtual LatencyHistogram resetLatencyHistogram() = 0;
 };
 } // namespace scheduler::detail
@@ -1,22 +1,64 @@
 #pragma once
 #include "detail/statistics_calculator.h"
+#include "detail/thread_slot_cache.h"
+#include <array>
 #include <tuple>
 #include <chrono>
 #include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace scheduler::detail {
+
+/**
+ * Latency statistics with per-thread recorders, merged on read.
+ *
+ * Each recording thread claims a recorder of its own the first time it
+ * records into a calculator, so updateLatencyStatistics() is a handful of
+ * relaxed loads and stores on a cache line no other writer touches: no
+ * locks, no read-modify-write and no CAS loops. Readers sum the recorders
+ * up; a read racing with writers may miss the samples in flight.
+ *
+ * getLatencyStatistics() covers everything since construction. The
+ * histogram getters cover the current interval, which resetLatencyHistogram()
+ * closes by remembering the totals at that point rather than by clearing the
+ * recorders.
+ */
 class StatisticsCalculator : public IStatisticsCalculator {
 public:
+    StatisticsCalculator();
     ~StatisticsCalculator() = default;
-    StatisticsCalculator() : count{0}, sum{0},
-                            min{std::numeric_limits<int64_t>::max()},
-                            max{0} {}
     std::tuple<double, double, double> getLatencyStatistics() const override;
     void updateLatencyStatistics(int64_t latency) override;
+    LatencyHistogram getLatencyHistogram() const override;
+    LatencyHistogram resetLatencyHistogram() override;
+
+    // Written by one thread at a time; a thread that exits or runs out of
+    // cache entries hands its recorder back for reuse.
+    struct alignas(64) Recorder {
+        std::array<std::atomic<uint64_t>, LatencyHistogram::kBucketCount>
+            counts{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<int64_t> sum{0};
+        std::atomic<int64_t> min{std::numeric_limits<int64_t>::max()};
+        std::atomic<int64_t> max{0};
+        std::atomic<bool> owned{true};
+    };
+
 private:
-    std::atomic<uint64_t> count;
-    std::atomic<int64_t> min;
-    std::atomic<int64_t> max;
-    std::atomic<int64_t> sum;
+    struct Totals {
+        std::vector<uint64_t> counts;
+        int64_t sum = 0;
+    };
+
+    Recorder& localRecorder();
+    Totals collect() const;
+    LatencyHistogram since(Totals const& now) const;
+
+    ThreadSlotCache<Recorder> recorders_;
+    mutable std::mutex interval_mtx_;
+    Totals interval_start_;
 };
 } // namespace scheduler::detail
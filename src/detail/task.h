@@ -1,5 +1,8 @@
 #pragma once
-#include <functional>
+#include "scheduler/inplace_task.h"
+#include "task_state.h"
+#include "scheduler/worker_placement.h"
+#include <memory>
 #include <optional>
 #include <chrono>
 namespace scheduler::detail {
@@ -8,33 +11,30 @@ using milliseconds = std::chrono::milliseconds;
 using time_point   = std::chrono::steady_clock::time_point;
 
 struct Task {
-    std::function<void()> task;
+    InplaceTask task;
     int priority;
+    int node = kAnyNode;  // NUMA node hint for the pool
+    uint32_t group = 0;   // see TaskGroup
     milliseconds interval; // zero means one off task
     time_point enqueue_time;
     std::optional<time_point> deadline;
     uint64_t sequence_number;
+    std::shared_ptr<TaskState> state; // null if there is no handle
 
-    Task(std::function<void()> f,
+    Task(InplaceTask f,
          int prio,
          uint64_t seq,
          milliseconds intrvl,
          time_point enqueue,
-         std::optional<time_point> dl)
+         std::optional<time_point> dl,
+         std::shared_ptr<TaskState> st = nullptr)
       : task(std::move(f))
       , priority(prio)
       , interval(intrvl)
+      , enqueue_time(enqueue)
       , deadline(dl)
       , sequence_number(seq)
-    {}
-
-    Task(std::function<void()> f,
-         int prio,
-         uint64_t seq)
-       : Task(std::move(f), prio, seq,
-         milliseconds{0},
-         std::chrono::steady_clock::now(),
-         std::optional<time_point>{std::nullopt})
+      , state(std::move(st))
     {}
 
     // If my deadline time is later than theirs, i am less than them
@@ -0,0 +1,104 @@
+#pragma once
+#include "task.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Ordering key of a Task packed into plain integers.
+ *
+ * Smaller keys run first, and comparing two keys gives the same order as
+ * Task::operator< on the tasks they were made from: earlier deadline, then
+ * higher priority, then lower sequence number. A task without a deadline
+ * sorts after every task that has one.
+ */
+struct TaskKey {
+    uint64_t deadline;  // biased steady_clock ticks, UINT64_MAX if none
+    uint64_t sequence;
+    uint32_t priority;  // inverted, so that a higher priority is smaller
+    // not part of the order, lets the owner locate the task body
+    uint32_t handle = 0;
+
+    static TaskKey of(Task const& task) noexcept;
+
+    // true if `*this` runs before `other`
+    bool operator<(TaskKey const& other) const noexcept {
+        if (deadline != other.deadline) return deadline < other.deadline;
+        if (priority != other.priority) return priority < other.priority;
+        return sequence < other.sequence;
+    }
+};
+
+/**
+ * Single-threaded, indexed 4-ary priority heap with a hot/cold split.
+ *
+ * The heap itself only holds 24-byte TaskKeys whose handle is the slab slot
+ * of the task body, so sifting compares and moves a few integers instead of
+ * whole Task objects; four children per node keep a sift within a couple of
+ * cache lines. Task bodies live in a chunked slab whose slots are recycled
+ * through a free list; once the slab and the heap have grown to the peak
+ * queue length, push() and pop() no longer allocate.
+ *
+ * Every slot knows its position in the heap, so a one-off task with a
+ * TaskState can be erased or re-keyed in O(log n) through that state.
+ *
+ * Bodies never move while queued, so the reference returned by top() stays
+ * valid until that task is popped. Callers provide their own locking.
+ */
+class TaskHeap {
+public:
+    TaskHeap() = default;
+    ~TaskHeap();
+    TaskHeap(TaskHeap const&) = delete;
+    TaskHeap& operator=(TaskHeap const&) = delete;
+
+    void push(Task&& task);
+    // Appends the tasks, moving from the elements, then restores the heap
+    // either with one heapify or by sifting up the new entries, whichever
+    // is cheaper for the batch and heap sizes at hand.
+    void pushBatch(std::span<Task> tasks);
+    // @warning the heap must not be empty
+    Task pop();
+    Task const& top() const noexcept;
+    TaskKey const& topKey() const noexcept;
+
+    // the queued task tracked by `state`, null if it is not in this heap
+    Task* find(TaskState const& state) noexcept;
+    // re-sorts a task found with find() after its priority or deadline
+    // changed
+    void update(Task& task) noexcept;
+    // removes a task found with find()
+    Task erase(Task& task) noexcept;
+
+    bool empty() const noexcept { return heap_.empty(); }
+    size_t size() const noexcept { return heap_.size(); }
+
+private:
+    static constexpr size_t kArity = 4;
+    static constexpr size_t kChunkBits = 6;
+    static constexpr size_t kChunkSlots = size_t{1} << kChunkBits;
+
+    static_assert(sizeof(TaskKey) == 24, "heap entries should stay compact");
+
+    struct Slot {
+        alignas(Task) unsigned char bytes[sizeof(Task)];
+    };
+
+    Task* body(uint32_t slot) const noexcept;
+    uint32_t acquireSlot();
+    uint32_t store(Task&& task, TaskKey& key);
+    Task release(uint32_t slot) noexcept;
+    void place(size_t index, TaskKey const& key) noexcept;
+    void siftUp(size_t index) noexcept;
+    void siftDown(size_t index) noexcept;
+    void removeAt(size_t index) noexcept;
+
+    std::vector<TaskKey> heap_;
+    std::vector<uint32_t> position_;  // heap index of every slot
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    std::vector<uint32_t> free_;
+};
+} // namespace scheduler::detail
@@ -1,16 +1,27 @@
 #pragma once
+#include <chrono>
 #include <optional>
+#include <span>
 
 namespace scheduler::detail {
 
 struct Task;
+struct TaskState;
 
 class ITaskQueue {
 public:
     virtual ~ITaskQueue() = default;
     virtual void push(Task&& task) = 0;
+    // inserts every task under a single lock, moving from the elements
+    virtual void pushBatch(std::span<Task> tasks) = 0;
     virtual std::optional<Task> pop() = 0;
     virtual std::optional<std::reference_wrapper<const Task>> peek() const = 0;
+    // Remove or re-key the queued one-off task tracked by `state`; they
+    // fail once the task has left the queue.
+    virtual std::optional<Task> erase(TaskState const& state) = 0;
+    virtual bool reprioritize(TaskState const& state, int priority) = 0;
+    virtual bool changeDeadline(TaskState const& state,
+        std::optional<std::chrono::steady_clock::time_point> deadline) = 0;
     virtual bool empty() const = 0;
     virtual size_t size() const = 0;
 };
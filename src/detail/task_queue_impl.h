@@ -1,8 +1,9 @@
 #pragma once
 #include "task_queue.h"
 #include "task.h"
-#include <vector>
+#include "task_heap.h"
 #include <mutex>
+#include <atomic>
 
 namespace scheduler::detail {
 class TaskQueue : public ITaskQueue {
@@ -10,6 +11,7 @@ public:
     TaskQueue() = default;
     ~TaskQueue() = default;
     void push(Task&& task) override;
+    void pushBatch(std::span<Task> tasks) override;
     /**
      * @warning pop deletes the task before returning it
     */
@@ -21,10 +23,16 @@ public:
      * to undefined behavior
     */
     std::optional<std::reference_wrapper<const Task>> peek() const override;
+    std::optional<Task> erase(TaskState const& state) override;
+    bool reprioritize(TaskState const& state, int priority) override;
+    bool changeDeadline(TaskState const& state,
+                        std::optional<time_point> deadline) override;
+    // approximate under concurrent modification, never takes the lock
     bool empty() const override;
     size_t size() const override;
 private:
-    std::vector<Task> heap_;
+    TaskHeap heap_;
     mutable std::mutex mtx_;
+    std::atomic<size_t> size_{0};
 };
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include "scheduler/inplace_task.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace scheduler::detail {
+
+class ITaskQueue;
+class TimingWheel;
+
+/**
+ * Shared state between a scheduled task and its TaskHandle.
+ *
+ * A one-off task is claimed exactly once: either the dispatcher moves it
+ * from Queued to Dispatched right before handing it to the pool, or a
+ * cancel moves it to Cancelled and the dispatcher drops it. Every fire of a
+ * recurring task shares the state of its timer and is only checked for
+ * Cancelled, since several fires may be queued at once.
+ */
+struct TaskState {
+    enum class Status : uint8_t { Queued, Dispatched, Cancelled };
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    std::atomic<Status> status{Status::Queued};
+    bool recurring = false;
+
+    // Where a queued one-off task sits in its queue, written by the queue
+    // under the lock that guards the task. `shard` may be read unlocked to
+    // find that lock, and must be re-checked once it is held.
+    uint32_t slot = kNoSlot;
+    std::atomic<uint32_t> shard{0};
+
+    std::weak_ptr<ITaskQueue> queue;
+    std::weak_ptr<TimingWheel> timers;
+    uint64_t timer = 0;
+
+    // true if the dispatcher may hand the task to the pool
+    bool claim() noexcept {
+        if (recurring) {
+            return status.load(std::memory_order_acquire) != Status::Cancelled;
+        }
+        auto expected = Status::Queued;
+        return status.compare_exchange_strong(expected, Status::Dispatched,
+                                              std::memory_order_acq_rel);
+    }
+};
+
+// Lets std::allocate_shared take control blocks from the task pool.
+template <typename T>
+struct TaskStorageAllocator {
+    using value_type = T;
+
+    TaskStorageAllocator() noexcept = default;
+    template <typename U>
+    TaskStorageAllocator(TaskStorageAllocator<U> const&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(allocateTaskStorage(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        deallocateTaskStorage(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(TaskStorageAllocator<U> const&) const noexcept {
+        return true;
+    }
+};
+
+inline std::shared_ptr<TaskState> makeTaskState() {
+    return std::allocate_shared<TaskState>(TaskStorageAllocator<TaskState>{});
+}
+} // namespace scheduler::detail
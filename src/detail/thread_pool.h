@@ -1,12 +1,67 @@
 #pragma once
+#include "scheduler/inplace_task.h"
+#include "scheduler/scheduler_options.h"
 #include <functional>
+#include <memory>
+#include <span>
 
 namespace scheduler::detail{
+
+class IClock;
+class MetricsRecorder;
+
+// Pools that compensate for blocked workers register themselves for every
+// worker thread; BlockingScope reports to the one of the calling thread.
+class IBlockingObserver {
+public:
+    virtual ~IBlockingObserver() = default;
+    virtual void enterBlocking() noexcept = 0;
+    virtual void leaveBlocking() noexcept = 0;
+
+    // the observer of the calling thread, null outside pool workers
+    static IBlockingObserver*& current() noexcept;
+};
+
 class IThreadPool {
 public:
     virtual ~IThreadPool() = default;
-    virtual bool submit(std::function<void()> job) = 0;
+    virtual bool submit(Job job) = 0;
+    // hands over every job at once, moving from the elements, and wakes at
+    // most one worker per job; either all jobs are accepted or none
+    virtual bool submitBatch(std::span<Job> jobs) = 0;
+    // like submitBatch, but prefers workers on the given NUMA node; pools
+    // without node queues ignore the hint
+    virtual bool submitToNode(std::span<Job> jobs, int node) {
+        (void)node;
+        return submitBatch(jobs);
+    }
+    // like submitBatch, for the jobs of one priority lane (0 is the
+    // highest); pools without lanes ignore it
+    virtual bool submitToLane(std::span<Job> jobs, size_t lane) {
+        (void)lane;
+        return submitBatch(jobs);
+    }
+    // number of workers that may run jobs of `lane`
+    virtual size_t laneCapacity(size_t lane) const noexcept {
+        (void)lane;
+        return threadCount();
+    }
     virtual void start() = 0;
     virtual void stop() = 0;
+    virtual size_t threadCount() const noexcept = 0;
+    virtual WorkerCounts workerCounts() const noexcept {
+        return {threadCount(), 0, 0};
+    }
+    // called whenever laneCapacity() grows while the pool runs
+    virtual void onCapacityChange(std::function<void()> listener) {
+        (void)listener;
+    }
+    // where idle workers count the time they park and the times they are
+    // woken, timed with `clock`; called before start()
+    virtual void recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                            std::shared_ptr<IClock> clock) {
+        (void)metrics;
+        (void)clock;
+    }
 };
 } //namespace scheduler::detail
\ No newline at end of file
@@ -1,27 +1,112 @@
 #include "detail/thread_pool.h"
+#include "detail/cpu_topology.h"
+#include "detail/ring_queue.h"
+#include "detail/worker_parking.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <thread>
 #include <vector>
 #include <queue>
 #include <mutex>
-#include <condition_variable>
 
 namespace scheduler::detail {
-class ThreadPool : public IThreadPool {
+/**
+ * FIFO thread pool with one job queue per NUMA node.
+ *
+ * Without a NUMA-aware WorkerPlacement there is a single queue. Jobs
+ * without a node hint are dealt out to the node queues round robin. A
+ * worker serves its own node's queue and only takes jobs from other nodes
+ * once that queue is empty.
+ *
+ * In elastic mode the pool starts `numThreads` workers (clamped to the
+ * bounds) and resizes itself as described by ElasticThreads. Workers live
+ * in `max_threads` slots, so a retired worker's slot is reused by the
+ * next one that is started.
+ *
+ * With `max_compensating` > 0, every worker inside a BlockingScope may be
+ * stood in for by a compensating worker while runnable jobs wait. Those
+ * live in slots of their own, and one retires at the next opportunity
+ * after a blocked worker leaves its scope.
+ */
+class ThreadPool : public IThreadPool, private IBlockingObserver {
 public:
-    explicit ThreadPool(size_t numThreads);
+    explicit ThreadPool(size_t numThreads,
+                        IdlePolicy idle = IdlePolicy::latencyOptimized(),
+                        WorkerPlacement placement = {},
+                        std::optional<ElasticThreads> elastic = std::nullopt,
+                        size_t max_compensating = 0);
     ~ThreadPool();
-    bool submit(std::function<void()> job) override;
+    bool submit(Job job) override;
+    bool submitBatch(std::span<Job> jobs) override;
+    bool submitToNode(std::span<Job> jobs, int node) override;
+    // the most workers the pool may run at once, not counting blocked ones
+    size_t laneCapacity(size_t lane) const noexcept override;
+    void onCapacityChange(std::function<void()> listener) override;
+    void recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                    std::shared_ptr<IClock> clock) override;
     void start() override;
     void stop() override;
-    size_t threadCount() const noexcept;
+    // workers running right now
+    size_t threadCount() const noexcept override;
+    WorkerCounts workerCounts() const noexcept override;
+
+    // the node queues and the worker each one is served by
+    WorkerPlan const& plan() const noexcept { return worker_plan; }
+
 private:
-    void workerLoop();
+    using clock_type = std::chrono::steady_clock;
+
+    struct Queued {
+        Job job;
+        clock_type::time_point enqueued;  // only stamped in elastic mode
+    };
+    struct alignas(64) NodeQueue {
+        RingQueue<Queued> jobs;
+        std::mutex mtx;
+    };
+    struct Worker {
+        std::thread thread;
+        bool active = false;  // guarded by resize_mutex
+    };
+
+    void workerLoop(size_t slot);
+    bool hasWork() const noexcept;
+    bool push(std::span<Job> batch, size_t node);
+    bool pop(size_t node, Queued& job);
+    // start a worker in a free slot; needs resize_mutex and `running`
+    void launch(size_t slot);
+    void maybeGrow();
+    bool tryRetire(size_t slot);
+    void enterBlocking() noexcept override;
+    void leaveBlocking() noexcept override;
+    void compensate();
+    bool tryRetireCompensating(size_t slot);
 
-    std::vector<std::thread> threads;
-    std::deque<std::function<void()>> jobs;
+    std::vector<Worker> workers;  // one slot per possible worker
+    std::vector<std::unique_ptr<NodeQueue>> queues;
+    // guards start/stop; stop also takes every node lock to flip `running`
     std::mutex queue_mutex;
-    std::condition_variable cv;
-    bool running;
-    size_t thread_num;
+    std::atomic<size_t> queued;  // jobs in all node queues
+    std::atomic<size_t> next_node;
+    std::atomic<bool> running;
+    size_t thread_num;  // starting size
+
+    std::optional<ElasticThreads> elastic;
+    std::mutex resize_mutex;  // guards `workers` and the fields below
+    std::atomic<size_t> live;
+    std::atomic<uint64_t> grown;
+    std::atomic<uint64_t> retired;
+    clock_type::time_point last_resize;
+
+    size_t max_compensating;
+    std::atomic<size_t> blocked;       // workers inside a BlockingScope
+    std::atomic<size_t> compensating;  // extra workers standing in for them
+    std::atomic<uint64_t> compensations;
+    std::function<void()> capacity_listener;
+
+    WorkerPlan worker_plan;
+    WorkerParking parking;
 };
-} // namespace scheduler::detail
\ No newline at end of file
+} // namespace scheduler::detail
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Registry of slots written by one thread each, such as the counters of a
+ * recording thread, so that writers never share a cache line.
+ *
+ * A thread claims a slot the first time it asks for one: a slot another
+ * thread handed back, or a new one. From then on it finds the slot in a
+ * thread_local cache keyed by the registry's id; ids are never reused, so
+ * an entry of a destroyed registry can never match again. The cache holds
+ * an entry for every live registry the thread writes to, up to
+ * kMaxEntries, so a worker recording into one registry per task group
+ * does not keep reclaiming its slots. Entries of destroyed registries are
+ * dropped on the next claim. A thread that exits, or evicts an entry once
+ * the cache is full, hands its slot back. `T` needs a
+ * `std::atomic<bool> owned` that starts out true.
+ */
+template <typename T>
+class ThreadSlotCache {
+public:
+    ThreadSlotCache() noexcept
+    : id_{next_id_.fetch_add(1, std::memory_order_relaxed)} {}
+    ThreadSlotCache(ThreadSlotCache const&) = delete;
+    ThreadSlotCache& operator=(ThreadSlotCache const&) = delete;
+
+    // The calling thread's slot. `make` creates one when none is free and
+    // `claimed` sees every slot as it is claimed, both under the lock.
+    template <typename Make, typename Claimed>
+    T& local(Make&& make, Claimed&& claimed) {
+        Cache& cache = threadCache();
+        for (auto& entry : cache.entries) {
+            if (entry.owner == id_) return *entry.slot;
+        }
+        return claim(cache, make, claimed);
+    }
+
+    template <typename Make>
+    T& local(Make&& make) {
+        return local(make, [](T&) {});
+    }
+
+    // how often a thread had to claim a slot, rather than finding it cached
+    uint64_t claims() const noexcept {
+        return claims_.load(std::memory_order_relaxed);
+    }
+
+    // calls `visit` with every slot, under the lock
+    template <typename Visit>
+    void forEach(Visit&& visit) const {
+        std::lock_guard<std::mutex> guard{mtx_};
+        for (auto const& slot : slots_) visit(static_cast<T const&>(*slot));
+    }
+
+private:
+    static constexpr size_t kMaxEntries = 64;
+
+    struct Cache {
+        struct Entry {
+            uint64_t owner = 0;
+            std::shared_ptr<T> slot;
+        };
+
+        std::vector<Entry> entries;
+        size_t victim = 0;
+
+        ~Cache() {
+            for (auto& entry : entries) {
+                entry.slot->owned.store(false, std::memory_order_release);
+            }
+        }
+
+        // makes room for one more entry
+        void prune() {
+            // a destroyed registry no longer holds its slots
+            std::erase_if(entries, [](Entry const& entry) {
+                return entry.slot.use_count() == 1;
+            });
+            if (entries.size() < kMaxEntries) return;
+            victim %= entries.size();
+            entries[victim].slot->owned.store(false, std::memory_order_release);
+            entries.erase(entries.begin() + std::ptrdiff_t(victim));
+            ++victim;
+        }
+    };
+
+    static Cache& threadCache() noexcept {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    template <typename Make, typename Claimed>
+    T& claim(Cache& cache, Make& make, Claimed& claimed) {
+        cache.prune();
+        std::shared_ptr<T> slot;
+        {
+            std::lock_guard<std::mutex> guard{mtx_};
+            for (auto& candidate : slots_) {
+                bool expected = false;
+                if (candidate->owned.compare_exchange_strong(
+                        expected, true, std::memory_order_acquire)) {
+                    slot = candidate;
+                    break;
+                }
+            }
+            if (!slot) {
+                slot = make();
+                slots_.push_back(slot);
+            }
+            claimed(*slot);
+        }
+        claims_.fetch_add(1, std::memory_order_relaxed);
+        cache.entries.push_back({id_, std::move(slot)});
+        return *cache.entries.back().slot;
+    }
+
+    static inline std::atomic<uint64_t> next_id_{1};
+
+    uint64_t const id_;
+    std::atomic<uint64_t> claims_{0};
+    mutable std::mutex mtx_;
+    std::vector<std::shared_ptr<T>> slots_;
+};
+} // namespace scheduler::detail
@@ -0,0 +1,79 @@
+#pragma once
+#include "clock.h"
+#include "statistics_calculator.h"
+#include "task_queue.h"
+#include "timing_wheel.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace scheduler::detail {
+
+/**
+ * Thread that moves timers from a TimingWheel into a task queue when they
+ * are due.
+ *
+ * On Linux it sleeps in epoll_wait on a timerfd armed, in absolute
+ * CLOCK_MONOTONIC time, to the wheel's earliest expiry, and on an eventfd
+ * that stop() signals. Elsewhere it waits on a condition variable. The
+ * timer is only touched by rearm() when a timer earlier than the armed one
+ * arrives, so adding later timers costs no system call. Should arming the
+ * timerfd fail, the thread falls back to epoll_wait's millisecond timeout.
+ *
+ * After every wake the due fires go to the queue in one batch, `on_fire`
+ * is called with their number, and how late each fire was is recorded in jitter().
+ */
+class TimerThread {
+public:
+    TimerThread(std::shared_ptr<TimingWheel> timers,
+                std::shared_ptr<ITaskQueue> queue,
+                std::shared_ptr<IClock> clock,
+                std::function<void(size_t)> on_fire);
+    ~TimerThread();
+
+    TimerThread(TimerThread const&) = delete;
+    TimerThread& operator=(TimerThread const&) = delete;
+
+    void start();
+    void stop();
+
+    // call after adding a timer that fires at `at`
+    void rearm(time_point at);
+
+    IStatisticsCalculator& jitter() noexcept { return *jitter_; }
+
+private:
+    void run();
+    void wait();
+    void armLocked(time_point at);
+
+    std::shared_ptr<TimingWheel> timers_;
+    std::shared_ptr<ITaskQueue> queue_;
+    std::shared_ptr<IClock> clock_;
+    std::function<void(size_t)> on_fire_;
+    std::shared_ptr<IStatisticsCalculator> jitter_;
+
+    // Expiry the thread will wake up for, in steady_clock ticks; read
+    // unlocked by rearm() to skip timers behind it.
+    std::atomic<int64_t> armed_{INT64_MAX};
+    std::mutex arm_mutex_;
+    std::atomic<bool> stopping_{false};
+#if defined(__linux__)
+    // set when the timerfd could not be armed; wait() then times out on
+    // armed_ itself
+    std::atomic<bool> settime_failed_{false};
+    int timer_fd_ = -1;
+    int event_fd_ = -1;
+    int epoll_fd_ = -1;
+#else
+    std::condition_variable cv_;
+    bool rearmed_ = false;
+#endif
+    std::thread thread_;
+};
+} // namespace scheduler::detail
@@ -0,0 +1,141 @@
+#pragma once
+#include "scheduler/scheduler_options.h"
+#include "clock.h"
+#include "statistics_calculator.h"
+#include "task.h"
+#include "task_queue.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace scheduler::detail {
+
+// Callable of a recurring task, shared by the fires of its timer.
+struct RecurringCall {
+    explicit RecurringCall(InplaceTask&& fn) noexcept : fn{std::move(fn)} {}
+
+    InplaceTask fn;
+    // fixed-rate fires that are running or waiting on the running one
+    std::atomic<uint32_t> pending{0};
+};
+
+/**
+ * Hierarchical timing wheel for time-triggered tasks.
+ *
+ * kLevels wheels of kSlots slots each; a slot on level L spans
+ * kSlots^L ticks. A timer is filed on the lowest level whose span covers its
+ * distance from the current tick and cascades down one level whenever the
+ * wheel above it rolls over, so insert, cancel and expiry of a single timer
+ * are all O(1). Timers further out than the top level wrap around and are
+ * re-filed on every cascade.
+ *
+ * Due tasks are only moved into the priority queue by advance(), all fires of
+ * one call in a single batch. A task with a non-zero `interval` keeps firing
+ * until cancelled, as its RecurringOptions say. Runs of one timer never
+ * overlap: at a fixed rate a fire that comes due while the previous run is
+ * still going leaves its run to that one, which then runs again back to back
+ * (or just once more if missed fires are skipped). A fixed-delay timer is
+ * off the wheel while its fire runs; the fire files it again through
+ * resume() when it returns, which needs the wheel to be owned by a
+ * shared_ptr.
+ */
+class TimingWheel : public std::enable_shared_from_this<TimingWheel> {
+public:
+    using TimerId = uint64_t;
+    static constexpr TimerId kInvalidTimer = 0;
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 6;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+
+    /**
+     * @param sequence counter used to stamp fired tasks, so that they tie
+     * break FIFO against tasks scheduled directly
+     * @param tick resolution of the wheel, timers never fire early but may
+     * fire up to one tick late
+     * @param clock what the next fire of a fixed-delay timer is timed from
+     * once its run returns; the steady clock if null
+     */
+    explicit TimingWheel(std::atomic<uint64_t>& sequence,
+                         milliseconds tick = milliseconds{1},
+                         time_point origin = std::chrono::steady_clock::now(),
+                         std::shared_ptr<IClock> clock = nullptr);
+
+    TimerId schedule(Task&& task, time_point fire_at,
+                     RecurringOptions const& options = {});
+    // files a fixed-delay timer again after its fire has run
+    bool resume(TimerId id, time_point fire_at);
+    // called with the new expiry whenever resume() files a timer
+    void onResume(std::function<void(time_point)> listener);
+    // returns false if the timer already fired (one-off) or was cancelled
+    bool cancel(TimerId id);
+    // change what future fires are queued with; false if the timer is gone
+    bool reprioritize(TimerId id, int priority);
+    bool changeDeadline(TimerId id, std::optional<time_point> deadline);
+    // Moves every task due at or before `now` into `queue`. `jitter`, if
+    // given, records how many microseconds after its tick each fire was.
+    size_t advance(time_point now, ITaskQueue& queue,
+                   IStatisticsCalculator* jitter = nullptr);
+    // earliest time at which advance() may have work to do
+    std::optional<time_point> nextExpiry() const;
+
+    size_t size() const;
+    milliseconds tickResolution() const noexcept;
+    time_point now() const { return clock_->now(); }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr uint32_t kDueList = UINT32_MAX - 1;
+
+    struct Node {
+        std::optional<Task> task;
+        // callable of a recurring task, shared with its in-flight fires
+        std::shared_ptr<RecurringCall> recurring;
+        uint64_t expiry = 0;        // absolute tick
+        uint64_t due = 0;           // tick of the fire before slack
+        uint64_t align = 1;         // fires are moved to multiples of this
+        bool fixed_delay = false;
+        bool skip_missed = false;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t bucket = kNil;     // level * kSlots + slot, or kDueList
+        uint32_t generation = 1;
+    };
+
+    Node* findLocked(TimerId id) noexcept;
+    uint64_t toTick(time_point tp) const noexcept;
+    uint64_t firstTick(time_point tp) const noexcept;
+    void arm(uint32_t index, uint64_t due);
+    time_point toTime(uint64_t tick) const noexcept;
+    void file(uint32_t index);
+    void link(uint32_t index, uint32_t bucket);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(size_t level);
+    void expireList(uint32_t head);
+    uint64_t nextInterestingTick() const noexcept;
+
+    std::atomic<uint64_t>& sequence_;
+    std::shared_ptr<IClock> const clock_;
+    milliseconds tick_;
+    time_point origin_;
+    uint64_t current_ = 0;
+    uint64_t target_ = 0;        // tick advance() is heading for
+    std::array<uint32_t, kLevels * kSlots> heads_;
+    std::array<uint64_t, kLevels> occupied_{};
+    uint32_t due_ = kNil;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    std::vector<Task> fired_;  // fires of the current advance()
+    size_t live_ = 0;
+    size_t parked_ = 0;          // fixed-delay timers whose fire is out
+    std::function<void(time_point)> on_resume_;
+    mutable std::mutex mtx_;
+};
+} // namespace scheduler::detail
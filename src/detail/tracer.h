@@ -0,0 +1,76 @@
+#pragma once
+#include "detail/thread_slot_cache.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifndef SCHEDULER_TRACING
+#define SCHEDULER_TRACING 1
+#endif
+
+namespace scheduler::detail {
+
+// false when tracing is compiled out, which turns every call site into
+// dead code
+inline constexpr bool kTracingCompiled = SCHEDULER_TRACING != 0;
+
+/**
+ * Records the life of every task into per-thread rings and renders them as
+ * Chrome trace events, which Perfetto and chrome://tracing both open.
+ *
+ * The dispatcher records when a task was queued and dispatched, the worker
+ * when it started and ended; the two are joined on the task's sequence
+ * number when the trace is rendered. Every thread writes to a ring of its
+ * own, claimed from a ThreadSlotCache. A ring keeps the latest
+ * `events_per_thread` events and overwrites the oldest. Every slot has a
+ * version that is odd while it is written, so render() may run at any time
+ * and skips the slots it catches mid-write.
+ */
+class Tracer {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    explicit Tracer(size_t events_per_thread);
+
+    void dispatched(uint64_t task, time_point enqueued, time_point dispatched,
+                    int priority, size_t lane);
+    void ran(uint64_t task, time_point started, time_point ended);
+
+    // Chrome trace event JSON
+    std::string render() const;
+    // false if the file could not be written
+    bool write(std::string const& path) const;
+
+    enum class Kind : uint64_t { Dispatched = 1, Ran = 2 };
+
+    struct Slot {
+        std::atomic<uint64_t> version{0};
+        // kind and thread, task, two timestamps, priority and lane
+        std::array<std::atomic<uint64_t>, 5> words{};
+    };
+    // Written by one thread at a time; a thread that exits or runs out of
+    // cache entries hands its ring back for reuse.
+    struct alignas(64) Ring {
+        explicit Ring(size_t capacity);
+        std::unique_ptr<Slot[]> slots;
+        size_t mask;
+        std::atomic<uint64_t> head{0};
+        uint32_t thread = 0;  // trace id of the thread writing it
+        std::atomic<bool> owned{true};
+    };
+
+private:
+    Ring& local();
+    void record(Ring& ring, Kind kind, uint64_t task, time_point first,
+                time_point second, uint64_t extra);
+
+    size_t const capacity_;
+    time_point const origin_;
+    std::atomic<uint32_t> next_thread_{1};
+    ThreadSlotCache<Ring> rings_;
+};
+} // namespace scheduler::detail
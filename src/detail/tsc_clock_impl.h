@@ -0,0 +1,43 @@
+#pragma once
+#include "detail/clock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace scheduler::detail {
+
+/**
+ * Clock that reads the CPU's time stamp counter instead of calling into the
+ * vDSO.
+ *
+ * The counter is mapped onto the steady_clock timeline with a multiply and
+ * a shift, no division. The rate comes from a calibration against
+ * steady_clock that is done once per process. Each clock re-anchors itself
+ * to steady_clock about once a second and refines the rate over that
+ * second. Readings therefore stay within a few microseconds of
+ * steady_clock, and may step by that much at a re-anchor.
+ *
+ * Only usable where available() says the counter is invariant, i.e. runs
+ * at a constant rate in all power states and is synchronised across cores.
+ */
+class TscClock : public IClock {
+public:
+    static bool available() noexcept;
+
+    TscClock();
+    std::chrono::steady_clock::time_point now() const noexcept override;
+
+private:
+    static constexpr unsigned kShift = 32;
+
+    void reanchor() const noexcept;
+
+    // seqlock around the anchor; odd while a reader re-anchors
+    mutable std::atomic<uint32_t> seq_{0};
+    mutable std::atomic<uint64_t> base_tsc_{0};
+    mutable std::atomic<int64_t> base_ns_{0};
+    // nanoseconds per tick, scaled by 2^kShift
+    mutable std::atomic<uint64_t> mult_{0};
+    uint64_t refresh_ticks_ = 0;
+};
+} // namespace scheduler::detail
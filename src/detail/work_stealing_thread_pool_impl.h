@@ -0,0 +1,80 @@
+#pragma once
+#include "detail/thread_pool.h"
+#include "detail/chase_lev_deque.h"
+#include "detail/cpu_topology.h"
+#include "detail/ring_queue.h"
+#include "detail/worker_parking.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scheduler::detail {
+
+/**
+ * Thread pool where every worker owns a Chase-Lev deque.
+ *
+ * Jobs submitted from one of the pool's own workers go to that worker's
+ * deque, jobs submitted from any other thread go to the injection queue of
+ * a NUMA node (there is one node unless the WorkerPlacement is NUMA-aware).
+ * A worker looks for work in its own deque first, then in its node's
+ * injection queue, then steals from workers on its node; only after that
+ * does it turn to the other nodes' queues and workers. Workers only touch
+ * the injection locks when their deque is empty, and idle according to
+ * the pool's IdlePolicy.
+ */
+class WorkStealingThreadPool : public IThreadPool {
+public:
+    explicit WorkStealingThreadPool(
+        size_t numThreads, IdlePolicy idle = IdlePolicy::latencyOptimized(),
+        WorkerPlacement placement = {});
+    ~WorkStealingThreadPool();
+    bool submit(Job job) override;
+    bool submitBatch(std::span<Job> jobs) override;
+    bool submitToNode(std::span<Job> jobs, int node) override;
+    void recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                    std::shared_ptr<IClock> clock) override;
+    void start() override;
+    void stop() override;
+    size_t threadCount() const noexcept override;
+
+    // number of jobs taken from another worker's deque
+    uint64_t stealCount() const noexcept;
+    // number of times a worker ran out of work and went idle
+    uint64_t idleCount() const noexcept;
+    // the node queues and the worker each one is served by
+    WorkerPlan const& plan() const noexcept { return worker_plan; }
+
+private:
+    struct alignas(64) Worker {
+        ChaseLevDeque<Job> deque;
+        std::thread thread;
+    };
+
+    struct alignas(64) Injection {
+        RingQueue<Job*> jobs;
+        std::mutex mtx;
+    };
+
+    void workerLoop(size_t index);
+    bool inject(std::span<Job> jobs, size_t node);
+    Job* findWork(size_t index);
+    Job* takeInjected(size_t node);
+    Job* stealFrom(size_t index, bool same_node);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::unique_ptr<Injection>> injection;
+    // guards start/stop; stop also takes every injection lock
+    std::mutex queue_mutex;
+    std::atomic<bool> running;
+    std::atomic<size_t> pending;  // submitted but not yet picked up
+    std::atomic<uint64_t> steals;
+    std::atomic<uint64_t> idles;
+    std::atomic<size_t> next_node;
+    size_t thread_num;
+    WorkerPlan worker_plan;
+    WorkerParking parking;
+};
+} // namespace scheduler::detail
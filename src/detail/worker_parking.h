@@ -0,0 +1,193 @@
+#pragma once
+#include "detail/clock.h"
+#include "detail/metrics_recorder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace scheduler::detail {
+
+// How long an idle worker keeps looking for work before it parks.
+struct IdlePolicy {
+    uint32_t spin_iterations;   // busy polls with a pause hint in between
+    uint32_t yield_iterations;  // polls with std::this_thread::yield()
+
+    // picks up new work within a few hundred nanoseconds, burns some CPU
+    static constexpr IdlePolicy latencyOptimized() noexcept {
+        return {2048, 64};
+    }
+    // parks straight away, every wake goes through the kernel
+    static constexpr IdlePolicy cpuFrugal() noexcept {
+        return {0, 0};
+    }
+};
+
+inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Blocks while `word` still holds `expected`. On Linux this is a bare
+// futex; libstdc++'s atomic::wait adds its own spin and yield rounds and a
+// shared waiter table, which made a wake up cost a whole time slice on
+// small machines.
+// A zero `timeout` waits for as long as it takes.
+inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected,
+                      std::chrono::nanoseconds timeout = {}) noexcept {
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+    timespec ts{};
+    if (timeout > std::chrono::nanoseconds::zero()) {
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+        ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE,
+            expected, timeout > std::chrono::nanoseconds::zero() ? &ts : nullptr,
+            nullptr, 0);
+#else
+    if (timeout > std::chrono::nanoseconds::zero()) {
+        // no timed atomic wait, poll instead
+        std::this_thread::sleep_for(
+            std::min<std::chrono::nanoseconds>(timeout,
+                                               std::chrono::milliseconds{1}));
+    } else {
+        word.wait(expected, std::memory_order_seq_cst);
+    }
+#endif
+}
+
+inline void futexWake(std::atomic<uint32_t>& word, int count) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE,
+            count, nullptr, nullptr, 0);
+#else
+    if (count == 1) word.notify_one();
+    else word.notify_all();
+#endif
+}
+
+/**
+ * Spin, then yield, then park on a futex.
+ *
+ * Workers call idle() with a predicate that says whether there is work.
+ * Submitters publish their work with a seq_cst store and then call
+ * notify(); a parked worker is only woken when no worker is spinning,
+ * since a spinning one is about to pick the work up anyway. A worker that
+ * takes a job while more are queued calls notify(1) to pass the baton.
+ *
+ * Lost wakeups are ruled out by a Dekker handshake: the worker announces
+ * itself (spinning_ or parked_) before re-checking for work, the submitter
+ * publishes work before reading those counters, all with seq_cst.
+ *
+ * Once given a recorder, a parked worker counts the time it slept and
+ * whether a notify woke it. Only parking pays for that, it already costs
+ * a system call.
+ */
+class WorkerParking {
+public:
+    // Spinning only pays off when another core can run the submitter, so
+    // single-CPU hosts always park straight away.
+    explicit WorkerParking(IdlePolicy policy) noexcept
+    : policy_{std::thread::hardware_concurrency() > 1 ? policy
+                                                     : IdlePolicy::cpuFrugal()} {}
+
+    // Returns once `ready()` holds, after a wake up or once a non-zero
+    // `timeout` has passed while parked; true if the worker had to park.
+    template <typename Ready>
+    bool idle(Ready&& ready, std::chrono::nanoseconds timeout = {}) {
+        if (policy_.spin_iterations + policy_.yield_iterations > 0) {
+            spinning_.fetch_add(1, std::memory_order_seq_cst);
+            bool found = false;
+            for (uint32_t i = 0; i < policy_.spin_iterations && !found; ++i) {
+                found = ready();
+                if (!found) cpuRelax();
+            }
+            for (uint32_t i = 0; i < policy_.yield_iterations && !found; ++i) {
+                found = ready();
+                if (!found) std::this_thread::yield();
+            }
+            spinning_.fetch_sub(1, std::memory_order_seq_cst);
+            if (found) return false;
+        }
+
+        parked_.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+        // a spurious return just sends the worker round its loop again
+        if (!ready()) park(epoch, timeout);
+        parked_.fetch_sub(1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Where parked time and wake ups go; set before any worker idles.
+    void recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                    std::shared_ptr<IClock> clock) noexcept {
+        metrics_ = std::move(metrics);
+        clock_ = std::move(clock);
+    }
+
+    // Wakes up to `count` parked workers unless someone is spinning.
+    // Returns how many of `count` jobs the workers found here cover.
+    size_t notify(size_t count) {
+        size_t spinning = spinning_.load(std::memory_order_seq_cst);
+        if (spinning > 0) return std::min(count, spinning);
+        size_t parked = parked_.load(std::memory_order_seq_cst);
+        if (parked == 0) return 0;
+
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        futexWake(epoch_, count >= parked ? INT_MAX : static_cast<int>(count));
+        return std::min(count, parked);
+    }
+
+    void notifyAll() {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        futexWake(epoch_, INT_MAX);
+    }
+
+    IdlePolicy policy() const noexcept { return policy_; }
+    // workers currently spinning or parked
+    size_t idleWorkers() const noexcept {
+        return spinning_.load(std::memory_order_seq_cst) +
+               parked_.load(std::memory_order_seq_cst);
+    }
+
+private:
+    void park(uint32_t epoch, std::chrono::nanoseconds timeout) {
+        if (!metrics_) {
+            futexWait(epoch_, epoch, timeout);
+            return;
+        }
+        auto parked_at = clock_->now();
+        futexWait(epoch_, epoch, timeout);
+        auto parked_for = clock_->now() - parked_at;
+        metrics_->add(Counter::ParkedNanos, uint64_t(
+            std::max(parked_for, decltype(parked_for){0}).count()));
+        // a timeout leaves the epoch as it was
+        if (epoch_.load(std::memory_order_relaxed) != epoch) {
+            metrics_->add(Counter::WorkerWakeups);
+        }
+    }
+
+    IdlePolicy policy_;
+    std::shared_ptr<MetricsRecorder> metrics_;
+    std::shared_ptr<IClock> clock_;
+    alignas(64) std::atomic<uint32_t> spinning_{0};
+    alignas(64) std::atomic<uint32_t> parked_{0};
+    alignas(64) std::atomic<uint32_t> epoch_{0};
+};
+} // namespace scheduler::detail
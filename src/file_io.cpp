@@ -0,0 +1,17 @@
+#include "detail/file_io.h"
+#include <cstdio>
+
+bool scheduler::detail::writeFileAtomically(std::string const& path,
+                                            std::string_view text) {
+    std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "w");
+    if (!file) return false;
+    bool written = std::fwrite(text.data(), 1, text.size(), file) ==
+                   text.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,220 @@
+#include "detail/group_queue_impl.h"
+#include <algorithm>
+
+using namespace scheduler::detail;
+
+namespace {
+// the least a dispatched task is charged up front, so that a group none of
+// whose tasks has finished yet still takes turns
+constexpr std::chrono::nanoseconds kMinCost{1000};
+
+std::chrono::nanoseconds upFront(std::chrono::nanoseconds estimate) {
+    return std::max(estimate, kMinCost);
+}
+}
+
+GroupQueue::GroupQueue(std::vector<TaskGroup> const& groups,
+                       std::shared_ptr<IClock> clock)
+: clock_{std::move(clock)}, groups_(std::max<size_t>(groups.size(), 1)) {
+    auto now = clock_->now();
+    for (size_t i = 0; i < groups.size(); ++i) {
+        groups_[i].weight = std::max<uint32_t>(groups[i].weight, 1);
+        if (auto const& quota = groups[i].quota) {
+            groups_[i].budget = quota->budget;
+            groups_[i].period = std::max<std::chrono::nanoseconds>(
+                quota->period, std::chrono::milliseconds{1});
+            groups_[i].period_end = now + groups_[i].period;
+            quotas_ = true;
+        }
+    }
+}
+
+// Ends the quota periods that are over, paying back one budget for each
+void GroupQueue::refill(Group& group, time_point now) const {
+    if (now < group.period_end) return;
+    auto periods = (now - group.period_end) / group.period + 1;
+    int64_t used = group.used.load(std::memory_order_relaxed);
+    int64_t paid = std::min(used, (periods * group.budget).count());
+    // finished() may add to it meanwhile
+    group.used.fetch_sub(paid, std::memory_order_relaxed);
+    group.period_end += periods * group.period;
+}
+
+// Folds in what finished() recorded since the last call
+void GroupQueue::settle(Group& group, time_point now) const {
+    group.vtime += double(group.owed.exchange(0, std::memory_order_relaxed)) /
+                   group.weight;
+    if (group.budget.count() == 0) return;
+
+    refill(group, now);
+    bool over = group.used.load(std::memory_order_relaxed) >=
+                group.budget.count();
+    if (over != group.throttled) {
+        group.throttled = over;
+        if (over) {
+            group.throttles += 1;
+            ++throttled_;
+        } else {
+            --throttled_;
+        }
+    }
+}
+
+void GroupQueue::settleAll() const {
+    auto now = quotas_ ? clock_->now() : time_point{};
+    for (Group& group : groups_) settle(group, now);
+}
+
+GroupQueue::Group* GroupQueue::next() const {
+    Group* best = nullptr;
+    for (Group& group : groups_) {
+        if (group.heap.empty() || group.throttled) continue;
+        if (!best || group.vtime < best->vtime) best = &group;
+    }
+    return best;
+}
+
+void GroupQueue::enqueue(Task&& task) {
+    Group& group = groups_[task.group];
+    // an idle group starts over at the current virtual time
+    if (group.heap.empty()) group.vtime = std::max(group.vtime, virtual_now_);
+    group.heap.push(std::move(task));
+}
+
+void GroupQueue::push(Task&& task) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    enqueue(std::move(task));
+    size_.fetch_add(1, std::memory_order_release);
+}
+
+void GroupQueue::pushBatch(std::span<Task> tasks) {
+    if (tasks.empty()) return;
+    std::lock_guard<std::mutex> guard{mtx_};
+    for (Task& task : tasks) enqueue(std::move(task));
+    size_.fetch_add(tasks.size(), std::memory_order_release);
+}
+
+std::optional<Task> GroupQueue::pop() {
+    std::lock_guard<std::mutex> guard{mtx_};
+    settleAll();
+    Group* group = next();
+    if (!group) return std::nullopt;
+
+    virtual_now_ = group->vtime;
+    std::chrono::nanoseconds estimate{
+        group->estimate.load(std::memory_order_relaxed)};
+    group->vtime += double(upFront(estimate).count()) / group->weight;
+    size_.fetch_sub(1, std::memory_order_release);
+    return group->heap.pop();
+}
+
+std::optional<std::reference_wrapper<const Task>> GroupQueue::peek() const {
+    std::lock_guard<std::mutex> guard{mtx_};
+    settleAll();
+    Group* group = next();
+    if (!group) return std::nullopt;
+    return std::cref(group->heap.top());
+}
+
+void GroupQueue::finished(uint32_t index, std::chrono::nanoseconds ran) {
+    int64_t nanos = std::max<int64_t>(ran.count(), 0);
+    Group& group = groups_[index];
+    int64_t estimate = group.estimate.load(std::memory_order_relaxed);
+    while (!group.estimate.compare_exchange_weak(
+        estimate, estimate + (nanos - estimate) / 8,
+        std::memory_order_relaxed)) {
+    }
+    // settles the up-front charge, so that groups pay what they ran
+    group.owed.fetch_add(
+        nanos - upFront(std::chrono::nanoseconds{estimate}).count(),
+        std::memory_order_relaxed);
+    group.used.fetch_add(nanos, std::memory_order_relaxed);
+    group.busy.fetch_add(nanos, std::memory_order_relaxed);
+    group.completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::optional<time_point> GroupQueue::nextRefill() const {
+    std::lock_guard<std::mutex> guard{mtx_};
+    settleAll();
+    std::optional<time_point> earliest;
+    if (throttled_ == 0) return earliest;
+    for (Group const& group : groups_) {
+        if (!group.throttled || group.heap.empty()) continue;
+        // the period in which enough of the overshoot is paid back
+        std::chrono::nanoseconds used{
+            group.used.load(std::memory_order_relaxed)};
+        auto periods = (used - group.budget) / group.budget;
+        auto at = group.period_end + periods * group.period;
+        if (!earliest || at < *earliest) earliest = at;
+    }
+    return earliest;
+}
+
+void GroupQueue::liftQuotas() {
+    std::lock_guard<std::mutex> guard{mtx_};
+    for (Group& group : groups_) {
+        group.budget = std::chrono::nanoseconds{0};
+        group.throttled = false;
+    }
+    throttled_ = 0;
+    quotas_ = false;
+}
+
+scheduler::GroupStats GroupQueue::stats(uint32_t index) const {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Group& group = groups_[index];
+    settle(group, quotas_ ? clock_->now() : time_point{});
+    GroupStats stats;
+    stats.completed = group.completed.load(std::memory_order_relaxed);
+    stats.busy_time =
+        std::chrono::nanoseconds{group.busy.load(std::memory_order_relaxed)};
+    stats.throttled = group.throttles;
+    stats.queued = group.heap.size();
+    return stats;
+}
+
+Task* GroupQueue::find(TaskState const& state) {
+    for (Group& group : groups_) {
+        if (Task* task = group.heap.find(state)) return task;
+    }
+    return nullptr;
+}
+
+std::optional<Task> GroupQueue::erase(TaskState const& state) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Task* task = find(state);
+    if (!task) return std::nullopt;
+    Task removed = groups_[task->group].heap.erase(*task);
+    size_.fetch_sub(1, std::memory_order_release);
+    return removed;
+}
+
+bool GroupQueue::reprioritize(TaskState const& state, int priority) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Task* task = find(state);
+    if (!task) return false;
+    task->priority = priority;
+    groups_[task->group].heap.update(*task);
+    return true;
+}
+
+bool GroupQueue::changeDeadline(TaskState const& state,
+                                std::optional<time_point> deadline) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Task* task = find(state);
+    if (!task) return false;
+    task->deadline = deadline;
+    groups_[task->group].heap.update(*task);
+    return true;
+}
+
+bool GroupQueue::empty() const {
+    if (size_.load(std::memory_order_acquire) == 0) return true;
+    std::lock_guard<std::mutex> guard{mtx_};
+    settleAll();
+    return next() == nullptr;
+}
+
+size_t GroupQueue::size() const {
+    return size_.load(std::memory_order_acquire);
+}
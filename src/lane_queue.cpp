@@ -0,0 +1,89 @@
+#include "detail/lane_queue_impl.h"
+#include <algorithm>
+
+using namespace scheduler::detail;
+
+LaneQueue::LaneQueue(std::vector<int> floors,
+                     std::vector<std::shared_ptr<ITaskQueue>> lanes)
+: floors_{std::move(floors)}, lanes_{std::move(lanes)} {}
+
+size_t LaneQueue::laneOf(int priority) const noexcept {
+    for (size_t i = 0; i + 1 < floors_.size(); ++i) {
+        if (priority >= floors_[i]) return i;
+    }
+    return lanes_.size() - 1;
+}
+
+void LaneQueue::push(Task&& task) {
+    lanes_[laneOf(task.priority)]->push(std::move(task));
+}
+
+void LaneQueue::pushBatch(std::span<Task> tasks) {
+    if (tasks.empty()) return;
+    size_t first = laneOf(tasks.front().priority);
+    bool one_lane = std::all_of(tasks.begin(), tasks.end(), [&](Task const& t) {
+        return laneOf(t.priority) == first;
+    });
+    if (one_lane) {
+        lanes_[first]->pushBatch(tasks);
+        return;
+    }
+
+    // one locked insert per lane
+    std::vector<std::vector<Task>> split(lanes_.size());
+    for (Task& task : tasks) {
+        split[laneOf(task.priority)].push_back(std::move(task));
+    }
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        if (!split[i].empty()) lanes_[i]->pushBatch(split[i]);
+    }
+}
+
+std::optional<Task> LaneQueue::pop() {
+    for (auto& lane : lanes_) {
+        if (auto task = lane->pop()) return task;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::reference_wrapper<const Task>> LaneQueue::peek() const {
+    for (auto const& lane : lanes_) {
+        if (auto task = lane->peek()) return task;
+    }
+    return std::nullopt;
+}
+
+std::optional<Task> LaneQueue::erase(TaskState const& state) {
+    for (auto& lane : lanes_) {
+        if (auto task = lane->erase(state)) return task;
+    }
+    return std::nullopt;
+}
+
+bool LaneQueue::reprioritize(TaskState const& state, int priority) {
+    for (auto& lane : lanes_) {
+        if (lane->reprioritize(state, priority)) return true;
+    }
+    return false;
+}
+
+bool LaneQueue::changeDeadline(TaskState const& state,
+                               std::optional<time_point> deadline) {
+    for (auto& lane : lanes_) {
+        if (lane->changeDeadline(state, deadline)) return true;
+    }
+    return false;
+}
+
+bool LaneQueue::empty() const {
+    for (auto const& lane : lanes_) {
+        if (!lane->empty()) return false;
+    }
+    return true;
+}
+
+size_t LaneQueue::size() const {
+    size_t total = 0;
+    for (auto const& lane : lanes_) total += lane->size();
+    return total;
+}
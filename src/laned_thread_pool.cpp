@@ -0,0 +1,189 @@
+#include "detail/laned_thread_pool_impl.h"
+#include <algorithm>
+
+using namespace scheduler::detail;
+
+namespace {
+// lanes share one queue per lane, not one per node, see
+// SchedulerOptions::lanes
+scheduler::WorkerPlacement withoutNuma(scheduler::WorkerPlacement placement) {
+    placement.numa = false;
+    return placement;
+}
+}
+
+LanedThreadPool::LanedThreadPool(size_t numThreads,
+                                 std::vector<LaneWorkers> lane_config,
+                                 IdlePolicy idle, WorkerPlacement placement)
+: lane_workers{std::move(lane_config)}, running{false},
+  thread_num{numThreads > 0 ? numThreads : 1},
+  worker_plan{planWorkers(thread_num, withoutNuma(std::move(placement)), {})} {
+    if (lane_workers.empty()) lane_workers.push_back({});
+
+    // leave at least one worker for every lane
+    size_t spare = thread_num - 1;
+    for (LaneWorkers& lane : lane_workers) {
+        lane.reserved = std::min(lane.reserved, spare);
+        spare -= lane.reserved;
+    }
+
+    size_t lane_count = lane_workers.size();
+    for (size_t i = 0; i < lane_count; ++i) {
+        lanes.push_back(std::make_unique<LaneJobs>());
+    }
+    for (size_t i = 0; i <= lane_count; ++i) {
+        parkings.push_back(std::make_unique<WorkerParking>(idle));
+    }
+
+    for (size_t lane = 0; lane < lane_count; ++lane) {
+        Role role{{lane}, lane};
+        if (lane_workers[lane].borrow) {
+            for (size_t lower = lane + 1; lower < lane_count; ++lower) {
+                role.lanes.push_back(lower);
+            }
+        }
+        roles.insert(roles.end(), lane_workers[lane].reserved, role);
+    }
+    Role shared{{}, lane_count};
+    for (size_t lane = 0; lane < lane_count; ++lane) shared.lanes.push_back(lane);
+    roles.resize(thread_num, shared);
+}
+
+LanedThreadPool::~LanedThreadPool() {
+    stop();
+}
+
+void LanedThreadPool::start() {
+    {
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (running.load(std::memory_order_relaxed)) return;
+        running.store(true, std::memory_order_seq_cst);
+    }
+
+    threads.reserve(thread_num);
+    for (size_t i = 0; i < thread_num; ++i) {
+        threads.emplace_back([this, i]{
+            auto const& cpus = worker_plan.workers[i].cpus;
+            if (!cpus.empty()) pinCurrentThread(cpus);
+            this->workerLoop(roles[i]);
+        });
+    }
+}
+
+void LanedThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (!running.load(std::memory_order_relaxed)) return;
+        running.store(false, std::memory_order_seq_cst);
+    }
+
+    for (auto& parking : parkings) parking->notifyAll();
+    for (std::thread& active_thread : threads) {
+        active_thread.join();
+    }
+    threads.clear();
+}
+
+bool LanedThreadPool::submit(Job job) {
+    return submitToLane(std::span<Job>{&job, 1}, lanes.size() - 1);
+}
+
+bool LanedThreadPool::submitBatch(std::span<Job> jobs) {
+    return submitToLane(jobs, lanes.size() - 1);
+}
+
+bool LanedThreadPool::submitToLane(std::span<Job> jobs, size_t lane) {
+    if (jobs.empty()) return true;
+    lane = std::min(lane, lanes.size() - 1);
+    {
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (!running.load(std::memory_order_relaxed)) return false;
+        for (Job& job : jobs) lanes[lane]->jobs.emplace_back(std::move(job));
+        lanes[lane]->queued.fetch_add(jobs.size(), std::memory_order_seq_cst);
+    }
+    wakeFor(lane, jobs.size());
+    return true;
+}
+
+// The lane's own workers first, then those of lanes that borrow from it,
+// then the shared ones; `count` wakes in all.
+void LanedThreadPool::wakeFor(size_t lane, size_t count) {
+    count -= parkings[lane]->notify(count);
+    for (size_t upper = 0; upper < lane && count > 0; ++upper) {
+        if (lane_workers[upper].borrow && lane_workers[upper].reserved > 0) {
+            count -= parkings[upper]->notify(count);
+        }
+    }
+    if (count > 0) parkings.back()->notify(count);
+}
+
+size_t LanedThreadPool::laneCapacity(size_t lane) const noexcept {
+    if (lane >= lanes.size()) return 0;
+    size_t capacity = thread_num;
+    for (size_t other = 0; other < lanes.size(); ++other) {
+        bool serves = other == lane ||
+                      (other < lane && lane_workers[other].borrow);
+        if (!serves) capacity -= lane_workers[other].reserved;
+    }
+    return capacity;
+}
+
+void LanedThreadPool::recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                                 std::shared_ptr<IClock> clock) {
+    for (auto& parking : parkings) parking->recordInto(metrics, clock);
+}
+
+size_t LanedThreadPool::reservedWorkers(size_t lane) const noexcept {
+    return lane < lane_workers.size() ? lane_workers[lane].reserved : 0;
+}
+
+bool LanedThreadPool::hasWork(Role const& role) const noexcept {
+    if (!running.load(std::memory_order_seq_cst)) return true;
+    for (size_t lane : role.lanes) {
+        if (lanes[lane]->queued.load(std::memory_order_seq_cst) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LanedThreadPool::pop(Role const& role, Job& job, size_t& lane) {
+    std::lock_guard<std::mutex> lock{queue_mutex};
+    for (size_t index : role.lanes) {
+        auto& queue = lanes[index]->jobs;
+        if (queue.empty()) continue;
+        job = std::move(queue.front());
+        queue.pop_front();
+        lane = index;
+        return true;
+    }
+    return false;
+}
+
+void LanedThreadPool::workerLoop(Role const& role) {
+    WorkerParking& parking = *parkings[role.group];
+    while (true) {
+        bool stopping = !running.load(std::memory_order_seq_cst);
+        Job job;
+        size_t lane = 0;
+        if (!pop(role, job, lane)) {
+            if (stopping) break; // drain all jobs before exit
+            parking.idle([this, &role]{ return hasWork(role); });
+            continue;
+        }
+        // more queued than this worker can take, pass the baton
+        if (lanes[lane]->queued.fetch_sub(1, std::memory_order_seq_cst) > 1) {
+            wakeFor(lane, 1);
+        }
+
+        try {
+            job();
+        } catch (...) {
+            // handle or log accordingly
+        }
+    }
+}
+
+size_t LanedThreadPool::threadCount() const noexcept {
+    return thread_num;
+}
@@ -0,0 +1,100 @@
+#include "scheduler/latency_histogram.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using namespace scheduler;
+
+namespace {
+constexpr std::size_t kHalf =
+    std::size_t{1} << (LatencyHistogram::kSubBucketBits - 1);
+constexpr std::int64_t kLinearLimit =
+    std::int64_t{1} << LatencyHistogram::kSubBucketBits;
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::int64_t value) noexcept {
+    if (value < kLinearLimit) return value < 0 ? 0 : std::size_t(value);
+
+    auto v = static_cast<std::uint64_t>(value);
+    int msb = 63 - std::countl_zero(v);
+    if (msb >= kMaxValueBits) return kBucketCount - 1;
+    int shift = msb - (kSubBucketBits - 1);
+    // v >> shift lands in [kHalf, 2 * kHalf)
+    return std::size_t(shift) * kHalf + std::size_t(v >> shift);
+}
+
+std::int64_t LatencyHistogram::bucketLowest(std::size_t bucket) noexcept {
+    if (bucket < std::size_t(kLinearLimit)) return std::int64_t(bucket);
+    std::size_t shift = bucket / kHalf - 1;
+    return std::int64_t(bucket % kHalf + kHalf) << shift;
+}
+
+std::int64_t LatencyHistogram::bucketHighest(std::size_t bucket) noexcept {
+    if (bucket < std::size_t(kLinearLimit)) return std::int64_t(bucket);
+    std::size_t shift = bucket / kHalf - 1;
+    return ((std::int64_t(bucket % kHalf + kHalf) + 1) << shift) - 1;
+}
+
+LatencyHistogram::LatencyHistogram() : counts_(kBucketCount, 0) {}
+
+LatencyHistogram::LatencyHistogram(std::vector<std::uint64_t> counts,
+                                   std::int64_t sum)
+: counts_{std::move(counts)}, sum_{sum} {
+    counts_.resize(kBucketCount, 0);
+    for (auto n : counts_) total_ += n;
+}
+
+void LatencyHistogram::record(std::int64_t value) {
+    ++counts_[bucketIndex(value)];
+    ++total_;
+    sum_ += value;
+}
+
+void LatencyHistogram::merge(LatencyHistogram const& other) {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+}
+
+std::uint64_t LatencyHistogram::countAt(std::size_t bucket) const noexcept {
+    return bucket < counts_.size() ? counts_[bucket] : 0;
+}
+
+std::int64_t LatencyHistogram::min() const noexcept {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        if (counts_[i]) return bucketLowest(i);
+    }
+    return 0;
+}
+
+std::int64_t LatencyHistogram::max() const noexcept {
+    for (std::size_t i = kBucketCount; i-- > 0;) {
+        if (counts_[i]) return bucketHighest(i);
+    }
+    return 0;
+}
+
+double LatencyHistogram::mean() const noexcept {
+    return total_ ? double(sum_) / double(total_) : 0.0;
+}
+
+std::int64_t
+LatencyHistogram::valueAtPercentile(double percentile) const noexcept {
+    if (total_ == 0) return 0;
+    if (percentile <= 0.0) return min();
+
+    percentile = std::min(percentile, 100.0);
+    // the epsilon keeps e.g. 99.9% of 1000 from rounding up to 1000
+    auto target = static_cast<std::uint64_t>(
+        std::ceil(percentile / 100.0 * double(total_) - 1e-9));
+    target = std::clamp<std::uint64_t>(target, 1, total_);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= target) return bucketHighest(i);
+    }
+    return max();
+}
@@ -0,0 +1,222 @@
+#include "scheduler/metrics.h"
+#include "detail/file_io.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace scheduler;
+
+namespace {
+class PrometheusWriter {
+public:
+    explicit PrometheusWriter(std::string_view prefix) : prefix_{prefix} {}
+
+    void metric(char const* name, char const* type, char const* help,
+                double value) {
+        header(name, type, help);
+        sample(name, "", value);
+    }
+
+    void summary(char const* name, char const* help,
+                 LatencyHistogram const& histogram) {
+        header(name, "summary", help);
+        for (double q : {0.5, 0.9, 0.99, 0.999}) {
+            char label[32];
+            std::snprintf(label, sizeof(label), "{quantile=\"%g\"}", q);
+            sample(name, label,
+                   double(histogram.valueAtPercentile(q * 100.0)));
+        }
+        sample(name, "_sum", histogram.mean() * double(histogram.count()));
+        sample(name, "_count", double(histogram.count()));
+    }
+
+    std::string take() { return std::move(out_); }
+
+private:
+    void header(char const* name, char const* type, char const* help) {
+        out_ += "# HELP ";
+        out_ += prefix_;
+        out_ += '_';
+        out_ += name;
+        out_ += ' ';
+        out_ += help;
+        out_ += "\n# TYPE ";
+        out_ += prefix_;
+        out_ += '_';
+        out_ += name;
+        out_ += ' ';
+        out_ += type;
+        out_ += '\n';
+    }
+
+    void sample(char const* name, char const* suffix, double value) {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.17g", value);
+        out_ += prefix_;
+        out_ += '_';
+        out_ += name;
+        out_ += suffix;
+        out_ += ' ';
+        out_ += number;
+        out_ += '\n';
+    }
+
+    std::string_view prefix_;
+    std::string out_;
+};
+
+double seconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+[[noreturn]] void throwErrno(char const* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+}
+
+std::string scheduler::toPrometheusText(MetricsSnapshot const& s,
+                                        std::string_view prefix) {
+    PrometheusWriter out{prefix};
+    out.metric("tasks_submitted_total", "counter",
+               "Tasks queued by callers.", double(s.submitted));
+    out.metric("timer_fires_total", "counter",
+               "Recurring and sleeping tasks queued by their timer.",
+               double(s.timer_fires));
+    out.metric("tasks_dispatched_total", "counter",
+               "Tasks handed to the worker pool.", double(s.dispatched));
+    out.metric("tasks_completed_total", "counter",
+               "Tasks that finished running.", double(s.completed));
+    out.metric("tasks_rejected_total", "counter",
+               "Tasks the worker pool refused.", double(s.rejected));
+    out.metric("tasks_refused_total", "counter",
+               "Tasks not queued because the queues were full.",
+               double(s.refused));
+    out.metric("tasks_cancelled_total", "counter",
+               "Cancelled tasks dropped before they ran.",
+               double(s.cancelled));
+    out.metric("dispatcher_wakeups_total", "counter",
+               "Times the dispatcher woke up.",
+               double(s.dispatcher_wakeups));
+    out.metric("worker_busy_seconds_total", "counter",
+               "Time workers spent running tasks.", seconds(s.busy_time));
+    out.metric("worker_parked_seconds_total", "counter",
+               "Time idle workers spent parked.", seconds(s.parked_time));
+    out.metric("worker_wakeups_total", "counter",
+               "Times a parked worker was woken for new work.",
+               double(s.worker_wakeups));
+    out.metric("deadlines_met_total", "counter",
+               "Tasks that finished by their deadline.",
+               double(s.deadlines.met));
+    out.metric("deadlines_missed_total", "counter",
+               "Tasks that finished after their deadline.",
+               double(s.deadlines.missed));
+    out.metric("deadlines_shed_total", "counter",
+               "Tasks dropped or diverted as out of reach of their deadline.",
+               double(s.deadlines.shed));
+    out.metric("deadlines_demoted_total", "counter",
+               "Tasks requeued without their deadline.",
+               double(s.deadlines.demoted));
+    out.metric("workers_grown_total", "counter",
+               "Workers added by the elastic pool.",
+               double(s.workers.grown));
+    out.metric("workers_retired_total", "counter",
+               "Workers retired by the elastic pool.",
+               double(s.workers.retired));
+    out.metric("workers_compensating_total", "counter",
+               "Workers started for ones in a BlockingScope.",
+               double(s.workers.compensating));
+    out.metric("queue_depth", "gauge",
+               "Tasks waiting to be dispatched.", double(s.queue_depth));
+    out.metric("queue_bytes", "gauge",
+               "Approximate memory of the waiting tasks.",
+               double(s.queue_bytes));
+    out.metric("tasks_in_flight", "gauge",
+               "Tasks dispatched but not finished.", double(s.in_flight));
+    out.metric("workers", "gauge", "Live workers.", double(s.workers.live));
+    out.metric("uptime_seconds", "gauge",
+               "Time since the scheduler started.", seconds(s.uptime));
+    out.summary("latency_microseconds",
+                "Time from enqueue to start since the last reset.",
+                s.latency);
+    out.summary("timer_jitter_microseconds",
+                "How late timers were queued since the last reset.",
+                s.timer_jitter);
+    return out.take();
+}
+
+bool scheduler::writePrometheusFile(MetricsSnapshot const& snapshot,
+                                    std::string const& path,
+                                    std::string_view prefix) {
+    return detail::writeFileAtomically(path,
+                                       toPrometheusText(snapshot, prefix));
+}
+
+MetricsServer::MetricsServer(std::string socket_path,
+                             std::function<MetricsSnapshot()> source,
+                             std::string prefix)
+: path_{std::move(socket_path)}, source_{std::move(source)},
+  prefix_{std::move(prefix)} {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path_.size() >= sizeof(address.sun_path)) {
+        throw std::system_error(std::make_error_code(
+            std::errc::filename_too_long), "MetricsServer");
+    }
+    std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) throwErrno("socket");
+    unlink(path_.c_str());
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+        listen(listen_fd_, 16) != 0) {
+        int error = errno;
+        close(listen_fd_);
+        errno = error;
+        throwErrno("bind/listen");
+    }
+    thread_ = std::thread([this] { serve(); });
+}
+
+MetricsServer::~MetricsServer() {
+    stopping_.store(true, std::memory_order_release);
+    // makes the blocked accept() return
+    shutdown(listen_fd_, SHUT_RDWR);
+    thread_.join();
+    close(listen_fd_);
+    unlink(path_.c_str());
+}
+
+void MetricsServer::serve() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        std::string response =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n\r\n";
+        response += toPrometheusText(source_(), prefix_);
+        for (size_t sent = 0; sent < response.size();) {
+            auto n = send(client, response.data() + sent,
+                          response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += size_t(n);
+        }
+        // Closing with an unread request in the buffer would reset the
+        // connection and could cut the response short, so drain it first.
+        shutdown(client, SHUT_WR);
+        pollfd readable{client, POLLIN, 0};
+        char discard[512];
+        while (poll(&readable, 1, 50) > 0 &&
+               recv(client, discard, sizeof(discard), MSG_DONTWAIT) > 0) {}
+        close(client);
+    }
+}
@@ -0,0 +1,16 @@
+#include "detail/metrics_recorder.h"
+
+using namespace scheduler::detail;
+
+MetricsRecorder::Block& MetricsRecorder::local() {
+    return blocks_.local([] { return std::make_shared<Block>(); });
+}
+
+uint64_t MetricsRecorder::total(Counter counter) const {
+    uint64_t sum = 0;
+    blocks_.forEach([&](Block const& block) {
+        sum += block.values[static_cast<size_t>(counter)].load(
+            std::memory_order_relaxed);
+    });
+    return sum;
+}
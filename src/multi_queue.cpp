@@ -0,0 +1,224 @@
+#include "detail/multi_queue_impl.h"
+#include <algorithm>
+
+using namespace scheduler::detail;
+
+namespace {
+constexpr int kSampleAttempts = 8;
+
+uint64_t nextRandom() noexcept {
+    thread_local uint64_t state =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+    // xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+}
+
+MultiQueue::MultiQueue(size_t shardCount, Mode mode)
+: mode_{mode}, size_{0} {
+    if (shardCount == 0) shardCount = 1;
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+void MultiQueue::refreshTop(Shard& shard) noexcept {
+    if (shard.heap.empty()) {
+        shard.has_top.store(false, std::memory_order_relaxed);
+        return;
+    }
+    TaskKey const& top = shard.heap.topKey();
+    shard.top_deadline.store(top.deadline, std::memory_order_relaxed);
+    shard.top_priority.store(top.priority, std::memory_order_relaxed);
+    shard.has_top.store(true, std::memory_order_relaxed);
+}
+
+// Compares cached heads, mirrors TaskKey::operator< without the FIFO
+// tie-break.
+bool MultiQueue::headBetter(Shard const& a, Shard const& b) noexcept {
+    if (!a.has_top.load(std::memory_order_relaxed)) return false;
+    if (!b.has_top.load(std::memory_order_relaxed)) return true;
+    auto a_deadline = a.top_deadline.load(std::memory_order_relaxed);
+    auto b_deadline = b.top_deadline.load(std::memory_order_relaxed);
+    if (a_deadline != b_deadline) return a_deadline < b_deadline;
+    return a.top_priority.load(std::memory_order_relaxed) <
+           b.top_priority.load(std::memory_order_relaxed);
+}
+
+Task MultiQueue::popLocked(Shard& shard) {
+    Task task = shard.heap.pop();
+    refreshTop(shard);
+    return task;
+}
+
+size_t MultiQueue::randomShard() const noexcept {
+    return static_cast<size_t>(nextRandom() % shards_.size());
+}
+
+void MultiQueue::push(Task&& task) {
+    size_t index = randomShard();
+    Shard* shard = shards_[index].get();
+    std::unique_lock<std::mutex> lock{shard->mtx, std::try_to_lock};
+    if (!lock.owns_lock()) {
+        // contended, move on to another shard rather than wait
+        index = randomShard();
+        shard = shards_[index].get();
+        lock = std::unique_lock<std::mutex>{shard->mtx};
+    }
+    if (task.state) {
+        task.state->shard.store(static_cast<uint32_t>(index),
+                                std::memory_order_relaxed);
+    }
+    // count first so that a concurrent pop never drives size_ below zero
+    size_.fetch_add(1, std::memory_order_release);
+    shard->heap.push(std::move(task));
+    refreshTop(*shard);
+}
+
+void MultiQueue::pushBatch(std::span<Task> tasks) {
+    if (tasks.empty()) return;
+
+    size_t parts = std::min(shards_.size(), tasks.size());
+    size_t start = randomShard();
+    size_.fetch_add(tasks.size(), std::memory_order_release);
+    for (size_t part = 0; part < parts; ++part) {
+        size_t begin = tasks.size() * part / parts;
+        size_t end = tasks.size() * (part + 1) / parts;
+        size_t index = (start + part) % shards_.size();
+        Shard& shard = *shards_[index];
+        std::lock_guard<std::mutex> guard{shard.mtx};
+        auto chunk = tasks.subspan(begin, end - begin);
+        for (Task& task : chunk) {
+            if (!task.state) continue;
+            task.state->shard.store(static_cast<uint32_t>(index),
+                                    std::memory_order_relaxed);
+        }
+        shard.heap.pushBatch(chunk);
+        refreshTop(shard);
+    }
+}
+
+std::optional<Task> MultiQueue::pop() {
+    if (mode_ == Mode::Strict) return popStrict();
+    return popRelaxed();
+}
+
+std::optional<Task> MultiQueue::popRelaxed() {
+    for (int attempt = 0; attempt < kSampleAttempts; ++attempt) {
+        if (size_.load(std::memory_order_acquire) == 0) return std::nullopt;
+
+        Shard& a = *shards_[randomShard()];
+        Shard& b = *shards_[randomShard()];
+        Shard& best = headBetter(b, a) ? b : a;
+        if (!best.has_top.load(std::memory_order_relaxed)) continue;
+
+        std::unique_lock<std::mutex> lock{best.mtx, std::try_to_lock};
+        if (!lock.owns_lock() || best.heap.empty()) continue;
+
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return popLocked(best);
+    }
+
+    // sampling kept missing, sweep every shard so nothing gets stranded
+    size_t start = randomShard();
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard& shard = *shards_[(start + i) % shards_.size()];
+        std::lock_guard<std::mutex> guard{shard.mtx};
+        if (shard.heap.empty()) continue;
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return popLocked(shard);
+    }
+    return std::nullopt;
+}
+
+std::optional<Task> MultiQueue::popStrict() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards_.size());
+    Shard* best = nullptr;
+    for (auto& shard : shards_) {
+        locks.emplace_back(shard->mtx);
+        if (shard->heap.empty()) continue;
+        if (!best || shard->heap.topKey() < best->heap.topKey()) {
+            best = shard.get();
+        }
+    }
+    if (!best) return std::nullopt;
+
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return popLocked(*best);
+}
+
+std::optional<std::reference_wrapper<const Task>> MultiQueue::peek() const {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards_.size());
+    Shard const* best = nullptr;
+    for (auto const& shard : shards_) {
+        locks.emplace_back(shard->mtx);
+        if (shard->heap.empty()) continue;
+        if (!best || shard->heap.topKey() < best->heap.topKey()) {
+            best = shard.get();
+        }
+    }
+    if (!best) return std::nullopt;
+    return std::cref(best->heap.top());
+}
+
+std::optional<Task> MultiQueue::erase(TaskState const& state) {
+    // a queued task never changes shards, so the shard read before locking
+    // is the right one whenever the task is still there
+    Shard& shard =
+        *shards_[state.shard.load(std::memory_order_relaxed) % shards_.size()];
+    std::lock_guard<std::mutex> guard{shard.mtx};
+    Task* task = shard.heap.find(state);
+    if (!task) return std::nullopt;
+    Task removed = shard.heap.erase(*task);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    refreshTop(shard);
+    return removed;
+}
+
+template <typename Fn>
+bool MultiQueue::updateQueued(TaskState const& state, Fn&& mutate) {
+    Shard& shard =
+        *shards_[state.shard.load(std::memory_order_relaxed) % shards_.size()];
+    std::lock_guard<std::mutex> guard{shard.mtx};
+    Task* task = shard.heap.find(state);
+    if (!task) return false;
+    mutate(*task);
+    shard.heap.update(*task);
+    refreshTop(shard);
+    return true;
+}
+
+bool MultiQueue::reprioritize(TaskState const& state, int priority) {
+    return updateQueued(state, [priority](Task& task) {
+        task.priority = priority;
+    });
+}
+
+bool MultiQueue::changeDeadline(TaskState const& state,
+                                std::optional<time_point> deadline) {
+    return updateQueued(state, [&deadline](Task& task) {
+        task.deadline = deadline;
+    });
+}
+
+bool MultiQueue::empty() const {
+    return size_.load(std::memory_order_acquire) == 0;
+}
+
+size_t MultiQueue::size() const {
+    return size_.load(std::memory_order_acquire);
+}
+
+size_t MultiQueue::shardCount() const noexcept {
+    return shards_.size();
+}
+
+MultiQueue::Mode MultiQueue::mode() const noexcept {
+    return mode_;
+}
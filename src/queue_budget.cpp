@@ -0,0 +1,89 @@
+#include "detail/queue_budget.h"
+#include "detail/task.h"
+#include <algorithm>
+#include <limits>
+
+using namespace scheduler::detail;
+
+namespace {
+constexpr size_t kNoCap = std::numeric_limits<size_t>::max();
+
+size_t orNoCap(size_t cap) { return cap == 0 ? kNoCap : cap; }
+
+// `fraction` of `cap`, at least 1 and at most the cap
+size_t mark(size_t cap, double fraction) {
+    if (cap == kNoCap) return kNoCap;
+    auto at = size_t(double(cap) * std::clamp(fraction, 0.0, 1.0));
+    return std::clamp<size_t>(at, 1, cap);
+}
+
+// adds `delta` unless that goes past `cap`
+bool tryAdd(std::atomic<size_t>& counter, size_t delta, size_t cap) {
+    size_t current = counter.load(std::memory_order_relaxed);
+    do {
+        if (delta > cap || current > cap - delta) return false;
+    } while (!counter.compare_exchange_weak(current, current + delta,
+                                            std::memory_order_relaxed));
+    return true;
+}
+}
+
+QueueBudget::QueueBudget(QueueLimits limits)
+: limits_{std::move(limits)} {
+    limits_.max_tasks = orNoCap(limits_.max_tasks);
+    limits_.max_bytes = orNoCap(limits_.max_bytes);
+    high_tasks_ = mark(limits_.max_tasks, limits_.high_watermark);
+    high_bytes_ = mark(limits_.max_bytes, limits_.high_watermark);
+    // the low mark sits strictly below the high one, so pressure can end
+    low_tasks_ = std::min(mark(limits_.max_tasks, limits_.low_watermark),
+                          high_tasks_ - 1);
+    low_bytes_ = std::min(mark(limits_.max_bytes, limits_.low_watermark),
+                          high_bytes_ - 1);
+}
+
+size_t QueueBudget::footprint(Task const& task) noexcept {
+    return sizeof(Task) + task.task.pooledSize();
+}
+
+bool QueueBudget::tryAcquire(size_t tasks, size_t bytes) {
+    if (!tryAdd(tasks_, tasks, limits_.max_tasks)) return false;
+    if (!tryAdd(bytes_, bytes, limits_.max_bytes)) {
+        tasks_.fetch_sub(tasks, std::memory_order_relaxed);
+        return false;
+    }
+    checkPressure();
+    return true;
+}
+
+void QueueBudget::acquire(size_t tasks, size_t bytes) {
+    tasks_.fetch_add(tasks, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    checkPressure();
+}
+
+void QueueBudget::release(size_t tasks, size_t bytes) {
+    tasks_.fetch_sub(tasks, std::memory_order_relaxed);
+    bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    checkPressure();
+}
+
+void QueueBudget::reject(RejectedTask&& task) const {
+    if (limits_.on_reject) limits_.on_reject(std::move(task));
+}
+
+void QueueBudget::checkPressure() {
+    auto above = [this] {
+        return tasks() >= high_tasks_ || bytes() >= high_bytes_;
+    };
+    auto below = [this] {
+        return tasks() <= low_tasks_ && bytes() <= low_bytes_;
+    };
+    // the common case, between the marks or on the right side of them
+    if (pressured() ? !below() : !above()) return;
+
+    std::lock_guard<std::mutex> guard{pressure_mtx_};
+    bool now = pressured() ? !below() : above();
+    if (now == pressured()) return;
+    pressured_.store(now, std::memory_order_relaxed);
+    if (limits_.on_pressure) limits_.on_pressure(now);
+}
@@ -1,38 +1,761 @@
 #include "scheduler/scheduler.h"
+#include "detail/bounded_queue_impl.h"
+#include "detail/coarse_clock_impl.h"
+#include "detail/deadline_monitor.h"
+#include "detail/group_queue_impl.h"
+#include "detail/metrics_recorder.h"
+#include "detail/queue_budget.h"
 #include "detail/task_queue_impl.h"
+#include "detail/lane_queue_impl.h"
+#include "detail/laned_thread_pool_impl.h"
 #include "detail/system_clock_impl.h"
 #include "detail/thread_pool_impl.h"
+#include "detail/statistics_calculator_impl.h"
+#include "detail/timer_thread.h"
+#include "detail/timing_wheel.h"
+#include "detail/tracer.h"
+#include "detail/tsc_clock_impl.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 
 using namespace scheduler;
 using namespace detail;
 
-Scheduler::Scheduler(size_t numThreads) {
-    if (numThreads <= 0) numThreads = 1;
-    thread_pool = std::make_shared<ThreadPool>(numThreads);
-    clock = std::make_shared<SystemClock>();
-    data = std::make_shared<TaskQueue>();
+namespace {
+// Owns a suspended coroutine until it is resumed; one that is dropped
+// unrun (e.g. a pending timer at shutdown) is destroyed instead.
+class Resumption {
+public:
+    explicit Resumption(std::coroutine_handle<> handle) noexcept
+    : handle_{handle} {}
+    Resumption(Resumption&& other) noexcept
+    : handle_{std::exchange(other.handle_, nullptr)} {}
+    Resumption& operator=(Resumption&&) = delete;
+    ~Resumption() {
+        if (handle_) handle_.destroy();
+    }
+
+    void operator()() { std::exchange(handle_, nullptr).resume(); }
+
+private:
+    std::coroutine_handle<> handle_;
+};
+
+SchedulerOptions placedOptions(size_t threads, WorkerPlacement placement) {
+    SchedulerOptions options;
+    options.threads = threads;
+    options.placement = std::move(placement);
+    return options;
+}
+
+// One clock per source, shared by every use that picked it
+class ClockFactory {
+public:
+    ClockFactory(std::shared_ptr<IClock> steady,
+                 std::chrono::microseconds coarse_resolution)
+    : steady_{std::move(steady)}, coarse_resolution_{coarse_resolution} {}
+
+    std::shared_ptr<IClock> const& get(ClockSource source) {
+        switch (source) {
+        case ClockSource::Tsc:
+            if (!TscClock::available()) break;
+            if (!tsc_) tsc_ = std::make_shared<TscClock>();
+            return tsc_;
+        case ClockSource::Coarse:
+            if (!coarse_) {
+                coarse_ = std::make_shared<CoarseClock>(coarse_resolution_);
+            }
+            return coarse_;
+        case ClockSource::Steady:
+            break;
+        }
+        return steady_;
+    }
+
+private:
+    std::shared_ptr<IClock> steady_;
+    std::shared_ptr<IClock> tsc_;
+    std::shared_ptr<IClock> coarse_;
+    std::chrono::microseconds coarse_resolution_;
 };
+}
+
+Scheduler::Scheduler(size_t numThreads)
+: Scheduler(numThreads, WorkerPlacement{}) {}
+
+Scheduler::Scheduler(size_t numThreads, WorkerPlacement placement)
+: Scheduler(placedOptions(numThreads, std::move(placement))) {}
+
+Scheduler::Scheduler(SchedulerOptions options) {
+    size_t numThreads = std::max<size_t>(options.threads, 1);
+    clock = std::make_shared<SystemClock>();
+    ClockFactory clocks{clock, options.clocks.coarse_resolution};
+    enqueue_clock = clocks.get(options.clocks.enqueue);
+    deadline_clock = clocks.get(options.clocks.deadline);
+    latency_clock = clocks.get(options.clocks.latency);
+    deadlines = std::make_shared<DeadlineMonitor>(std::move(options.deadlines));
+    if (kTracingCompiled && options.tracing) {
+        tracer = std::make_shared<Tracer>(options.tracing->events_per_thread);
+        trace_path = std::move(options.tracing->path);
+    }
+
+    if (!options.groups.empty() && !options.lanes.empty()) {
+        throw std::invalid_argument(
+            "Scheduler: task groups do not go together with lanes");
+    }
+    if (options.elastic && !options.lanes.empty()) {
+        throw std::invalid_argument(
+            "Scheduler: an elastic pool does not go together with lanes");
+    }
+    if (options.max_compensating_threads.value_or(0) != 0 &&
+        !options.lanes.empty()) {
+        throw std::invalid_argument(
+            "Scheduler: compensating threads do not go together with lanes");
+    }
+    if (options.limits &&
+        (options.limits->max_tasks != 0 || options.limits->max_bytes != 0)) {
+        budget = std::make_shared<QueueBudget>(std::move(*options.limits));
+    }
+    // the queue of a lane, counted against the limits if there are any
+    auto makeLane = [this](std::shared_ptr<ITaskQueue> queue) {
+        Lane lane;
+        lane.queue = std::move(queue);
+        if (budget) {
+            lane.bounded = std::make_shared<BoundedQueue>(lane.queue, budget);
+            lane.queue = lane.bounded;
+        }
+        return lane;
+    };
+    if (options.lanes.empty()) {
+        thread_pool = std::make_shared<ThreadPool>(
+            numThreads, IdlePolicy::latencyOptimized(),
+            std::move(options.placement), options.elastic,
+            options.max_compensating_threads.value_or(numThreads));
+        if (options.groups.empty()) {
+            lanes.push_back(makeLane(std::make_shared<TaskQueue>()));
+        } else {
+            groups = std::make_shared<GroupQueue>(options.groups, clock);
+            lanes.push_back(makeLane(groups));
+        }
+        data = lanes[0].queue;
+    } else {
+        std::stable_sort(options.lanes.begin(), options.lanes.end(),
+                         [](PriorityLane const& a, PriorityLane const& b) {
+                             return a.min_priority > b.min_priority;
+                         });
+        std::vector<LaneWorkers> workers;
+        std::vector<std::shared_ptr<ITaskQueue>> queues;
+        for (PriorityLane const& lane : options.lanes) {
+            lane_floors.push_back(lane.min_priority);
+            workers.push_back({lane.reserved_workers, lane.borrow});
+            lanes.push_back(makeLane(std::make_shared<TaskQueue>()));
+            queues.push_back(lanes.back().queue);
+        }
+        thread_pool = std::make_shared<LanedThreadPool>(
+            numThreads, std::move(workers), IdlePolicy::latencyOptimized(),
+            std::move(options.placement));
+        data = std::make_shared<LaneQueue>(lane_floors, std::move(queues));
+    }
+    start();
+}
 
 Scheduler::Scheduler(std::shared_ptr<detail::IClock> clock_,
                     std::shared_ptr<detail::ITaskQueue> data_,
                     std::shared_ptr<detail::IThreadPool> pool_)
-  : clock{clock_}, data{data_}, thread_pool{pool_} {};
+  : data{data_}, thread_pool{pool_}, clock{clock_} {
+    lanes.emplace_back().queue = data;
+    start();
+};
 
 Scheduler::~Scheduler() {
+    // no more fires, so the dispatcher's final drain sees every queued task
+    timer_thread->stop();
+    {
+        std::lock_guard<std::mutex> lock{dispatch_mutex};
+        running = false;
+    }
+    dispatch_cv.notify_one();
+    if (dispatcher.joinable()) dispatcher.join();
     thread_pool->stop();
+    if (tracer && !trace_path.empty()) tracer->write(trace_path);
+}
+
+void Scheduler::start() {
+    stats = std::make_shared<StatisticsCalculator>();
+    if (!enqueue_clock) enqueue_clock = deadline_clock = latency_clock = clock;
+    if (!deadlines) deadlines = std::make_shared<DeadlineMonitor>(std::nullopt);
+    timers = std::make_shared<TimingWheel>(sequence, milliseconds{1},
+                                           clock->now(), clock);
+    metrics = std::make_shared<MetricsRecorder>();
+    started_at = std::chrono::steady_clock::now();
+    timer_thread = std::make_shared<TimerThread>(
+        timers, data, clock, [this](size_t fired) {
+            metrics->add(Counter::TimerFires, fired);
+            wakeDispatcher();
+        });
+    // fixed-delay timers come back when their run is done
+    timers->onResume([this](time_point at) { timer_thread->rearm(at); });
+    // a worker entering a BlockingScope frees up room for one more task
+    thread_pool->onCapacityChange([this] { wakeDispatcher(); });
+    thread_pool->recordInto(metrics, latency_clock);
+    thread_pool->start();
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        lanes[i].stats = lanes.size() == 1
+            ? stats : std::make_shared<StatisticsCalculator>();
+        lanes[i].capacity =
+            std::max<size_t>(thread_pool->laneCapacity(i), 1);
+    }
+    for (size_t i = 0; i < groupCount(); ++i) {
+        group_stats.push_back(groups
+            ? std::make_shared<StatisticsCalculator>() : stats);
+    }
+    running = true;
+    dispatcher = std::thread([this]{ dispatchLoop(); });
+    timer_thread->start();
+}
+
+TaskHandle Scheduler::schedule(InplaceTask task, int priority,
+    std::optional<std::chrono::steady_clock::time_point> deadline, int node,
+    size_t group) {
+    if (auto handle = enqueue(task, priority, deadline, node, group)) {
+        return std::move(*handle);
+    }
+    refuse(std::move(task), priority, deadline);
+    return TaskHandle{};
+}
+
+std::optional<TaskHandle> Scheduler::trySchedule(InplaceTask&& task,
+    int priority,
+    std::optional<std::chrono::steady_clock::time_point> deadline, int node,
+    size_t group) {
+    auto handle = enqueue(task, priority, deadline, node, group);
+    if (!handle) metrics->add(Counter::Refused);
+    return handle;
+}
+
+std::optional<TaskHandle> Scheduler::tryScheduleFor(
+    std::chrono::microseconds timeout, InplaceTask&& task, int priority,
+    std::optional<std::chrono::steady_clock::time_point> deadline, int node,
+    size_t group) {
+    auto until = std::chrono::steady_clock::now() + timeout;
+    std::chrono::microseconds backoff{10};
+    while (true) {
+        if (auto handle = enqueue(task, priority, deadline, node, group)) {
+            return handle;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= until) break;
+        std::this_thread::sleep_for(
+            std::min<std::chrono::steady_clock::duration>(backoff,
+                                                          until - now));
+        backoff = std::min(backoff * 2, std::chrono::microseconds{1000});
+    }
+    metrics->add(Counter::Refused);
+    return std::nullopt;
+}
+
+// Queues a one-off task unless the limits refuse it, which leaves `task`
+// as it was
+std::optional<TaskHandle> Scheduler::enqueue(InplaceTask& task, int priority,
+    std::optional<std::chrono::steady_clock::time_point> deadline, int node,
+    size_t group) {
+    if (group >= groupCount()) {
+        throw std::out_of_range("Scheduler: unknown task group");
+    }
+    auto state = makeTaskState();
+    Lane const& lane = lanes[laneOf(priority)];
+    state->queue = lane.queue;
+    Task entry(std::move(task), priority,
+               sequence.fetch_add(1, std::memory_order_relaxed),
+               milliseconds{0}, enqueue_clock->now(), deadline, state);
+    entry.node = node;
+    entry.group = uint32_t(group);
+    if (!lane.bounded) {
+        lane.queue->push(std::move(entry));
+    } else if (!lane.bounded->tryPush(std::move(entry))) {
+        task = std::move(entry.task);
+        return std::nullopt;
+    }
+    metrics->add(Counter::Submitted);
+    wakeDispatcher();
+    return TaskHandle{std::move(state)};
 }
 
-void Scheduler::schedule(std::function<void()> task, int priority,
+void Scheduler::refuse(InplaceTask&& task, int priority,
     std::optional<std::chrono::steady_clock::time_point> deadline) {
+    metrics->add(Counter::Refused);
+    budget->reject(RejectedTask{std::move(task), priority, deadline});
+}
+
+void Scheduler::scheduleBatch(std::span<BatchTask> tasks) {
+    if (tasks.empty()) return;
+    for (BatchTask const& entry : tasks) {
+        if (entry.group >= groupCount()) {
+            throw std::out_of_range("Scheduler: unknown task group");
+        }
+    }
+
+    auto now = enqueue_clock->now();
+    uint64_t seq = sequence.fetch_add(tasks.size(), std::memory_order_relaxed);
+    std::vector<Task> batch;
+    batch.reserve(tasks.size());
+    for (BatchTask& entry : tasks) {
+        batch.emplace_back(std::move(entry.task), entry.priority, seq++,
+                           milliseconds{0}, now, entry.deadline);
+        batch.back().node = entry.node;
+        batch.back().group = uint32_t(entry.group);
+    }
+    if (!budget) {
+        data->pushBatch(batch);
+        metrics->add(Counter::Submitted, tasks.size());
+        wakeDispatcher();
+        return;
+    }
 
+    std::span<Task> refused;
+    if (lanes.size() == 1) {
+        refused = std::span{batch}.subspan(
+            lanes[0].bounded->tryPushBatch(batch));
+    } else {
+        // one tryPushBatch() per lane, higher lanes first; the refused
+        // tasks are gathered at the front
+        std::stable_sort(batch.begin(), batch.end(),
+                         [this](Task const& a, Task const& b) {
+                             return laneOf(a.priority) < laneOf(b.priority);
+                         });
+        size_t refused_count = 0;
+        for (size_t begin = 0; begin < batch.size();) {
+            size_t lane = laneOf(batch[begin].priority);
+            size_t end = begin + 1;
+            while (end < batch.size() && laneOf(batch[end].priority) == lane) {
+                ++end;
+            }
+            auto run = std::span{batch}.subspan(begin, end - begin);
+            for (size_t i = lanes[lane].bounded->tryPushBatch(run);
+                 i < run.size(); ++i) {
+                if (refused_count != begin + i) {
+                    batch[refused_count] = std::move(run[i]);
+                }
+                ++refused_count;
+            }
+            begin = end;
+        }
+        refused = std::span{batch}.first(refused_count);
+    }
+    if (size_t queued = batch.size() - refused.size()) {
+        metrics->add(Counter::Submitted, queued);
+        wakeDispatcher();
+    }
+    for (Task& task : refused) {
+        refuse(std::move(task.task), task.priority, task.deadline);
+    }
 }
 
 // Allow tasks that run repeatedly on an interval
-void Scheduler::scheduleRecurring(std::function<void()> task, int priority,
-                                            std::chrono::milliseconds interval) {
+TaskHandle Scheduler::scheduleRecurring(InplaceTask task, int priority,
+                                        std::chrono::milliseconds interval,
+                                        RecurringOptions options) {
+    if (interval <= milliseconds{0}) {
+        return schedule(std::move(task), priority);
+    }
+
+    auto state = makeTaskState();
+    state->recurring = true;
+    state->timers = timers;
+    auto now = clock->now();
+    state->timer = timers->schedule(
+        Task(std::move(task), priority,
+             sequence.fetch_add(1, std::memory_order_relaxed),
+             interval, now, std::nullopt, state),
+        now + interval, options);
+    timer_thread->rearm(now + interval);
+    return TaskHandle{std::move(state)};
+}
+
+ScheduleAwaiter Scheduler::yield(int priority) {
+    return ScheduleAwaiter{*this, priority, std::nullopt, std::nullopt};
+}
+
+ScheduleAwaiter Scheduler::sleepUntil(
+    std::chrono::steady_clock::time_point wake_at, int priority) {
+    return ScheduleAwaiter{*this, priority, std::nullopt, wake_at};
+}
 
+ScheduleAwaiter Scheduler::atDeadline(
+    std::chrono::steady_clock::time_point deadline, int priority) {
+    return ScheduleAwaiter{*this, priority, deadline, std::nullopt};
+}
+
+void ScheduleAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    // the coroutine may resume on a worker before this returns, so nothing
+    // of the awaiter may be touched after the hand-off
+    sched_.resumeLater(handle, priority_, deadline_, wake_at_);
+}
+
+void Scheduler::resumeLater(std::coroutine_handle<> handle, int priority,
+    std::optional<std::chrono::steady_clock::time_point> deadline,
+    std::optional<std::chrono::steady_clock::time_point> wake_at) {
+    auto now = enqueue_clock->now();
+    Task task(Resumption{handle}, priority,
+              sequence.fetch_add(1, std::memory_order_relaxed),
+              milliseconds{0}, now, deadline);
+    if (wake_at) {
+        timers->schedule(std::move(task), *wake_at);
+        timer_thread->rearm(*wake_at);
+    } else {
+        data->push(std::move(task));
+        metrics->add(Counter::Submitted);
+        wakeDispatcher();
+    }
 }
 
 std::tuple<double, double, double> Scheduler::getLatencyStatistics() const {
-    return {};
-}
\ No newline at end of file
+    return stats->getLatencyStatistics();
+}
+
+double Scheduler::getLatencyPercentile(double percentile) const {
+    return double(stats->getLatencyHistogram().valueAtPercentile(percentile));
+}
+
+LatencyHistogram Scheduler::getLatencyHistogram() const {
+    return stats->getLatencyHistogram();
+}
+
+LatencyHistogram Scheduler::resetLatencyHistogram() {
+    return stats->resetLatencyHistogram();
+}
+
+LatencyHistogram Scheduler::getTimerJitterHistogram() const {
+    return timer_thread->jitter().getLatencyHistogram();
+}
+
+LatencyHistogram Scheduler::resetTimerJitterHistogram() {
+    return timer_thread->jitter().resetLatencyHistogram();
+}
+
+WorkerCounts Scheduler::getWorkerCounts() const {
+    return thread_pool->workerCounts();
+}
+
+MetricsSnapshot Scheduler::getMetrics() const {
+    MetricsSnapshot snapshot;
+    snapshot.submitted = metrics->total(Counter::Submitted);
+    snapshot.timer_fires = metrics->total(Counter::TimerFires);
+    snapshot.dispatched = metrics->total(Counter::Dispatched);
+    snapshot.completed = metrics->total(Counter::Completed);
+    snapshot.rejected = metrics->total(Counter::Rejected);
+    snapshot.refused = metrics->total(Counter::Refused);
+    snapshot.cancelled = metrics->total(Counter::Cancelled);
+    snapshot.dispatcher_wakeups = metrics->total(Counter::DispatcherWakeups);
+    snapshot.busy_time =
+        std::chrono::nanoseconds{metrics->total(Counter::BusyNanos)};
+    snapshot.parked_time =
+        std::chrono::nanoseconds{metrics->total(Counter::ParkedNanos)};
+    snapshot.worker_wakeups = metrics->total(Counter::WorkerWakeups);
+    snapshot.deadlines = deadlines->counts();
+
+    snapshot.queue_depth = data->size();
+    if (budget) snapshot.queue_bytes = budget->bytes();
+    {
+        std::lock_guard<std::mutex> lock{dispatch_mutex};
+        for (Lane const& lane : lanes) snapshot.in_flight += lane.in_flight;
+    }
+    snapshot.workers = thread_pool->workerCounts();
+    snapshot.uptime = std::chrono::steady_clock::now() - started_at;
+
+    snapshot.latency = stats->getLatencyHistogram();
+    snapshot.timer_jitter = timer_thread->jitter().getLatencyHistogram();
+    return snapshot;
+}
+
+bool Scheduler::writeTrace(std::string const& path) const {
+    return tracer && tracer->write(path);
+}
+
+bool Scheduler::underPressure() const noexcept {
+    return budget && budget->pressured();
+}
+
+DeadlineCounts Scheduler::getDeadlineCounts() const {
+    return deadlines->counts();
+}
+
+size_t Scheduler::groupCount() const noexcept {
+    return groups ? groups->groupCount() : 1;
+}
+
+GroupStats Scheduler::getGroupStats(size_t group) const {
+    auto const& latency = group_stats.at(group);
+    GroupStats result;
+    if (groups) {
+        result = groups->stats(uint32_t(group));
+    } else {
+        result.completed = metrics->total(Counter::Completed);
+        result.busy_time =
+            std::chrono::nanoseconds{metrics->total(Counter::BusyNanos)};
+        result.queued = data->size();
+    }
+    result.latency = latency->getLatencyHistogram();
+    return result;
+}
+
+LatencyHistogram Scheduler::resetGroupLatencyHistogram(size_t group) {
+    return group_stats.at(group)->resetLatencyHistogram();
+}
+
+size_t Scheduler::laneCount() const noexcept {
+    return lanes.size();
+}
+
+size_t Scheduler::laneOf(int priority) const noexcept {
+    for (size_t i = 0; i + 1 < lane_floors.size(); ++i) {
+        if (priority >= lane_floors[i]) return i;
+    }
+    return lanes.size() - 1;
+}
+
+LatencyHistogram Scheduler::getLaneLatencyHistogram(size_t lane) const {
+    return lanes.at(lane).stats->getLatencyHistogram();
+}
+
+LatencyHistogram Scheduler::resetLaneLatencyHistogram(size_t lane) {
+    return lanes.at(lane).stats->resetLatencyHistogram();
+}
+
+void Scheduler::wakeDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock{dispatch_mutex};
+        wakeup = true;
+    }
+    dispatch_cv.notify_one();
+}
+
+void Scheduler::onTaskFinished(size_t lane) {
+    bool was_full;
+    {
+        std::lock_guard<std::mutex> lock{dispatch_mutex};
+        Lane& entry = lanes[lane];
+        was_full = entry.in_flight-- >= entry.capacity;
+    }
+    if (was_full) dispatch_cv.notify_one();
+}
+
+// Hands the batch of one lane to the pool, one hand-off per NUMA node
+// hint; every task must already be counted in the lane's `in_flight`.
+void Scheduler::dispatch(std::vector<Task>& batch, size_t lane) {
+    if (batch.empty()) return;
+
+    bool mixed = std::any_of(batch.begin(), batch.end(), [&](Task const& t) {
+        return t.node != batch.front().node;
+    });
+    if (mixed) {
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](Task const& a, Task const& b) {
+                             return a.node < b.node;
+                         });
+    }
+
+    // only the dispatcher thread gets here
+    jobs.clear();
+    // one timestamp for the whole batch
+    Tracer* trace = kTracingCompiled ? tracer.get() : nullptr;
+    auto dispatched = trace ? latency_clock->now() : time_point{};
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Task& task = batch[i];
+        auto enqueued = task.enqueue_time;
+        auto deadline = task.deadline.value_or(time_point::max());
+        if (trace) {
+            trace->dispatched(task.sequence_number, enqueued, dispatched,
+                              task.priority, lane);
+        }
+        auto job = [fn = std::move(task.task), this, enqueued,
+                    lane = uint32_t(lane), priority = task.priority,
+                    group = task.group, deadline,
+                    seq = task.sequence_number]() mutable {
+            auto started = latency_clock->now();
+            // clocks of different sources may disagree by a little
+            auto latency = std::max<int64_t>(0,
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    started - enqueued).count());
+            stats->updateLatencyStatistics(latency);
+            if (lanes.size() > 1) {
+                lanes[lane].stats->updateLatencyStatistics(latency);
+            }
+            if (groups) group_stats[group]->updateLatencyStatistics(latency);
+
+            struct Finished {
+                Scheduler* self;
+                uint32_t lane;
+                int priority;
+                uint32_t group;
+                time_point started;
+                time_point deadline;
+                uint64_t seq;
+                ~Finished() {
+                    auto ended = self->latency_clock->now();
+                    if (self->groups) {
+                        self->groups->finished(group, ended - started);
+                    }
+                    if (kTracingCompiled && self->tracer) {
+                        self->tracer->ran(seq, started, ended);
+                    }
+                    self->metrics->add(Counter::Completed);
+                    self->metrics->add(Counter::BusyNanos, uint64_t(
+                        std::max(ended - started, time_point::duration{0})
+                            .count()));
+                    if (deadline != time_point::max()) {
+                        self->deadlines->finished(priority, ended - started,
+                                                  self->deadline_clock->now(),
+                                                  deadline);
+                    }
+                    self->onTaskFinished(lane);
+                }
+            } finished{this, lane, priority, group, started, deadline,
+                       seq};
+            fn();
+        };
+        // keep the job in the Job's inline buffer
+        static_assert(sizeof(job) <= Job::capacity);
+        jobs.emplace_back(std::move(job));
+        if (i + 1 < batch.size() && batch[i + 1].node == task.node) continue;
+
+        bool accepted;
+        if (lanes.size() > 1) {
+            accepted = thread_pool->submitToLane(jobs, lane);
+        } else if (task.node == kAnyNode) {
+            accepted = thread_pool->submitBatch(jobs);
+        } else {
+            accepted = thread_pool->submitToNode(jobs, task.node);
+        }
+        if (accepted) {
+            metrics->add(Counter::Dispatched, jobs.size());
+        } else {
+            metrics->add(Counter::Rejected, jobs.size());
+            for (size_t j = 0; j < jobs.size(); ++j) onTaskFinished(lane);
+        }
+        jobs.clear();
+    }
+    batch.clear();
+}
+
+// Deals with the tasks the dispatcher found out of reach of their deadline
+void Scheduler::shed(std::vector<Task>& late) {
+    auto const& policy = deadlines->policy();
+    for (Task& task : late) {
+        switch (policy.action) {
+        case DeadlineAction::Drop:
+            deadlines->shed();
+            break;
+        case DeadlineAction::Divert:
+            deadlines->shed();
+            if (policy.divert) {
+                policy.divert(ShedTask{std::move(task.task), task.priority,
+                                       *task.deadline});
+            }
+            break;
+        case DeadlineAction::Demote: {
+            deadlines->demoted();
+            Task demoted(std::move(task.task), policy.demoted_priority,
+                         task.sequence_number, milliseconds{0},
+                         task.enqueue_time, std::nullopt,
+                         std::move(task.state));
+            demoted.node = task.node;
+            demoted.group = task.group;
+            // the dispatcher claimed the task; hand it back to its handle
+            if (demoted.state && !demoted.state->recurring) {
+                demoted.state->status.store(TaskState::Status::Queued,
+                                            std::memory_order_release);
+            }
+            data->push(std::move(demoted));
+            break;
+        }
+        }
+    }
+    late.clear();
+}
+
+void Scheduler::dispatchLoop() {
+    std::vector<Task> batch;
+    std::vector<Task> late;
+    std::vector<size_t> room(lanes.size());
+    std::unique_lock<std::mutex> lock{dispatch_mutex};
+
+    while (running) {
+        wakeup = false;
+        metrics->add(Counter::DispatcherWakeups);
+
+        // finishing tasks only ever free up more room while we are unlocked
+        for (size_t i = 0; i < lanes.size(); ++i) {
+            lanes[i].capacity =
+                std::max<size_t>(thread_pool->laneCapacity(i), 1);
+            room[i] = lanes[i].capacity -
+                      std::min(lanes[i].in_flight, lanes[i].capacity);
+        }
+        for (size_t i = 0; i < lanes.size(); ++i) {
+            lock.unlock();
+            auto now = deadline_clock->now();
+            while (batch.size() < room[i]) {
+                auto task = lanes[i].queue->pop();
+                if (!task) break;
+                // cancelled tasks are dropped here and never reach the pool
+                if (task->state && !task->state->claim()) {
+                    metrics->add(Counter::Cancelled);
+                    continue;
+                }
+                if (task->deadline && !deadlines->reachable(
+                        task->priority, *task->deadline, now)) {
+                    late.push_back(std::move(*task));
+                    continue;
+                }
+                batch.push_back(std::move(*task));
+            }
+            // demoted tasks go back into the queues once the lane is done
+            if (!late.empty()) shed(late);
+            lock.lock();
+            lanes[i].in_flight += batch.size();
+            lock.unlock();
+            dispatch(batch, i);
+            lock.lock();
+        }
+
+        auto ready = [this] {
+            if (!running || wakeup) return true;
+            for (Lane const& lane : lanes) {
+                if (lane.in_flight < lane.capacity && !lane.queue->empty()) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        if (!groups) {
+            dispatch_cv.wait(lock, ready);
+            continue;
+        }
+        // groups out of quota leave tasks queued until their next period,
+        // which a finished task may just have pushed back
+        while (!ready()) {
+            if (auto refill = groups->nextRefill()) {
+                dispatch_cv.wait_until(lock, *refill);
+            } else {
+                dispatch_cv.wait(lock);
+            }
+        }
+    }
+
+    // hand whatever is still queued to the pool, which drains it on stop
+    lock.unlock();
+    if (groups) groups->liftQuotas();
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        while (auto task = lanes[i].queue->pop()) {
+            if (task->state && !task->state->claim()) continue;
+            batch.push_back(std::move(*task));
+        }
+        {
+            std::lock_guard<std::mutex> guard{dispatch_mutex};
+            lanes[i].in_flight += batch.size();
+        }
+        dispatch(batch, i);
+    }
+}
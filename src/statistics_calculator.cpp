@@ -1,32 +1,88 @@
 #include "detail/statistics_calculator_impl.h"
 
+using namespace scheduler;
 using namespace scheduler::detail;
 
+StatisticsCalculator::StatisticsCalculator() {
+    interval_start_.counts.assign(LatencyHistogram::kBucketCount, 0);
+}
+
+StatisticsCalculator::Recorder& StatisticsCalculator::localRecorder() {
+    return recorders_.local([] { return std::make_shared<Recorder>(); });
+}
+
 std::tuple<double, double, double> StatisticsCalculator::getLatencyStatistics() const {
-    auto cnt = count.load(std::memory_order_relaxed);
+    uint64_t cnt = 0;
+    int64_t sum = 0;
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = 0;
+    recorders_.forEach([&](Recorder const& recorder) {
+        cnt += recorder.count.load(std::memory_order_relaxed);
+        sum += recorder.sum.load(std::memory_order_relaxed);
+        min = std::min(min, recorder.min.load(std::memory_order_relaxed));
+        max = std::max(max, recorder.max.load(std::memory_order_relaxed));
+    });
+
     double avg = 0.0;
     if (cnt > 0) {
-        avg = double(sum.load(std::memory_order_relaxed) / double(cnt));
+        avg = double(sum) / double(cnt);
     }
 
-    return {
-        avg,
-        double(min.load(std::memory_order_relaxed)),
-        double(max.load(std::memory_order_relaxed))
-    };
+    return { avg, double(min), double(max) };
 }
 
+// Only the owning thread writes to the recorder, so plain load/store pairs
+// are enough and the hot path stays wait-free.
 void StatisticsCalculator::updateLatencyStatistics(int64_t latency) {
-    sum.fetch_add(latency, std::memory_order_relaxed);
-    count.fetch_add(1, std::memory_order_relaxed);
+    Recorder& rec = localRecorder();
+    auto bump = [](auto& cell, auto delta) {
+        cell.store(cell.load(std::memory_order_relaxed) + delta,
+                   std::memory_order_relaxed);
+    };
 
-    {
-        int64_t prev_min = min.load(std::memory_order_relaxed);
-        while (prev_min > latency && !min.compare_exchange_weak(prev_min, latency, std::memory_order_relaxed)) {}
+    bump(rec.counts[LatencyHistogram::bucketIndex(latency)], uint64_t{1});
+    bump(rec.sum, latency);
+    bump(rec.count, uint64_t{1});
+    if (latency < rec.min.load(std::memory_order_relaxed)) {
+        rec.min.store(latency, std::memory_order_relaxed);
     }
+    if (latency > rec.max.load(std::memory_order_relaxed)) {
+        rec.max.store(latency, std::memory_order_relaxed);
+    }
+}
 
-    {
-        int64_t prev_max = max.load(std::memory_order_relaxed);
-        while (prev_max < latency && !max.compare_exchange_weak(prev_max, latency, std::memory_order_relaxed)) {}
+StatisticsCalculator::Totals StatisticsCalculator::collect() const {
+    Totals totals;
+    totals.counts.assign(LatencyHistogram::kBucketCount, 0);
+
+    recorders_.forEach([&](Recorder const& recorder) {
+        for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            totals.counts[i] +=
+                recorder.counts[i].load(std::memory_order_relaxed);
+        }
+        totals.sum += recorder.sum.load(std::memory_order_relaxed);
+    });
+    return totals;
+}
+
+LatencyHistogram StatisticsCalculator::since(Totals const& now) const {
+    std::vector<uint64_t> counts(LatencyHistogram::kBucketCount);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        // recorder counters never go down, so this cannot wrap
+        counts[i] = now.counts[i] - interval_start_.counts[i];
     }
-}
\ No newline at end of file
+    return LatencyHistogram(std::move(counts), now.sum - interval_start_.sum);
+}
+
+LatencyHistogram StatisticsCalculator::getLatencyHistogram() const {
+    std::lock_guard<std::mutex> guard{interval_mtx_};
+    return since(collect());
+}
+
+LatencyHistogram StatisticsCalculator::resetLatencyHistogram() {
+    std::lock_guard<std::mutex> guard{interval_mtx_};
+    Totals now = collect();
+    LatencyHistogram interval = since(now);
+    interval_start_ = std::move(now);
+    return interval;
+}
@@ -0,0 +1,140 @@
+#include "scheduler/scheduler.h"
+#include "detail/clock.h"
+#include "detail/graph_state.h"
+#include "detail/metrics_recorder.h"
+#include "detail/task.h"
+#include "detail/task_queue.h"
+#include <stdexcept>
+
+using namespace scheduler;
+using namespace detail;
+
+TaskGraph::Node TaskGraph::add(InplaceTask task, int priority) {
+    entries_.push_back(Entry{std::move(task), priority, {}, 0});
+    return entries_.size() - 1;
+}
+
+void TaskGraph::precede(Node before, Node after) {
+    if (before >= entries_.size() || after >= entries_.size()) {
+        throw std::out_of_range("TaskGraph: unknown node");
+    }
+    entries_[before].successors.push_back(after);
+    ++entries_[after].predecessors;
+}
+
+void TaskGraph::precede(Node before, std::initializer_list<Node> after) {
+    for (Node node : after) precede(before, node);
+}
+
+void TaskGraph::succeed(Node after, std::initializer_list<Node> before) {
+    for (Node node : before) precede(node, after);
+}
+
+std::future<void> Scheduler::submit(TaskGraph graph) {
+    size_t count = graph.entries_.size();
+    auto state = std::make_shared<GraphState>(count);
+    auto future = state->done.get_future();
+    if (count == 0) {
+        state->done.set_value();
+        return future;
+    }
+
+    std::vector<size_t> roots;
+    std::vector<size_t> indegree(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto& entry = graph.entries_[i];
+        auto& node = state->nodes[i];
+        node.task = std::move(entry.task);
+        node.priority = entry.priority;
+        node.successors = std::move(entry.successors);
+        node.pending.store(entry.predecessors, std::memory_order_relaxed);
+        indegree[i] = entry.predecessors;
+        if (entry.predecessors == 0) roots.push_back(i);
+    }
+
+    // Kahn's walk: a cycle leaves nodes that never become ready
+    std::vector<size_t> order = roots;
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (size_t next : state->nodes[order[i]].successors) {
+            if (--indegree[next] == 0) order.push_back(next);
+        }
+    }
+    if (order.size() != count) {
+        throw std::invalid_argument("TaskGraph: dependency cycle");
+    }
+
+    queueGraphNodes(state, roots);
+    return future;
+}
+
+void Scheduler::queueGraphNodes(std::shared_ptr<GraphState> const& graph,
+                                std::span<size_t const> nodes) {
+    if (nodes.empty()) return;
+
+    auto now = enqueue_clock->now();
+    uint64_t seq = sequence.fetch_add(nodes.size(), std::memory_order_relaxed);
+    std::vector<Task> batch;
+    batch.reserve(nodes.size());
+    for (size_t node : nodes) {
+        batch.emplace_back([this, graph, node] { runGraphNode(graph, node); },
+                           graph->nodes[node].priority, seq++,
+                           milliseconds{0}, now, std::nullopt);
+    }
+    data->pushBatch(batch);
+    metrics->add(Counter::Submitted, batch.size());
+    wakeDispatcher();
+}
+
+void Scheduler::runGraphNode(std::shared_ptr<GraphState> const& graph,
+                             size_t node) {
+    std::vector<size_t> ready;
+    while (true) {
+        auto& current = graph->nodes[node];
+        if (!graph->failed.load(std::memory_order_acquire)) {
+            try {
+                current.task();
+            } catch (...) {
+                bool expected = false;
+                if (graph->failed.compare_exchange_strong(
+                        expected, true, std::memory_order_acq_rel)) {
+                    graph->error = std::current_exception();
+                }
+            }
+        }
+        // free the callable and whatever it captured right away
+        current.task = nullptr;
+
+        ready.clear();
+        for (size_t next : current.successors) {
+            if (graph->nodes[next].pending.fetch_sub(
+                    1, std::memory_order_acq_rel) == 1) {
+                ready.push_back(next);
+            }
+        }
+
+        // keep the most urgent successor on this worker, queue the rest
+        std::optional<size_t> inline_next;
+        if (!ready.empty()) {
+            auto best = ready.begin();
+            for (auto it = ready.begin(); it != ready.end(); ++it) {
+                if (graph->nodes[*it].priority >
+                    graph->nodes[*best].priority) {
+                    best = it;
+                }
+            }
+            inline_next = *best;
+            ready.erase(best);
+            queueGraphNodes(graph, ready);
+        }
+
+        if (graph->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (graph->error) {
+                graph->done.set_exception(graph->error);
+            } else {
+                graph->done.set_value();
+            }
+        }
+        if (!inline_next) return;
+        node = *inline_next;
+    }
+}
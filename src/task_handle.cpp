@@ -0,0 +1,66 @@
+#include "scheduler/task_handle.h"
+#include "detail/task_queue.h"
+#include "detail/task_state.h"
+#include "detail/timing_wheel.h"
+
+using namespace scheduler;
+using namespace detail;
+
+TaskHandle::TaskHandle(std::shared_ptr<TaskState> state) noexcept
+: state_{std::move(state)} {}
+
+bool TaskHandle::cancel() {
+    if (!state_) return false;
+
+    if (state_->recurring) {
+        // tombstone the fires that are already queued
+        state_->status.store(TaskState::Status::Cancelled,
+                             std::memory_order_release);
+        auto timers = state_->timers.lock();
+        return timers && timers->cancel(state_->timer);
+    }
+
+    auto expected = TaskState::Status::Queued;
+    if (!state_->status.compare_exchange_strong(
+            expected, TaskState::Status::Cancelled,
+            std::memory_order_acq_rel)) {
+        return false;
+    }
+    // Free the callable right away. If the dispatcher has popped the task
+    // already it fails to claim it and drops it instead.
+    if (auto queue = state_->queue.lock()) queue->erase(*state_);
+    return true;
+}
+
+bool TaskHandle::reprioritize(int priority) {
+    if (!state_) return false;
+
+    if (state_->recurring) {
+        auto timers = state_->timers.lock();
+        return timers && timers->reprioritize(state_->timer, priority);
+    }
+
+    if (state_->status.load(std::memory_order_acquire) !=
+        TaskState::Status::Queued) {
+        return false;
+    }
+    auto queue = state_->queue.lock();
+    return queue && queue->reprioritize(*state_, priority);
+}
+
+bool TaskHandle::changeDeadline(
+    std::optional<std::chrono::steady_clock::time_point> deadline) {
+    if (!state_) return false;
+
+    if (state_->recurring) {
+        auto timers = state_->timers.lock();
+        return timers && timers->changeDeadline(state_->timer, deadline);
+    }
+
+    if (state_->status.load(std::memory_order_acquire) !=
+        TaskState::Status::Queued) {
+        return false;
+    }
+    auto queue = state_->queue.lock();
+    return queue && queue->changeDeadline(*state_, deadline);
+}
@@ -0,0 +1,203 @@
+#include "detail/task_heap.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <new>
+
+using namespace scheduler::detail;
+
+TaskKey TaskKey::of(Task const& task) noexcept {
+    TaskKey key{};
+    if (task.deadline) {
+        // flip the sign bit so that signed tick counts compare as unsigned
+        auto ticks = static_cast<uint64_t>(
+            task.deadline->time_since_epoch().count());
+        key.deadline = std::min(ticks ^ (uint64_t{1} << 63),
+                                std::numeric_limits<uint64_t>::max() - 1);
+    } else {
+        key.deadline = std::numeric_limits<uint64_t>::max();
+    }
+    key.priority = ~(static_cast<uint32_t>(task.priority) ^ (uint32_t{1} << 31));
+    key.sequence = task.sequence_number;
+    return key;
+}
+
+TaskHeap::~TaskHeap() {
+    for (TaskKey const& key : heap_) release(key.handle);
+}
+
+Task* TaskHeap::body(uint32_t slot) const noexcept {
+    Slot& raw = chunks_[slot >> kChunkBits][slot & (kChunkSlots - 1)];
+    return std::launder(reinterpret_cast<Task*>(raw.bytes));
+}
+
+uint32_t TaskHeap::acquireSlot() {
+    if (free_.empty()) {
+        auto first = static_cast<uint32_t>(chunks_.size() * kChunkSlots);
+        chunks_.push_back(std::make_unique<Slot[]>(kChunkSlots));
+        position_.resize(chunks_.size() * kChunkSlots);
+        free_.reserve(chunks_.size() * kChunkSlots);
+        // hand out the lowest slot first
+        for (size_t i = kChunkSlots; i-- > 0;) {
+            free_.push_back(first + static_cast<uint32_t>(i));
+        }
+    }
+    uint32_t slot = free_.back();
+    free_.pop_back();
+    return slot;
+}
+
+// Moves the body into a fresh slot, the heap entry is up to the caller.
+uint32_t TaskHeap::store(Task&& task, TaskKey& key) {
+    key = TaskKey::of(task);
+    key.handle = acquireSlot();
+    Slot& raw = chunks_[key.handle >> kChunkBits]
+                       [key.handle & (kChunkSlots - 1)];
+    Task* stored = ::new (static_cast<void*>(raw.bytes)) Task(std::move(task));
+    if (stored->state && !stored->state->recurring) {
+        stored->state->slot = key.handle;
+    }
+    return key.handle;
+}
+
+Task TaskHeap::release(uint32_t slot) noexcept {
+    Task* stored = body(slot);
+    if (stored->state && stored->state->slot == slot) {
+        stored->state->slot = TaskState::kNoSlot;
+    }
+    Task task = std::move(*stored);
+    stored->~Task();
+    free_.push_back(slot);
+    return task;
+}
+
+void TaskHeap::place(size_t index, TaskKey const& key) noexcept {
+    heap_[index] = key;
+    position_[key.handle] = static_cast<uint32_t>(index);
+}
+
+void TaskHeap::siftUp(size_t index) noexcept {
+    TaskKey key = heap_[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / kArity;
+        if (!(key < heap_[parent])) break;
+        place(index, heap_[parent]);
+        index = parent;
+    }
+    place(index, key);
+}
+
+void TaskHeap::siftDown(size_t index) noexcept {
+    TaskKey key = heap_[index];
+    size_t size = heap_.size();
+    while (true) {
+        size_t first = index * kArity + 1;
+        if (first >= size) break;
+        size_t last = std::min(first + kArity, size);
+        size_t best = first;
+        for (size_t child = first + 1; child < last; ++child) {
+            if (heap_[child] < heap_[best]) best = child;
+        }
+        if (!(heap_[best] < key)) break;
+        place(index, heap_[best]);
+        index = best;
+    }
+    place(index, key);
+}
+
+void TaskHeap::removeAt(size_t index) noexcept {
+    TaskKey last = heap_.back();
+    heap_.pop_back();
+    if (index == heap_.size()) return;
+
+    place(index, last);
+    if (index > 0 && last < heap_[(index - 1) / kArity]) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+}
+
+void TaskHeap::push(Task&& task) {
+    if (heap_.size() == heap_.capacity()) {
+        heap_.reserve(std::max<size_t>(2 * heap_.capacity(), kChunkSlots));
+    }
+    TaskKey key;
+    store(std::move(task), key);
+    heap_.push_back(key);
+    siftUp(heap_.size() - 1);
+}
+
+void TaskHeap::pushBatch(std::span<Task> tasks) {
+    size_t old_size = heap_.size();
+    size_t new_size = old_size + tasks.size();
+    if (heap_.capacity() < new_size) {
+        heap_.reserve(std::max(new_size, 2 * heap_.capacity()));
+    }
+
+    // heapify costs about 2n compares, sifting up k entries k log n
+    size_t depth = std::bit_width(new_size);
+    bool rebuild = tasks.size() * depth > 2 * new_size;
+
+    try {
+        for (Task& task : tasks) {
+            TaskKey key;
+            store(std::move(task), key);
+            heap_.push_back(key);
+            position_[key.handle] = static_cast<uint32_t>(heap_.size() - 1);
+            if (!rebuild) siftUp(heap_.size() - 1);
+        }
+    } catch (...) {
+        rebuild = true;
+        for (size_t i = heap_.size(); i-- > 0;) siftDown(i);
+        throw;
+    }
+
+    if (rebuild) {
+        for (size_t i = heap_.size(); i-- > 0;) siftDown(i);
+    }
+}
+
+Task TaskHeap::pop() {
+    uint32_t slot = heap_.front().handle;
+    removeAt(0);
+    return release(slot);
+}
+
+Task const& TaskHeap::top() const noexcept {
+    return *body(heap_.front().handle);
+}
+
+TaskKey const& TaskHeap::topKey() const noexcept {
+    return heap_.front();
+}
+
+Task* TaskHeap::find(TaskState const& state) noexcept {
+    uint32_t slot = state.slot;
+    if (slot >= position_.size()) return nullptr;
+    // the slot may be free or hold a different task by now
+    size_t index = position_[slot];
+    if (index >= heap_.size() || heap_[index].handle != slot) return nullptr;
+    Task* stored = body(slot);
+    return stored->state.get() == &state ? stored : nullptr;
+}
+
+void TaskHeap::update(Task& task) noexcept {
+    uint32_t slot = task.state->slot;
+    size_t index = position_[slot];
+    TaskKey key = TaskKey::of(task);
+    key.handle = slot;
+    bool earlier = key < heap_[index];
+    heap_[index] = key;
+    if (earlier) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+}
+
+Task TaskHeap::erase(Task& task) noexcept {
+    uint32_t slot = task.state->slot;
+    removeAt(position_[slot]);
+    return release(slot);
+}
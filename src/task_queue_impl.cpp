@@ -1,12 +1,18 @@
 #include "detail/task_queue_impl.h"
-#include <algorithm>
 
 using namespace scheduler::detail;
 
 void TaskQueue::push(Task&& task) {
     std::lock_guard<std::mutex> guard{mtx_};
-    heap_.push_back(std::move(task));
-    std::push_heap(heap_.begin(), heap_.end());
+    heap_.push(std::move(task));
+    size_.store(heap_.size(), std::memory_order_release);
+}
+
+void TaskQueue::pushBatch(std::span<Task> tasks) {
+    if (tasks.empty()) return;
+    std::lock_guard<std::mutex> guard{mtx_};
+    heap_.pushBatch(tasks);
+    size_.store(heap_.size(), std::memory_order_release);
 }
 
 std::optional<Task> TaskQueue::pop() {
@@ -15,10 +21,8 @@ std::optional<Task> TaskQueue::pop() {
         return std::nullopt;
     }
 
-    // move the largest to the back
-    std::pop_heap(heap_.begin(), heap_.end());
-    Task task = std::move((heap_.back()));
-    heap_.pop_back();
+    Task task = heap_.pop();
+    size_.store(heap_.size(), std::memory_order_release);
     return task;
 }
 
@@ -28,15 +32,41 @@ std::optional<std::reference_wrapper<const Task>> TaskQueue::peek() const {
         return std::nullopt;
     }
 
-    return std::cref(heap_.front());
+    return std::cref(heap_.top());
 }
 
-bool TaskQueue::empty() const {
+std::optional<Task> TaskQueue::erase(TaskState const& state) {
     std::lock_guard<std::mutex> guard{mtx_};
-    return heap_.empty();
+    Task* task = heap_.find(state);
+    if (!task) return std::nullopt;
+    Task removed = heap_.erase(*task);
+    size_.store(heap_.size(), std::memory_order_release);
+    return removed;
 }
 
-size_t TaskQueue::size() const {
+bool TaskQueue::reprioritize(TaskState const& state, int priority) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Task* task = heap_.find(state);
+    if (!task) return false;
+    task->priority = priority;
+    heap_.update(*task);
+    return true;
+}
+
+bool TaskQueue::changeDeadline(TaskState const& state,
+                               std::optional<time_point> deadline) {
     std::lock_guard<std::mutex> guard{mtx_};
-    return heap_.size();
+    Task* task = heap_.find(state);
+    if (!task) return false;
+    task->deadline = deadline;
+    heap_.update(*task);
+    return true;
+}
+
+bool TaskQueue::empty() const {
+    return size_.load(std::memory_order_acquire) == 0;
+}
+
+size_t TaskQueue::size() const {
+    return size_.load(std::memory_order_acquire);
 }
\ No newline at end of file
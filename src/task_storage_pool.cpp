@@ -0,0 +1,120 @@
+#include "scheduler/inplace_task.h"
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Block sizes handed out by the pool; larger requests go to operator new.
+constexpr std::array<std::size_t, 5> kSizeClasses{128, 256, 512, 1024, 2048};
+constexpr std::size_t kBlocksPerSlab = 32;
+// blocks a thread keeps for itself before spilling half to the shared list
+constexpr std::size_t kMaxCachedBlocks = 128;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct FreeList {
+    FreeBlock* head = nullptr;
+    std::size_t count = 0;
+
+    void push(void* block) noexcept {
+        auto* node = static_cast<FreeBlock*>(block);
+        node->next = head;
+        head = node;
+        ++count;
+    }
+
+    void* pop() noexcept {
+        FreeBlock* node = head;
+        head = node->next;
+        --count;
+        return node;
+    }
+};
+
+int sizeClass(std::size_t size) noexcept {
+    for (std::size_t i = 0; i < kSizeClasses.size(); ++i) {
+        if (size <= kSizeClasses[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// Shared spill area; slabs are never returned to the system.
+class GlobalPool {
+public:
+    void refill(int cls, FreeList& into) {
+        std::lock_guard<std::mutex> guard{mtx_};
+        FreeList& shared = lists_[cls];
+        if (shared.count == 0) {
+            std::size_t block = kSizeClasses[cls];
+            auto* slab = static_cast<unsigned char*>(
+                ::operator new(block * kBlocksPerSlab));
+            slabs_.push_back(slab);
+            for (std::size_t i = 0; i < kBlocksPerSlab; ++i) {
+                shared.push(slab + i * block);
+            }
+        }
+        for (std::size_t i = 0; i < kBlocksPerSlab && shared.count > 0; ++i) {
+            into.push(shared.pop());
+        }
+    }
+
+    void spill(int cls, FreeList& from, std::size_t keep) {
+        std::lock_guard<std::mutex> guard{mtx_};
+        while (from.count > keep) lists_[cls].push(from.pop());
+    }
+
+private:
+    std::mutex mtx_;
+    std::array<FreeList, kSizeClasses.size()> lists_;
+    std::vector<void*> slabs_;
+};
+
+GlobalPool& globalPool() {
+    // intentionally leaked: thread caches may flush into it during exit
+    static GlobalPool* pool = new GlobalPool;
+    return *pool;
+}
+
+struct ThreadCache {
+    std::array<FreeList, kSizeClasses.size()> lists;
+
+    ~ThreadCache() {
+        for (std::size_t cls = 0; cls < lists.size(); ++cls) {
+            globalPool().spill(static_cast<int>(cls), lists[cls], 0);
+        }
+    }
+};
+
+thread_local ThreadCache cache;
+
+} // namespace
+
+namespace scheduler::detail {
+
+void* allocateTaskStorage(std::size_t size) {
+    int cls = sizeClass(size);
+    if (cls < 0) return ::operator new(size);
+
+    FreeList& list = cache.lists[cls];
+    if (list.count == 0) globalPool().refill(cls, list);
+    return list.pop();
+}
+
+void deallocateTaskStorage(void* block, std::size_t size) noexcept {
+    int cls = sizeClass(size);
+    if (cls < 0) {
+        ::operator delete(block);
+        return;
+    }
+
+    FreeList& list = cache.lists[cls];
+    list.push(block);
+    if (list.count > kMaxCachedBlocks) {
+        globalPool().spill(cls, list, kMaxCachedBlocks / 2);
+    }
+}
+
+} // namespace scheduler::detail
@@ -1,9 +1,38 @@
 #include "detail/thread_pool_impl.h"
+#include <algorithm>
 
 using namespace scheduler::detail;
 
-ThreadPool::ThreadPool(size_t numThreads)
-: running{false}, thread_num{numThreads} {}
+namespace {
+size_t startingSize(size_t requested,
+                    std::optional<scheduler::ElasticThreads>& elastic) {
+    requested = std::max<size_t>(requested, 1);
+    if (!elastic) return requested;
+    elastic->min_threads = std::max<size_t>(elastic->min_threads, 1);
+    elastic->max_threads = std::max(elastic->max_threads, elastic->min_threads);
+    return std::clamp(requested, elastic->min_threads, elastic->max_threads);
+}
+}
+
+ThreadPool::ThreadPool(size_t numThreads, IdlePolicy idle,
+                       WorkerPlacement placement,
+                       std::optional<ElasticThreads> elastic_,
+                       size_t max_compensating_)
+: queued{0}, next_node{0}, running{false},
+  thread_num{startingSize(numThreads, elastic_)},
+  elastic{elastic_}, live{0}, grown{0}, retired{0},
+  max_compensating{max_compensating_}, blocked{0}, compensating{0},
+  compensations{0},
+  worker_plan{planWorkers(elastic ? elastic->max_threads : thread_num,
+                          placement,
+                          placement.numa ? detectNumaNodes()
+                                         : std::vector<NumaNode>{})},
+  parking{idle} {
+    for (size_t i = 0; i < worker_plan.nodes.size(); ++i) {
+        queues.push_back(std::make_unique<NodeQueue>());
+    }
+    workers.resize(worker_plan.workers.size() + max_compensating);
+}
 
 ThreadPool::~ThreadPool() {
     stop();
@@ -12,57 +41,266 @@ ThreadPool::~ThreadPool() {
 void ThreadPool::start() {
     {
         std::lock_guard<std::mutex> lock{queue_mutex};
-        if (running) return;
-        running = true;
+        if (running.load(std::memory_order_relaxed)) return;
+        running.store(true, std::memory_order_seq_cst);
     }
 
-    if (thread_num <= 0) thread_num = 1;
-    threads.reserve(thread_num);
-
-    for (size_t i = 0; i < thread_num; ++i) {
-        threads.emplace_back([this]{ this->workerLoop(); });
-    }
+    std::lock_guard<std::mutex> lock{resize_mutex};
+    for (size_t i = 0; i < thread_num; ++i) launch(i);
+    last_resize = clock_type::now();
 }
 
 void ThreadPool::stop() {
     {
-        std::unique_lock<std::mutex> lock{queue_mutex};
-        if (!running) return;
-        running = false;
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (!running.load(std::memory_order_relaxed)) return;
+        // a push that saw `running` is then visible to every worker that
+        // sees it cleared
+        std::vector<std::unique_lock<std::mutex>> node_locks;
+        for (auto& queue : queues) node_locks.emplace_back(queue->mtx);
+        running.store(false, std::memory_order_seq_cst);
     }
 
-    cv.notify_all();
+    parking.notifyAll();
+    // no worker is launched once `running` is clear; retiring workers need
+    // the lock, so join outside of it
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock{resize_mutex};
+        for (Worker& worker : workers) {
+            if (worker.thread.joinable()) {
+                threads.push_back(std::move(worker.thread));
+            }
+        }
+    }
     for (std::thread& active_thread : threads) {
         active_thread.join();
     }
-    threads.clear();
 }
 
-bool ThreadPool::submit(std::function<void()> job) {
+void ThreadPool::launch(size_t slot) {
+    Worker& worker = workers[slot];
+    // a retired worker may still be on its way out
+    if (worker.thread.joinable()) worker.thread.join();
+    // marked active only once the thread exists, in case that throws
+    worker.thread = std::thread([this, slot]{
+        // compensating slots share the placement of the regular ones
+        auto const& cpus =
+            worker_plan.workers[slot % worker_plan.workers.size()].cpus;
+        if (!cpus.empty()) pinCurrentThread(cpus);
+        if (max_compensating > 0) IBlockingObserver::current() = this;
+        this->workerLoop(slot);
+    });
+    worker.active = true;
+    live.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadPool::maybeGrow() {
+    // somebody idle will pick the work up
+    if (parking.idleWorkers() > 0) return;
+    if (live.load(std::memory_order_relaxed) >= elastic->max_threads) return;
+
+    std::unique_lock<std::mutex> lock{resize_mutex, std::try_to_lock};
+    if (!lock || !running.load(std::memory_order_seq_cst)) return;
+    auto now = clock_type::now();
+    if (now - last_resize < elastic->cooldown) return;
+
+    for (size_t slot = 0; slot < worker_plan.workers.size(); ++slot) {
+        if (workers[slot].active) continue;
+        launch(slot);
+        grown.fetch_add(1, std::memory_order_relaxed);
+        last_resize = now;
+        return;
+    }
+}
+
+bool ThreadPool::tryRetire(size_t slot) {
+    std::lock_guard<std::mutex> lock{resize_mutex};
+    auto now = clock_type::now();
+    if (live.load(std::memory_order_relaxed) <= elastic->min_threads ||
+        now - last_resize < elastic->cooldown ||
+        queued.load(std::memory_order_seq_cst) > 0 ||
+        !running.load(std::memory_order_seq_cst)) {
+        return false;
+    }
+    // work submitted from here on is picked up by the remaining workers
+    workers[slot].active = false;
+    live.fetch_sub(1, std::memory_order_relaxed);
+    retired.fetch_add(1, std::memory_order_relaxed);
+    last_resize = now;
+    return true;
+}
+
+void ThreadPool::enterBlocking() noexcept {
+    blocked.fetch_add(1, std::memory_order_seq_cst);
+    try {
+        if (capacity_listener) capacity_listener();
+        if (queued.load(std::memory_order_seq_cst) > 0) compensate();
+    } catch (...) {
+        // no thread to spare; the queued jobs wait for a worker as they
+        // would without compensation
+    }
+}
+
+void ThreadPool::leaveBlocking() noexcept {
+    blocked.fetch_sub(1, std::memory_order_seq_cst);
+    // an idle worker retires in place of the surplus one
+    if (compensating.load(std::memory_order_seq_cst) >
+        blocked.load(std::memory_order_seq_cst)) {
+        parking.notify(1);
+    }
+}
+
+void ThreadPool::compensate() {
+    // unpark before paying for a new thread
+    if (parking.idleWorkers() > 0) {
+        parking.notify(1);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{resize_mutex};
+    if (!running.load(std::memory_order_seq_cst)) return;
+    size_t extra = compensating.load(std::memory_order_seq_cst);
+    if (extra >= max_compensating ||
+        extra >= blocked.load(std::memory_order_seq_cst)) {
+        return;
+    }
+    // Any worker may retire in place of a compensating one, so the free
+    // slot may be a regular one; compensating slots are tried first.
+    for (size_t i = 0; i < workers.size(); ++i) {
+        size_t slot = (worker_plan.workers.size() + i) % workers.size();
+        if (workers[slot].active) continue;
+        launch(slot);
+        compensating.fetch_add(1, std::memory_order_seq_cst);
+        compensations.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+}
+
+bool ThreadPool::tryRetireCompensating(size_t slot) {
+    std::lock_guard<std::mutex> lock{resize_mutex};
+    if (compensating.load(std::memory_order_seq_cst) <=
+        blocked.load(std::memory_order_seq_cst)) {
+        return false;
+    }
+    // any worker may leave, the freed slot is what matters
+    compensating.fetch_sub(1, std::memory_order_seq_cst);
+    workers[slot].active = false;
+    live.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::push(std::span<Job> batch, size_t node) {
+    if (batch.empty()) return true;
+    auto now = elastic ? clock_type::now() : clock_type::time_point{};
+    size_t depth;
     {
-        std::lock_guard<std::mutex> lock{queue_mutex};
-        if (!running) return false;
-        jobs.emplace_back(std::move(job));
+        NodeQueue& queue = *queues[node];
+        std::lock_guard<std::mutex> lock{queue.mtx};
+        if (!running.load(std::memory_order_relaxed)) return false;
+        for (Job& job : batch) queue.jobs.push_back({std::move(job), now});
+        depth = queued.fetch_add(batch.size(), std::memory_order_seq_cst) +
+                batch.size();
+    }
+    parking.notify(batch.size());
+    if (elastic && depth > elastic->grow_queue_depth) maybeGrow();
+    if (max_compensating > 0 && blocked.load(std::memory_order_seq_cst) >
+                                    compensating.load(std::memory_order_seq_cst)) {
+        compensate();
     }
-    cv.notify_one();
     return true;
 }
 
-void ThreadPool::workerLoop() {
+bool ThreadPool::submit(Job job) {
+    return submitBatch(std::span<Job>{&job, 1});
+}
+
+bool ThreadPool::submitBatch(std::span<Job> batch) {
+    size_t node = queues.size() == 1
+        ? 0
+        : next_node.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    return push(batch, node);
+}
+
+bool ThreadPool::submitToNode(std::span<Job> batch, int node) {
+    size_t index = worker_plan.nodeIndex(node, queues.size());
+    if (index == queues.size()) return submitBatch(batch);
+    return push(batch, index);
+}
+
+bool ThreadPool::pop(size_t node, Queued& job) {
+    // the worker's own node first, then the others in turn
+    for (size_t i = 0; i < queues.size(); ++i) {
+        NodeQueue& queue = *queues[(node + i) % queues.size()];
+        std::lock_guard<std::mutex> lock{queue.mtx};
+        if (queue.jobs.empty()) continue;
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::hasWork() const noexcept {
+    return queued.load(std::memory_order_seq_cst) > 0 ||
+           !running.load(std::memory_order_seq_cst) ||
+           compensating.load(std::memory_order_seq_cst) >
+               blocked.load(std::memory_order_seq_cst);
+}
+
+void ThreadPool::workerLoop(size_t slot) {
+    size_t node = worker_plan.workers[slot % worker_plan.workers.size()].node;
+    std::optional<clock_type::time_point> idle_since;
+
     while (true) {
-        std::function<void()> job;
-        {
-            std::unique_lock<std::mutex> lock{queue_mutex};
-            cv.wait(lock, [this]{ return !running || !jobs.empty(); });
+        if (compensating.load(std::memory_order_seq_cst) >
+                blocked.load(std::memory_order_seq_cst) &&
+            tryRetireCompensating(slot)) {
+            break;
+        }
+        // read before looking at the queues, see stop()
+        bool stopping = !running.load(std::memory_order_seq_cst);
+        Queued entry;
+        if (!pop(node, entry)) {
+            if (stopping) break; // drain all jobs before exit
+            if (!elastic) {
+                parking.idle([this]{ return hasWork(); });
+                continue;
+            }
 
-            if (!running && jobs.empty()) break; // drain all jobs before exit
+            auto now = clock_type::now();
+            if (!idle_since) idle_since = now;
+            auto idle_for = now - *idle_since;
+            if (idle_for >= elastic->idle_timeout) {
+                if (tryRetire(slot)) break;
+                // keep the slot, look again after another timeout
+                idle_since = now;
+                idle_for = {};
+            }
+            parking.idle([this]{ return hasWork(); },
+                         elastic->idle_timeout - idle_for);
+            continue;
+        }
+        idle_since.reset();
 
-            job = std::move(jobs.front());
-            jobs.pop_front();
+        // more queued than this worker can take, pass the baton
+        if (queued.fetch_sub(1, std::memory_order_seq_cst) > 1) {
+            parking.notify(1);
+            if (elastic && clock_type::now() - entry.enqueued >
+                               elastic->grow_wait) {
+                maybeGrow();
+            }
+            // the idle worker compensate() woke instead of launching a
+            // thread may have been this one, taking other work
+            if (max_compensating > 0 &&
+                blocked.load(std::memory_order_seq_cst) >
+                    compensating.load(std::memory_order_seq_cst)) {
+                compensate();
+            }
         }
 
         try {
-            job();
+            entry.job();
         } catch (...) {
             // handle or log accordingly
         }
@@ -70,6 +308,28 @@ void ThreadPool::workerLoop() {
     }
 }
 
+size_t ThreadPool::laneCapacity(size_t) const noexcept {
+    size_t extra = std::min(blocked.load(std::memory_order_seq_cst),
+                            max_compensating);
+    return (elastic ? elastic->max_threads : thread_num) + extra;
+}
+
+void ThreadPool::onCapacityChange(std::function<void()> listener) {
+    capacity_listener = std::move(listener);
+}
+
+void ThreadPool::recordInto(std::shared_ptr<MetricsRecorder> metrics,
+                            std::shared_ptr<IClock> clock) {
+    parking.recordInto(std::move(metrics), std::move(clock));
+}
+
 size_t ThreadPool::threadCount() const noexcept {
-    return thread_num;
-}
\ No newline at end of file
+    return elastic ? live.load(std::memory_order_relaxed) : thread_num;
+}
+
+scheduler::WorkerCounts ThreadPool::workerCounts() const noexcept {
+    return {live.load(std::memory_order_relaxed),
+            grown.load(std::memory_order_relaxed),
+            retired.load(std::memory_order_relaxed),
+            compensations.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,180 @@
+#include "detail/timer_thread.h"
+#include "detail/statistics_calculator_impl.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+using namespace scheduler::detail;
+
+namespace {
+[[noreturn]] void throwErrno(char const* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+}
+
+TimerThread::TimerThread(std::shared_ptr<TimingWheel> timers,
+                         std::shared_ptr<ITaskQueue> queue,
+                         std::shared_ptr<IClock> clock,
+                         std::function<void(size_t)> on_fire)
+: timers_{std::move(timers)}, queue_{std::move(queue)},
+  clock_{std::move(clock)}, on_fire_{std::move(on_fire)},
+  jitter_{std::make_shared<StatisticsCalculator>()} {
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC, so its time points arm the timer as is
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) throwErrno("timerfd_create");
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_fd_ = event_fd_ < 0 ? -1 : epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        int error = errno;
+        if (event_fd_ >= 0) close(event_fd_);
+        close(timer_fd_);
+        errno = error;
+        throwErrno("eventfd/epoll_create1");
+    }
+    for (int fd : {timer_fd_, event_fd_}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            int error = errno;
+            close(epoll_fd_);
+            close(event_fd_);
+            close(timer_fd_);
+            errno = error;
+            throwErrno("epoll_ctl");
+        }
+    }
+#endif
+}
+
+TimerThread::~TimerThread() {
+    stop();
+#if defined(__linux__)
+    close(epoll_fd_);
+    close(event_fd_);
+    close(timer_fd_);
+#endif
+}
+
+void TimerThread::start() {
+    thread_ = std::thread([this] { run(); });
+}
+
+void TimerThread::stop() {
+    if (stopping_.exchange(true)) return;
+#if defined(__linux__)
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(event_fd_, &one, sizeof(one));
+#else
+    {
+        std::lock_guard<std::mutex> lock{arm_mutex_};
+        rearmed_ = true;
+    }
+    cv_.notify_one();
+#endif
+    if (thread_.joinable()) thread_.join();
+}
+
+void TimerThread::rearm(time_point at) {
+    if (at.time_since_epoch().count() >= armed_.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> lock{arm_mutex_};
+    armLocked(at);
+}
+
+void TimerThread::armLocked(time_point at) {
+    auto ticks = at.time_since_epoch().count();
+    if (ticks >= armed_.load(std::memory_order_relaxed)) return;
+    armed_.store(ticks, std::memory_order_release);
+#if defined(__linux__)
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        at.time_since_epoch());
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(since_epoch.count() / 1000000000);
+    spec.it_value.tv_nsec = static_cast<long>(since_epoch.count() % 1000000000);
+    // a zero it_value would disarm the timer instead of firing it
+    if (spec.it_value.tv_sec <= 0 && spec.it_value.tv_nsec <= 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+    bool failed = timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec,
+                                  nullptr) != 0;
+    settime_failed_.store(failed, std::memory_order_release);
+    if (failed) {
+        // the timerfd keeps its old expiry, so wake the thread to wait for
+        // this one with epoll_wait's timeout instead
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = write(event_fd_, &one, sizeof(one));
+    }
+#else
+    rearmed_ = true;
+    cv_.notify_one();
+#endif
+}
+
+void TimerThread::wait() {
+#if defined(__linux__)
+    int timeout_ms = -1;
+    auto armed = armed_.load(std::memory_order_acquire);
+    if (settime_failed_.load(std::memory_order_acquire) &&
+        armed != INT64_MAX) {
+        auto left = time_point{time_point::duration{armed}} -
+                    std::chrono::steady_clock::now();
+        timeout_ms = static_cast<int>(std::clamp<int64_t>(
+            std::chrono::ceil<std::chrono::milliseconds>(left).count(), 0,
+            INT_MAX));
+    }
+    epoll_event events[2];
+    while (epoll_wait(epoll_fd_, events, 2, timeout_ms) < 0 &&
+           errno == EINTR) {}
+    uint64_t count;
+    [[maybe_unused]] auto read_bytes = read(timer_fd_, &count, sizeof(count));
+    // drops the wake up armLocked() sends when the timerfd failed; stop()
+    // sets stopping_ before it signals, so its wake up is not lost
+    read_bytes = read(event_fd_, &count, sizeof(count));
+#else
+    // returns once the armed time has passed; rearm() only interrupts the
+    // sleep to pick up an earlier time
+    std::unique_lock<std::mutex> lock{arm_mutex_};
+    while (!stopping_.load(std::memory_order_acquire)) {
+        auto armed = armed_.load(std::memory_order_relaxed);
+        auto until = time_point{time_point::duration{armed}};
+        if (armed != INT64_MAX && std::chrono::steady_clock::now() >= until) {
+            break;
+        }
+        rearmed_ = false;
+        auto woken = [this] { return rearmed_; };
+        if (armed == INT64_MAX) {
+            cv_.wait(lock, woken);
+        } else {
+            cv_.wait_until(lock, until, woken);
+        }
+    }
+#endif
+}
+
+void TimerThread::run() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        wait();
+        if (stopping_.load(std::memory_order_acquire)) break;
+        {
+            // timers added from here on arm the timer again, so none of
+            // them is missed by the nextExpiry() below
+            std::lock_guard<std::mutex> lock{arm_mutex_};
+            armed_.store(INT64_MAX, std::memory_order_release);
+        }
+        if (size_t fired = timers_->advance(clock_->now(), *queue_,
+                                            jitter_.get())) {
+            on_fire_(fired);
+        }
+        if (auto next = timers_->nextExpiry()) rearm(*next);
+    }
+}
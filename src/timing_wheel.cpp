@@ -0,0 +1,416 @@
+#include "detail/timing_wheel.h"
+#include "detail/system_clock_impl.h"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+using namespace scheduler::detail;
+
+namespace {
+constexpr uint64_t kSlotMask = TimingWheel::kSlots - 1;
+
+constexpr uint64_t levelSpan(size_t level) noexcept {
+    return uint64_t{1} << (TimingWheel::kSlotBits * level);
+}
+
+// Fire of a fixed-rate timer. A fire that finds an earlier one still running
+// leaves its run to it rather than entering the callable alongside, so an
+// overrunning task catches up back to back, or once with skipped fires.
+class RateFire {
+public:
+    RateFire(std::shared_ptr<RecurringCall> call, bool skip_missed) noexcept
+    : call_{std::move(call)}, skip_missed_{skip_missed} {}
+
+    void operator()() {
+        auto& pending = call_->pending;
+        uint32_t ahead = pending.load(std::memory_order_relaxed);
+        do {
+            // one run owed to the running fire already covers this one
+            if (skip_missed_ && ahead > 1) return;
+        } while (!pending.compare_exchange_weak(ahead, ahead + 1,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_relaxed));
+        if (ahead > 0) return;
+
+        try {
+            do {
+                call_->fn();
+            } while (pending.fetch_sub(1, std::memory_order_acq_rel) > 1);
+        } catch (...) {
+            // the runs owed go with the one that threw
+            pending.store(0, std::memory_order_release);
+            throw;
+        }
+    }
+
+private:
+    std::shared_ptr<RecurringCall> call_;
+    bool skip_missed_;
+};
+
+// Fire of a fixed-delay timer. Files the timer again one interval after the
+// run returned, or right away if the fire is dropped unrun, so a shed or
+// discarded fire does not stop the timer.
+class DelayedFire {
+public:
+    DelayedFire(std::shared_ptr<RecurringCall> call,
+                std::weak_ptr<TimingWheel> wheel,
+                TimingWheel::TimerId id, milliseconds interval) noexcept
+    : call_{std::move(call)}, wheel_{std::move(wheel)}, id_{id},
+      interval_{interval} {}
+    DelayedFire(DelayedFire&& other) noexcept
+    : call_{std::move(other.call_)}, wheel_{std::move(other.wheel_)},
+      id_{std::exchange(other.id_, TimingWheel::kInvalidTimer)},
+      interval_{other.interval_} {}
+    DelayedFire& operator=(DelayedFire&&) = delete;
+    ~DelayedFire() { resume(); }
+
+    void operator()() {
+        struct Done {
+            DelayedFire& fire;
+            ~Done() { fire.resume(); }
+        } done{*this};
+        call_->fn();
+    }
+
+private:
+    void resume() noexcept {
+        auto id = std::exchange(id_, TimingWheel::kInvalidTimer);
+        if (id == TimingWheel::kInvalidTimer) return;
+        if (auto wheel = wheel_.lock()) {
+            wheel->resume(id, wheel->now() + interval_);
+        }
+    }
+
+    std::shared_ptr<RecurringCall> call_;
+    std::weak_ptr<TimingWheel> wheel_;
+    TimingWheel::TimerId id_;
+    milliseconds interval_;
+};
+}
+
+TimingWheel::TimingWheel(std::atomic<uint64_t>& sequence,
+                         milliseconds tick, time_point origin,
+                         std::shared_ptr<IClock> clock)
+: sequence_{sequence},
+  clock_{clock ? std::move(clock) : std::make_shared<SystemClock>()},
+  tick_{tick > milliseconds{0} ? tick : milliseconds{1}},
+  origin_{origin} {
+    heads_.fill(kNil);
+}
+
+uint64_t TimingWheel::toTick(time_point tp) const noexcept {
+    if (tp <= origin_) return 0;
+    return static_cast<uint64_t>((tp - origin_) / tick_);
+}
+
+time_point TimingWheel::toTime(uint64_t tick) const noexcept {
+    return origin_ + tick_ * static_cast<int64_t>(tick);
+}
+
+uint64_t TimingWheel::firstTick(time_point tp) const noexcept {
+    // round up so that a timer never fires before its time
+    uint64_t tick = toTick(tp);
+    if (toTime(tick) < tp) ++tick;
+    return tick;
+}
+
+// Files the timer for its fire at tick `due`, moved up to the timer's slack
+// grid and never into the past
+void TimingWheel::arm(uint32_t index, uint64_t due) {
+    Node& node = nodes_[index];
+    node.due = due;
+    node.expiry = (due + node.align - 1) / node.align * node.align;
+    if (node.expiry <= current_) {
+        link(index, kDueList);
+    } else {
+        file(index);
+    }
+}
+
+TimingWheel::TimerId TimingWheel::schedule(Task&& task, time_point fire_at,
+                                           RecurringOptions const& options) {
+    std::lock_guard<std::mutex> guard{mtx_};
+
+    uint32_t index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    Node& node = nodes_[index];
+    node.task.emplace(std::move(task));
+    if (node.task->interval > milliseconds{0}) {
+        // the one allocation of a recurring task, from the task pool; each
+        // fire only takes another reference to it
+        node.recurring = std::allocate_shared<RecurringCall>(
+            TaskStorageAllocator<RecurringCall>{}, std::move(node.task->task));
+    }
+    uint64_t slack = static_cast<uint64_t>(
+        std::max<int64_t>(0, options.slack / tick_));
+    node.align = slack ? std::bit_floor(slack) : 1;
+    node.fixed_delay = options.cadence == Cadence::FixedDelay;
+    node.skip_missed = options.missed == MissedFires::Skip;
+    arm(index, firstTick(fire_at));
+    ++live_;
+    return (uint64_t{node.generation} << 32) | index;
+}
+
+TimingWheel::Node* TimingWheel::findLocked(TimerId id) noexcept {
+    auto index = static_cast<uint32_t>(id & 0xFFFFFFFFu);
+    auto generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes_.size()) return nullptr;
+    Node& node = nodes_[index];
+    if (node.generation != generation || !node.task) return nullptr;
+    return &node;
+}
+
+bool TimingWheel::cancel(TimerId id) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    if (!findLocked(id)) return false;
+
+    auto index = static_cast<uint32_t>(id & 0xFFFFFFFFu);
+    // a fixed-delay timer whose fire is out is on no list
+    if (nodes_[index].bucket == kNil) --parked_;
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimingWheel::resume(TimerId id, time_point fire_at) {
+    time_point expiry;
+    {
+        std::lock_guard<std::mutex> guard{mtx_};
+        Node* node = findLocked(id);
+        if (!node || !node->fixed_delay || node->bucket != kNil) return false;
+        --parked_;
+        arm(static_cast<uint32_t>(id & 0xFFFFFFFFu), firstTick(fire_at));
+        expiry = toTime(node->expiry);
+    }
+    if (on_resume_) on_resume_(expiry);
+    return true;
+}
+
+void TimingWheel::onResume(std::function<void(time_point)> listener) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    on_resume_ = std::move(listener);
+}
+
+bool TimingWheel::reprioritize(TimerId id, int priority) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Node* node = findLocked(id);
+    if (!node) return false;
+    node->task->priority = priority;
+    return true;
+}
+
+bool TimingWheel::changeDeadline(TimerId id,
+                                 std::optional<time_point> deadline) {
+    std::lock_guard<std::mutex> guard{mtx_};
+    Node* node = findLocked(id);
+    if (!node) return false;
+    node->task->deadline = deadline;
+    return true;
+}
+
+void TimingWheel::file(uint32_t index) {
+    Node& node = nodes_[index];
+    uint64_t delta = node.expiry - current_;
+
+    for (size_t level = 0; level < kLevels; ++level) {
+        if (delta < levelSpan(level + 1) || level == kLevels - 1) {
+            // beyond the top level: park on the furthest slot and re-file
+            // on cascade
+            uint64_t expiry = std::min(node.expiry,
+                                       current_ + levelSpan(kLevels) - 1);
+            uint64_t slot = (expiry >> (kSlotBits * level)) & kSlotMask;
+            link(index, static_cast<uint32_t>(level * kSlots + slot));
+            return;
+        }
+    }
+}
+
+void TimingWheel::link(uint32_t index, uint32_t bucket) {
+    Node& node = nodes_[index];
+    uint32_t& head = bucket == kDueList ? due_ : heads_[bucket];
+    node.bucket = bucket;
+    node.prev = kNil;
+    node.next = head;
+    if (head != kNil) nodes_[head].prev = index;
+    head = index;
+    if (bucket != kDueList) {
+        occupied_[bucket / kSlots] |= uint64_t{1} << (bucket % kSlots);
+    }
+}
+
+void TimingWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.bucket == kNil) return;
+
+    uint32_t& head = node.bucket == kDueList ? due_ : heads_[node.bucket];
+    if (node.prev != kNil) nodes_[node.prev].next = node.next;
+    else head = node.next;
+    if (node.next != kNil) nodes_[node.next].prev = node.prev;
+
+    if (node.bucket != kDueList && head == kNil) {
+        occupied_[node.bucket / kSlots] &=
+            ~(uint64_t{1} << (node.bucket % kSlots));
+    }
+    node.prev = node.next = node.bucket = kNil;
+}
+
+void TimingWheel::release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.task.reset();
+    node.recurring.reset();
+    if (++node.generation == 0) node.generation = 1;
+    free_.push_back(index);
+    --live_;
+}
+
+void TimingWheel::cascade(size_t level) {
+    uint64_t slot = (current_ >> (kSlotBits * level)) & kSlotMask;
+    auto bucket = static_cast<uint32_t>(level * kSlots + slot);
+    uint32_t index = heads_[bucket];
+    heads_[bucket] = kNil;
+    occupied_[level] &= ~(uint64_t{1} << slot);
+
+    while (index != kNil) {
+        uint32_t next = nodes_[index].next;
+        nodes_[index].prev = nodes_[index].next = nodes_[index].bucket = kNil;
+        file(index);
+        index = next;
+    }
+}
+
+void TimingWheel::expireList(uint32_t index) {
+    while (index != kNil) {
+        Node& node = nodes_[index];
+        uint32_t next = node.next;
+        node.prev = node.next = node.bucket = kNil;
+        Task& task = *node.task;
+
+        if (task.interval > milliseconds{0} && node.fixed_delay) {
+            // stays off the wheel until the fire has run
+            auto id = (uint64_t{node.generation} << 32) | index;
+            fired_.emplace_back(
+                DelayedFire{node.recurring, weak_from_this(), id,
+                            task.interval},
+                task.priority,
+                sequence_.fetch_add(1, std::memory_order_relaxed),
+                task.interval, toTime(node.expiry), task.deadline,
+                task.state);
+            ++parked_;
+        } else if (task.interval > milliseconds{0}) {
+            fired_.emplace_back(RateFire{node.recurring, node.skip_missed},
+                                task.priority,
+                                sequence_.fetch_add(1, std::memory_order_relaxed),
+                                task.interval, toTime(node.expiry),
+                                task.deadline, task.state);
+            // fixed rate: advance() walks every tick, so periods that
+            // elapsed between two calls fire once each unless skipped
+            auto period = static_cast<uint64_t>(
+                std::max<int64_t>(1, (task.interval + tick_ - milliseconds{1})
+                                         / tick_));
+            uint64_t due = node.due + period;
+            if (node.skip_missed && due <= target_) {
+                due += (target_ - due) / period * period + period;
+            }
+            arm(index, std::max(due, current_ + 1));
+        } else {
+            task.enqueue_time = toTime(node.expiry);
+            fired_.push_back(std::move(task));
+            release(index);
+        }
+        index = next;
+    }
+}
+
+uint64_t TimingWheel::nextInterestingTick() const noexcept {
+    // either the next occupied level 0 slot in this rotation or the next
+    // rotation boundary, where the upper levels cascade
+    uint64_t slot = current_ & kSlotMask;
+    uint64_t ahead = slot == kSlotMask ? 0
+                                       : occupied_[0] & (~uint64_t{0} << (slot + 1));
+    if (ahead) {
+        return (current_ & ~kSlotMask) +
+               static_cast<uint64_t>(std::countr_zero(ahead));
+    }
+    return (current_ | kSlotMask) + 1;
+}
+
+size_t TimingWheel::advance(time_point now, ITaskQueue& queue,
+                            IStatisticsCalculator* jitter) {
+    std::lock_guard<std::mutex> guard{mtx_};
+
+    uint32_t due = due_;
+    due_ = kNil;
+    expireList(due);
+
+    uint64_t target = toTick(now);
+    target_ = target;
+    while (current_ < target) {
+        if (live_ == parked_) {
+            current_ = target;
+            break;
+        }
+
+        current_ = std::min(target, nextInterestingTick());
+        for (size_t level = kLevels - 1; level > 0; --level) {
+            if ((current_ & (levelSpan(level) - 1)) == 0) cascade(level);
+        }
+
+        auto bucket = static_cast<uint32_t>(current_ & kSlotMask);
+        uint32_t head = heads_[bucket];
+        if (head == kNil) continue;
+        heads_[bucket] = kNil;
+        occupied_[0] &= ~(uint64_t{1} << bucket);
+        expireList(head);
+    }
+
+    size_t fired = fired_.size();
+    if (fired == 0) return 0;
+    if (jitter) {
+        // a fire's enqueue time is the tick it was due on
+        for (Task const& task : fired_) {
+            jitter->updateLatencyStatistics(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - task.enqueue_time).count());
+        }
+    }
+    queue.pushBatch(fired_);
+    fired_.clear();
+    return fired;
+}
+
+std::optional<time_point> TimingWheel::nextExpiry() const {
+    std::lock_guard<std::mutex> guard{mtx_};
+    if (live_ == parked_) return std::nullopt;
+    if (due_ != kNil) return toTime(current_);
+
+    uint64_t earliest = UINT64_MAX;
+    for (size_t level = 0; level < kLevels; ++level) {
+        uint64_t occupied = occupied_[level];
+        if (!occupied) continue;
+        uint64_t position = current_ >> (kSlotBits * level);
+        auto shift = static_cast<int>(((position & kSlotMask) + 1) & kSlotMask);
+        // distance in slots to the next occupied one, 1..kSlots
+        uint64_t distance = static_cast<uint64_t>(
+            std::countr_zero(std::rotr(occupied, shift))) + 1;
+        earliest = std::min(earliest,
+                            (position + distance) << (kSlotBits * level));
+    }
+    return toTime(earliest);
+}
+
+size_t TimingWheel::size() const {
+    std::lock_guard<std::mutex> guard{mtx_};
+    return live_;
+}
+
+milliseconds TimingWheel::tickResolution() const noexcept {
+    return tick_;
+}
@@ -0,0 +1,168 @@
+#include "detail/tracer.h"
+#include "detail/file_io.h"
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+
+using namespace scheduler::detail;
+
+namespace {
+struct Event {
+    Tracer::Kind kind;
+    uint32_t thread;
+    uint64_t task;
+    int64_t first;   // ns since the tracer's origin
+    int64_t second;
+    int priority;
+    uint32_t lane;
+};
+
+// appends microseconds with the nanoseconds as fraction; clocks of
+// different sources may put a time a little before the origin
+void appendMicros(std::string& out, int64_t nanos) {
+    nanos = std::max<int64_t>(nanos, 0);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%" PRId64 ".%03" PRId64,
+                  nanos / 1000, nanos % 1000);
+    out += buffer;
+}
+
+void appendAsync(std::string& out, char const* name, char phase,
+                 uint32_t thread, uint64_t task, int64_t at) {
+    out += ",\n{\"name\":\"";
+    out += name;
+    out += "\",\"cat\":\"wait\",\"ph\":\"";
+    out += phase;
+    out += "\",\"pid\":1,\"tid\":" + std::to_string(thread) +
+           ",\"id\":" + std::to_string(task) + ",\"ts\":";
+    appendMicros(out, at);
+    out += '}';
+}
+}
+
+Tracer::Ring::Ring(size_t capacity)
+: slots{std::make_unique<Slot[]>(capacity)}, mask{capacity - 1} {}
+
+Tracer::Tracer(size_t events_per_thread)
+: capacity_{std::bit_ceil(std::max<size_t>(events_per_thread, 2))},
+  origin_{std::chrono::steady_clock::now()} {}
+
+void Tracer::dispatched(uint64_t task, time_point enqueued,
+                        time_point dispatched, int priority, size_t lane) {
+    record(local(), Kind::Dispatched, task, enqueued, dispatched,
+           uint64_t(uint32_t(priority)) | uint64_t(lane) << 32);
+}
+
+void Tracer::ran(uint64_t task, time_point started, time_point ended) {
+    record(local(), Kind::Ran, task, started, ended, 0);
+}
+
+void Tracer::record(Ring& ring, Kind kind, uint64_t task, time_point first,
+                    time_point second, uint64_t extra) {
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    Slot& slot = ring.slots[head & ring.mask];
+    uint64_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto since = [this](time_point at) {
+        return uint64_t((at - origin_).count());
+    };
+    slot.words[0].store(uint64_t(kind) << 32 | ring.thread,
+                        std::memory_order_relaxed);
+    slot.words[1].store(task, std::memory_order_relaxed);
+    slot.words[2].store(since(first), std::memory_order_relaxed);
+    slot.words[3].store(since(second), std::memory_order_relaxed);
+    slot.words[4].store(extra, std::memory_order_relaxed);
+
+    slot.version.store(version + 2, std::memory_order_release);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+Tracer::Ring& Tracer::local() {
+    return rings_.local(
+        [this] { return std::make_shared<Ring>(capacity_); },
+        [this](Ring& ring) {
+            ring.thread = next_thread_.fetch_add(1, std::memory_order_relaxed);
+        });
+}
+
+std::string Tracer::render() const {
+    // keyed by task, which also drops an event read twice when its writer
+    // lapped the reader
+    std::map<uint64_t, Event> dispatches;
+    std::map<uint64_t, Event> runs;
+    rings_.forEach([&](Ring const& ring) {
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t begin = head > capacity_ ? head - capacity_ : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            Slot const& slot = ring.slots[i & ring.mask];
+            uint64_t version = slot.version.load(std::memory_order_acquire);
+            std::array<uint64_t, 5> words;
+            for (size_t w = 0; w < words.size(); ++w) {
+                words[w] = slot.words[w].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version % 2 != 0 || version !=
+                    slot.version.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            Event event{Kind(words[0] >> 32), uint32_t(words[0]),
+                        words[1], int64_t(words[2]), int64_t(words[3]),
+                        int(uint32_t(words[4])),
+                        uint32_t(words[4] >> 32)};
+            auto& events = event.kind == Kind::Dispatched ? dispatches : runs;
+            events.insert_or_assign(event.task, event);
+        }
+    });
+
+    std::map<uint32_t, char const*> threads;
+    for (auto const& [task, event] : dispatches) {
+        threads[event.thread] = "dispatcher";
+    }
+    for (auto const& [task, event] : runs) {
+        threads.try_emplace(event.thread, "worker");
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+        "\"args\":{\"name\":\"scheduler\"}}";
+    for (auto const& [thread, role] : threads) {
+        out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" +
+               std::to_string(thread) + ",\"args\":{\"name\":\"" + role +
+               ' ' + std::to_string(thread) + "\"}}";
+    }
+    for (auto const& [task, run] : runs) {
+        out += ",\n{\"name\":\"task\",\"cat\":\"run\",\"ph\":\"X\",\"pid\":1,"
+               "\"tid\":" + std::to_string(run.thread) + ",\"ts\":";
+        appendMicros(out, run.first);
+        out += ",\"dur\":";
+        appendMicros(out, std::max<int64_t>(run.second - run.first, 0));
+        out += ",\"args\":{\"task\":" + std::to_string(task);
+        if (auto it = dispatches.find(task); it != dispatches.end()) {
+            out += ",\"priority\":" + std::to_string(it->second.priority) +
+                   ",\"lane\":" + std::to_string(it->second.lane);
+        }
+        out += "}}";
+    }
+    // async spans for the two waits: in the queue, then for a worker
+    for (auto const& [task, dispatch] : dispatches) {
+        appendAsync(out, "queued", 'b', dispatch.thread, task, dispatch.first);
+        appendAsync(out, "queued", 'e', dispatch.thread, task,
+                    dispatch.second);
+        if (auto it = runs.find(task); it != runs.end()) {
+            appendAsync(out, "pool", 'b', dispatch.thread, task,
+                        dispatch.second);
+            appendAsync(out, "pool", 'e', dispatch.thread, task,
+                        it->second.first);
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool Tracer::write(std::string const& path) const {
+    return writeFileAtomically(path, render());
+}
@@ -0,0 +1,125 @@
+#include "detail/tsc_clock_impl.h"
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+using namespace scheduler::detail;
+using steady = std::chrono::steady_clock;
+
+namespace {
+uint64_t readTsc() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+int64_t steadyNanos() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        steady::now().time_since_epoch()).count();
+}
+
+// A counter reading and the steady_clock time it was taken at, bracketed
+// tightly so a preemption in between does not skew the pair.
+struct Sample {
+    uint64_t tsc;
+    int64_t ns;
+};
+
+Sample sample() noexcept {
+    Sample best{};
+    int64_t best_gap = INT64_MAX;
+    for (int i = 0; i < 5; ++i) {
+        uint64_t before = readTsc();
+        int64_t ns = steadyNanos();
+        uint64_t after = readTsc();
+        if (int64_t(after - before) < best_gap) {
+            best_gap = int64_t(after - before);
+            best = {before + (after - before) / 2, ns};
+        }
+    }
+    return best;
+}
+
+uint64_t multiplier(Sample from, Sample to, unsigned shift) noexcept {
+    uint64_t ticks = to.tsc - from.tsc;
+    if (ticks == 0) return 0;
+    auto ns = static_cast<unsigned __int128>(to.ns - from.ns);
+    return static_cast<uint64_t>((ns << shift) / ticks);
+}
+
+// nanoseconds per tick scaled by 2^32, measured once per process
+uint64_t calibrated(unsigned shift) {
+    static uint64_t const mult = [shift] {
+        Sample start = sample();
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        return multiplier(start, sample(), shift);
+    }();
+    return mult;
+}
+}
+
+bool TscClock::available() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+TscClock::TscClock() {
+    uint64_t mult = calibrated(kShift);
+    Sample now = sample();
+    base_tsc_.store(now.tsc, std::memory_order_relaxed);
+    base_ns_.store(now.ns, std::memory_order_relaxed);
+    mult_.store(mult, std::memory_order_relaxed);
+    refresh_ticks_ = mult ? (uint64_t{1000000000} << kShift) / mult : UINT64_MAX;
+}
+
+std::chrono::steady_clock::time_point TscClock::now() const noexcept {
+    uint64_t tsc = readTsc();
+    for (;;) {
+        uint32_t seq = seq_.load(std::memory_order_acquire);
+        // rather than wait for a re-anchor that may be preempted
+        if (seq & 1) return steady::now();
+        uint64_t base_tsc = base_tsc_.load(std::memory_order_relaxed);
+        int64_t base_ns = base_ns_.load(std::memory_order_relaxed);
+        uint64_t mult = mult_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) != seq) continue;
+
+        // a reading taken just before another thread re-anchored is behind
+        // the new base
+        auto ticks = static_cast<int64_t>(tsc - base_tsc);
+        if (ticks > int64_t(refresh_ticks_) &&
+            seq_.compare_exchange_strong(seq, seq + 1,
+                                         std::memory_order_acq_rel)) {
+            reanchor();
+            continue;
+        }
+        auto scaled = static_cast<__int128>(ticks) * mult;
+        auto ns = static_cast<int64_t>(scaled >> kShift);
+        return steady::time_point{
+            std::chrono::nanoseconds{base_ns + ns}};
+    }
+}
+
+// Called with `seq_` odd
+void TscClock::reanchor() const noexcept {
+    std::atomic_thread_fence(std::memory_order_release);
+    Sample from{base_tsc_.load(std::memory_order_relaxed),
+                base_ns_.load(std::memory_order_relaxed)};
+    Sample to = sample();
+    if (uint64_t mult = multiplier(from, to, kShift)) {
+        mult_.store(mult, std::memory_order_relaxed);
+    }
+    base_tsc_.store(to.tsc, std::memory_order_relaxed);
+    base_ns_.store(to.ns, std::memory_order_relaxed);
+    seq_.fetch_add(1, std::memory_order_release);
+}
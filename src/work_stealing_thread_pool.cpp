@@ -0,0 +1,214 @@
+#include "detail/work_stealing_thread_pool_impl.h"
+
+using namespace scheduler::detail;
+
+namespace {
+// Identifies the pool and deque of the worker running on this thread, so
+// that nested submissions can go to the local deque.
+struct WorkerContext {
+    const WorkStealingThreadPool* pool = nullptr;
+    size_t index = 0;
+};
+thread_local WorkerContext current_worker;
+
+// Deque slots hold pointers, the jobs themselves come from the task pool.
+Job* makeJob(Job&& job) {
+    return ::new (allocateTaskStorage(sizeof(Job))) Job(std::move(job));
+}
+
+void destroyJob(Job* job) noexcept {
+    job->~Job();
+    deallocateTaskStorage(job, sizeof(Job));
+}
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t numThreads,
+                                               IdlePolicy idle,
+                                               WorkerPlacement placement)
+: running{false}, pending{0}, steals{0}, idles{0}, next_node{0},
+  thread_num{numThreads > 0 ? numThreads : 1},
+  worker_plan{planWorkers(thread_num, placement,
+                          placement.numa ? detectNumaNodes()
+                                         : std::vector<NumaNode>{})},
+  parking{idle} {
+    for (size_t i = 0; i < worker_plan.nodes.size(); ++i) {
+        injection.push_back(std::make_unique<Injection>());
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+    stop();
+}
+
+void WorkStealingThreadPool::start() {
+    {
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (running.load(std::memory_order_relaxed)) return;
+        running.store(true, std::memory_order_relaxed);
+    }
+
+    workers.clear();
+    workers.reserve(thread_num);
+    for (size_t i = 0; i < thread_num; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    // every deque must exist before any worker starts stealing
+    for (size_t i = 0; i < thread_num; ++i) {
+        workers[i]->thread = std::thread([this, i]{
+            auto const& cpus = worker_plan.workers[i].cpus;
+            if (!cpus.empty()) pinCurrentThread(cpus);
+            this->workerLoop(i);
+        });
+    }
+}
+
+void WorkStealingThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock{queue_mutex};
+        if (!running.load(std::memory_order_relaxed)) return;
+        // an injection that saw `running` is then counted in `pending`
+        // for every worker that sees it cleared
+        std::vector<std::unique_lock<std::mutex>> node_locks;
+        for (auto& node : injection) node_locks.emplace_back(node->mtx);
+        running.store(false, std::memory_order_seq_cst);
+    }
+
+    parking.notifyAll();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+bool WorkStealingThreadPool::submit(Job job) {
+    return submitBatch(std::span<Job>{&job, 1});
+}
+
+bool WorkStealingThreadPool::submitBatch(std::span<Job> jobs) {
+    if (jobs.empty()) return true;
+
+    if (current_worker.pool == this) {
+        if (!running.load(std::memory_order_acquire)) return false;
+        auto& deque = workers[current_worker.index]->deque;
+        for (Job& job : jobs) deque.push(makeJob(std::move(job)));
+        pending.fetch_add(jobs.size(), std::memory_order_seq_cst);
+        parking.notify(jobs.size());
+        return true;
+    }
+
+    size_t node = injection.size() == 1
+        ? 0
+        : next_node.fetch_add(1, std::memory_order_relaxed) % injection.size();
+    return inject(jobs, node);
+}
+
+bool WorkStealingThreadPool::submitToNode(std::span<Job> jobs, int node) {
+    size_t index = worker_plan.nodeIndex(node, injection.size());
+    if (index == injection.size()) return submitBatch(jobs);
+    return inject(jobs, index);
+}
+
+void WorkStealingThreadPool::recordInto(
+    std::shared_ptr<MetricsRecorder> metrics, std::shared_ptr<IClock> clock) {
+    parking.recordInto(std::move(metrics), std::move(clock));
+}
+
+bool WorkStealingThreadPool::inject(std::span<Job> jobs, size_t node) {
+    if (jobs.empty()) return true;
+    {
+        Injection& queue = *injection[node];
+        std::lock_guard<std::mutex> lock{queue.mtx};
+        if (!running.load(std::memory_order_relaxed)) return false;
+        for (Job& job : jobs) queue.jobs.push_back(makeJob(std::move(job)));
+        pending.fetch_add(jobs.size(), std::memory_order_seq_cst);
+    }
+    parking.notify(jobs.size());
+    return true;
+}
+
+Job* WorkStealingThreadPool::findWork(size_t index) {
+    if (Job* job = workers[index]->deque.pop()) return job;
+
+    size_t node = worker_plan.workers[index].node;
+    if (Job* job = takeInjected(node)) return job;
+    if (Job* job = stealFrom(index, true)) return job;
+
+    // nothing left on this node, help the others
+    for (size_t i = 1; i < injection.size(); ++i) {
+        if (Job* job = takeInjected((node + i) % injection.size())) return job;
+    }
+    return injection.size() > 1 ? stealFrom(index, false) : nullptr;
+}
+
+Job* WorkStealingThreadPool::takeInjected(size_t node) {
+    Injection& queue = *injection[node];
+    std::lock_guard<std::mutex> lock{queue.mtx};
+    if (queue.jobs.empty()) return nullptr;
+    Job* job = queue.jobs.front();
+    queue.jobs.pop_front();
+    return job;
+}
+
+Job* WorkStealingThreadPool::stealFrom(size_t index, bool same_node) {
+    size_t node = worker_plan.workers[index].node;
+    for (size_t offset = 1; offset < workers.size(); ++offset) {
+        size_t victim = (index + offset) % workers.size();
+        if ((worker_plan.workers[victim].node == node) != same_node) continue;
+        if (Job* job = workers[victim]->deque.steal()) {
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingThreadPool::workerLoop(size_t index) {
+    current_worker = WorkerContext{this, index};
+    bool idle = false;
+
+    while (true) {
+        Job* job = findWork(index);
+
+        if (!job) {
+            // drain all jobs before exit
+            if (!running.load(std::memory_order_seq_cst) &&
+                pending.load(std::memory_order_seq_cst) == 0) break;
+
+            if (!idle) {
+                idle = true;
+                idles.fetch_add(1, std::memory_order_relaxed);
+            }
+            parking.idle([this]{
+                return !running.load(std::memory_order_seq_cst) ||
+                       pending.load(std::memory_order_seq_cst) > 0;
+            });
+            continue;
+        }
+        idle = false;
+
+        // more submitted than this worker can take, pass the baton
+        if (pending.fetch_sub(1, std::memory_order_seq_cst) > 1) {
+            parking.notify(1);
+        }
+        try {
+            (*job)();
+        } catch (...) {
+            // handle or log accordingly
+        }
+        destroyJob(job);
+    }
+
+    current_worker = WorkerContext{};
+}
+
+size_t WorkStealingThreadPool::threadCount() const noexcept {
+    return thread_num;
+}
+
+uint64_t WorkStealingThreadPool::stealCount() const noexcept {
+    return steals.load(std::memory_order_relaxed);
+}
+
+uint64_t WorkStealingThreadPool::idleCount() const noexcept {
+    return idles.load(std::memory_order_relaxed);
+}
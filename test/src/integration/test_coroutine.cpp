@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "scheduler/scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+scheduler::CoTask steps(scheduler::Scheduler& sched, std::thread::id caller,
+                        std::promise<bool>& done)
+{
+    co_await sched.yield(1);
+    bool moved = std::this_thread::get_id() != caller;
+    co_await sched.atDeadline(clock_type::now() + 10ms);
+    co_await sched.yield();
+    done.set_value(moved);
+}
+
+scheduler::CoTask sleeper(scheduler::Scheduler& sched,
+                          clock_type::time_point wake_at,
+                          std::promise<clock_type::time_point>& woke)
+{
+    co_await sched.sleepUntil(wake_at);
+    woke.set_value(clock_type::now());
+}
+
+scheduler::CoTask record(scheduler::Scheduler& sched, int priority,
+                         std::mutex& mtx, std::vector<int>& order,
+                         std::promise<void>& done)
+{
+    co_await sched.yield(priority);
+    std::lock_guard<std::mutex> lock{mtx};
+    order.push_back(priority);
+    if (order.size() == 3) done.set_value();
+}
+
+scheduler::CoTask neverWakes(scheduler::Scheduler& sched,
+                             std::shared_ptr<int> token)
+{
+    co_await sched.sleepUntil(clock_type::now() + 1h);
+    *token = 1;
+}
+}
+
+TEST(Coroutine, StepsRunOnWorkers)
+{
+    scheduler::Scheduler sched{2};
+    std::promise<bool> done;
+    steps(sched, std::this_thread::get_id(), done);
+    auto result = done.get_future();
+    ASSERT_EQ(std::future_status::ready, result.wait_for(1s));
+    EXPECT_TRUE(result.get());
+}
+
+TEST(Coroutine, SleepUntilDoesNotHoldAWorker)
+{
+    scheduler::Scheduler sched{1};
+    auto wake_at = clock_type::now() + 200ms;
+    std::promise<clock_type::time_point> woke;
+    sleeper(sched, wake_at, woke);
+
+    // the only worker stays free while the coroutine sleeps
+    std::promise<void> ran;
+    sched.schedule([&] { ran.set_value(); }, 0);
+    ASSERT_EQ(std::future_status::ready, ran.get_future().wait_for(150ms));
+
+    auto woke_at = woke.get_future();
+    ASSERT_EQ(std::future_status::ready, woke_at.wait_for(1s));
+    EXPECT_GE(woke_at.get(), wake_at);
+}
+
+TEST(Coroutine, YieldHonoursPriority)
+{
+    scheduler::Scheduler sched{1};
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> done;
+
+    sched.schedule([gate_future] { gate_future.wait(); }, 100);
+    std::this_thread::sleep_for(20ms);
+    for (int p : {1, 5, 3}) record(sched, p, mtx, order, done);
+    gate.set_value();
+
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    EXPECT_EQ(order, (std::vector<int>{5, 3, 1}));
+}
+
+TEST(Coroutine, PendingCoroutineIsDestroyedWithScheduler)
+{
+    auto token = std::make_shared<int>(0);
+    {
+        scheduler::Scheduler sched{1};
+        neverWakes(sched, token);
+        EXPECT_EQ(token.use_count(), 2);
+    }
+    EXPECT_EQ(token.use_count(), 1);
+    EXPECT_EQ(*token, 0);
+}
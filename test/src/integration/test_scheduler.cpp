@@ -0,0 +1,817 @@
+#include <gtest/gtest.h>
+#include "scheduler/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(Scheduler, RunsScheduledTask)
+{
+    scheduler::Scheduler sched{2};
+    std::promise<void> done;
+    sched.schedule([&] { done.set_value(); }, 1);
+    ASSERT_EQ(std::future_status::ready,
+              done.get_future().wait_for(1s));
+}
+
+TEST(Scheduler, HigherPriorityRunsFirstOnceWorkersAreBusy)
+{
+    scheduler::Scheduler sched{1};
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> done;
+
+    // occupy the only worker so the rest queue up
+    sched.schedule([gate_future] { gate_future.wait(); }, 100);
+    std::this_thread::sleep_for(20ms);
+    for (int p : {1, 5, 3}) {
+        sched.schedule([&, p] {
+            std::lock_guard<std::mutex> lock{mtx};
+            order.push_back(p);
+            if (order.size() == 3) done.set_value();
+        }, p);
+    }
+    gate.set_value();
+
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    EXPECT_EQ(order, (std::vector<int>{5, 3, 1}));
+}
+
+TEST(Scheduler, RecurringTaskKeepsFiring)
+{
+    std::atomic<int> runs{0};
+    {
+        scheduler::Scheduler sched{2};
+        sched.scheduleRecurring([&] { runs.fetch_add(1); }, 1, 5ms);
+        std::this_thread::sleep_for(100ms);
+    }
+    EXPECT_GE(runs.load(), 5);
+}
+
+TEST(Scheduler, QueuedTasksRunBeforeShutdown)
+{
+    std::atomic<int> runs{0};
+    {
+        scheduler::Scheduler sched{2};
+        for (int i = 0; i < 100; ++i) {
+            sched.schedule([&] { runs.fetch_add(1); }, i);
+        }
+    }
+    EXPECT_EQ(runs.load(), 100);
+}
+
+TEST(Scheduler, RecordsLatency)
+{
+    scheduler::Scheduler sched{2};
+    std::promise<void> done;
+    sched.schedule([&] { done.set_value(); }, 1);
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+
+    auto [avg, mn, mx] = sched.getLatencyStatistics();
+    EXPECT_GE(avg, 0.0);
+    EXPECT_LE(mn, mx);
+}
+
+TEST(Scheduler, ReportsLatencyPercentiles)
+{
+    scheduler::Scheduler sched{2};
+    std::atomic<int> runs{0};
+    std::promise<void> done;
+    for (int i = 0; i < 50; ++i) {
+        sched.schedule([&] {
+            if (runs.fetch_add(1) + 1 == 50) done.set_value();
+        }, 1);
+    }
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+
+    auto hist = sched.getLatencyHistogram();
+    EXPECT_EQ(hist.count(), 50u);
+    EXPECT_LE(sched.getLatencyPercentile(50.0),
+              sched.getLatencyPercentile(99.9));
+
+    EXPECT_EQ(sched.resetLatencyHistogram().count(), 50u);
+    EXPECT_EQ(sched.getLatencyHistogram().count(), 0u);
+}
+
+TEST(Scheduler, ScheduleBatchRunsEveryTask)
+{
+    constexpr int N = 300;
+    std::atomic<int> runs{0};
+    std::promise<void> done;
+    {
+        scheduler::Scheduler sched{4};
+        std::vector<scheduler::BatchTask> batch;
+        for (int i = 0; i < N; ++i) {
+            batch.push_back({[&] {
+                if (runs.fetch_add(1) + 1 == N) done.set_value();
+            }, i % 5, std::nullopt});
+        }
+        sched.scheduleBatch(batch);
+        ASSERT_EQ(std::future_status::ready,
+                  done.get_future().wait_for(2s));
+    }
+    EXPECT_EQ(runs.load(), N);
+}
+
+TEST(Scheduler, CancelledTaskNeverRuns)
+{
+    scheduler::Scheduler sched{1};
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    std::atomic<int> cancelled_runs{0};
+    std::promise<void> done;
+
+    sched.schedule([gate_future] { gate_future.wait(); }, 100);
+    std::this_thread::sleep_for(20ms);
+    auto handle = sched.schedule([&] { cancelled_runs.fetch_add(1); }, 1);
+    sched.schedule([&] { done.set_value(); }, 0);
+
+    EXPECT_TRUE(handle.cancel());
+    EXPECT_FALSE(handle.cancel());
+    EXPECT_FALSE(handle.reprioritize(5));
+    gate.set_value();
+
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    EXPECT_EQ(cancelled_runs.load(), 0);
+}
+
+TEST(Scheduler, ReprioritizeReordersQueuedTasks)
+{
+    scheduler::Scheduler sched{1};
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> done;
+
+    sched.schedule([gate_future] { gate_future.wait(); }, 100);
+    std::this_thread::sleep_for(20ms);
+    std::vector<scheduler::TaskHandle> handles;
+    for (int id : {1, 2, 3}) {
+        handles.push_back(sched.schedule([&, id] {
+            std::lock_guard<std::mutex> lock{mtx};
+            order.push_back(id);
+            if (order.size() == 3) done.set_value();
+        }, id));
+    }
+    EXPECT_TRUE(handles[0].reprioritize(10));
+    EXPECT_TRUE(handles[1].changeDeadline(std::chrono::steady_clock::now()));
+    gate.set_value();
+
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    EXPECT_EQ(order, (std::vector<int>{2, 1, 3}));
+    EXPECT_FALSE(handles[0].cancel());
+}
+
+TEST(Scheduler, CancelStopsRecurringTask)
+{
+    std::atomic<int> runs{0};
+    scheduler::Scheduler sched{2};
+    auto handle = sched.scheduleRecurring([&] { runs.fetch_add(1); }, 1, 5ms);
+    std::this_thread::sleep_for(50ms);
+    EXPECT_TRUE(handle.cancel());
+    std::this_thread::sleep_for(10ms);
+    int after_cancel = runs.load();
+    std::this_thread::sleep_for(50ms);
+    EXPECT_GT(after_cancel, 0);
+    EXPECT_EQ(runs.load(), after_cancel);
+    EXPECT_FALSE(handle.cancel());
+}
+
+TEST(Scheduler, HandleOutlivesScheduler)
+{
+    scheduler::TaskHandle handle;
+    EXPECT_FALSE(handle);
+    {
+        scheduler::Scheduler sched{1};
+        handle = sched.scheduleRecurring([] {}, 1, 1h);
+        EXPECT_TRUE(handle);
+    }
+    EXPECT_FALSE(handle.reprioritize(2));
+    EXPECT_FALSE(handle.cancel());
+}
+
+TEST(Scheduler, NumaPlacementHonoursNodeHints)
+{
+    scheduler::WorkerPlacement placement;
+    placement.numa = true;
+    scheduler::Scheduler sched{2, placement};
+    std::atomic<int> runs{0};
+    std::promise<void> done;
+    // node 0 always exists, node 1000 never does and runs anywhere
+    for (int node : {scheduler::kAnyNode, 0, 1000}) {
+        sched.schedule([&] {
+            if (runs.fetch_add(1) == 2) done.set_value();
+        }, 0, std::nullopt, node);
+    }
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+}
+
+TEST(Scheduler, PriorityLanesKeepUrgentTasksAheadOfLongOnes)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 2;
+    options.lanes = {{10, 1, false}, {0, 0}};
+    scheduler::Scheduler sched{options};
+    ASSERT_EQ(sched.laneCount(), 2u);
+    EXPECT_EQ(sched.laneOf(50), 0u);
+    EXPECT_EQ(sched.laneOf(3), 1u);
+
+    // more long low priority tasks than there are workers
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    for (int i = 0; i < 4; ++i) {
+        sched.schedule([gate] { gate.wait(); }, 1);
+    }
+    std::this_thread::sleep_for(20ms);
+
+    std::promise<void> urgent;
+    sched.schedule([&] { urgent.set_value(); }, 10);
+    EXPECT_EQ(std::future_status::ready, urgent.get_future().wait_for(1s));
+    release.set_value();
+
+    // only the urgent task has started so far in its lane
+    auto high = sched.getLaneLatencyHistogram(0);
+    EXPECT_EQ(high.count(), 1u);
+    EXPECT_LT(high.max(), 500000);
+}
+
+TEST(Scheduler, ElasticPoolRunsTasksAndReportsCounts)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.elastic = scheduler::ElasticThreads{};
+    options.elastic->min_threads = 1;
+    options.elastic->max_threads = 2;
+    scheduler::Scheduler sched{options};
+    EXPECT_EQ(sched.getWorkerCounts().live, 1u);
+
+    std::atomic<int> runs{0};
+    std::promise<void> done;
+    for (int i = 0; i < 20; ++i) {
+        sched.schedule([&] {
+            if (runs.fetch_add(1) == 19) done.set_value();
+        }, 0);
+    }
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    EXPECT_LE(sched.getWorkerCounts().live, 2u);
+
+    // lanes need a fixed pool
+    options.lanes = {{0, 0}};
+    EXPECT_THROW(scheduler::Scheduler{options}, std::invalid_argument);
+}
+
+TEST(Scheduler, BlockingTasksDoNotStarveCpuWork)
+{
+    scheduler::Scheduler sched{1};
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::promise<void> blocking;
+    sched.schedule([&, gate] {
+        scheduler::BlockingScope io;
+        blocking.set_value();
+        gate.wait();
+    }, 0);
+    blocking.get_future().wait();
+
+    std::promise<void> cpu;
+    sched.schedule([&] { cpu.set_value(); }, 0);
+    EXPECT_EQ(std::future_status::ready, cpu.get_future().wait_for(1s));
+    release.set_value();
+    EXPECT_EQ(sched.getWorkerCounts().compensating, 1u);
+}
+
+TEST(Scheduler, LanesRejectCompensatingThreads)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 2;
+    options.lanes = {{0, 0}};
+    options.max_compensating_threads = 0;
+    EXPECT_NO_THROW(scheduler::Scheduler{options});
+    options.max_compensating_threads = 2;
+    EXPECT_THROW(scheduler::Scheduler{options}, std::invalid_argument);
+}
+
+namespace {
+// Keeps the only worker busy past the deadline of the tasks queued behind
+// it, then lets it go.
+void queueLateTasks(scheduler::Scheduler& sched, std::atomic<int>& ran,
+                    int count)
+{
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::promise<void> busy;
+    sched.schedule([&busy, gate] {
+        busy.set_value();
+        gate.wait();
+    }, 100);
+    busy.get_future().wait();
+
+    auto deadline = std::chrono::steady_clock::now() + 5ms;
+    for (int i = 0; i < count; ++i) {
+        sched.schedule([&] { ran.fetch_add(1); }, 1, deadline);
+    }
+    std::this_thread::sleep_for(20ms);
+    release.set_value();
+}
+}
+
+TEST(Scheduler, CountsMetAndMissedDeadlines)
+{
+    scheduler::Scheduler sched{1};
+    std::atomic<int> ran{0};
+    queueLateTasks(sched, ran, 3);
+    std::promise<void> done;
+    sched.schedule([&] { done.set_value(); }, 1,
+                   std::chrono::steady_clock::now() + 1s);
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    std::this_thread::sleep_for(10ms);
+
+    // without a policy late tasks still run
+    EXPECT_EQ(ran.load(), 3);
+    auto counts = sched.getDeadlineCounts();
+    EXPECT_EQ(counts.missed, 3u);
+    EXPECT_EQ(counts.met, 1u);
+    EXPECT_EQ(counts.shed, 0u);
+}
+
+TEST(Scheduler, DropsTasksThatAreAlreadyLate)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.deadlines = scheduler::DeadlinePolicy{};
+    scheduler::Scheduler sched{options};
+    std::atomic<int> ran{0};
+    queueLateTasks(sched, ran, 4);
+
+    std::promise<void> done;
+    sched.schedule([&] { done.set_value(); }, 0);
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    EXPECT_EQ(ran.load(), 0);
+    EXPECT_EQ(sched.getDeadlineCounts().shed, 4u);
+}
+
+TEST(Scheduler, DivertsOrDemotesLateTasks)
+{
+    std::atomic<int> diverted{0};
+    {
+        scheduler::SchedulerOptions options;
+        options.threads = 1;
+        options.deadlines = scheduler::DeadlinePolicy{};
+        options.deadlines->action = scheduler::DeadlineAction::Divert;
+        options.deadlines->divert = [&](scheduler::ShedTask&& task) {
+            EXPECT_EQ(task.priority, 1);
+            diverted.fetch_add(1);
+        };
+        scheduler::Scheduler sched{options};
+        std::atomic<int> ran{0};
+        queueLateTasks(sched, ran, 2);
+        std::this_thread::sleep_for(20ms);
+        EXPECT_EQ(ran.load(), 0);
+    }
+    EXPECT_EQ(diverted.load(), 2);
+
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.deadlines = scheduler::DeadlinePolicy{};
+    options.deadlines->action = scheduler::DeadlineAction::Demote;
+    scheduler::Scheduler sched{options};
+    std::atomic<int> ran{0};
+    queueLateTasks(sched, ran, 2);
+    std::this_thread::sleep_for(20ms);
+    // demoted tasks still run, just without their deadline
+    EXPECT_EQ(ran.load(), 2);
+    auto counts = sched.getDeadlineCounts();
+    EXPECT_EQ(counts.demoted, 2u);
+    EXPECT_EQ(counts.missed, 0u);
+}
+
+TEST(Scheduler, DemotedTasksCanStillBeCancelled)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.deadlines = scheduler::DeadlinePolicy{};
+    options.deadlines->action = scheduler::DeadlineAction::Demote;
+    scheduler::Scheduler sched{options};
+
+    std::promise<void> first_busy, release_first, second_busy, release_second;
+    sched.schedule([&] {
+        first_busy.set_value();
+        release_first.get_future().wait();
+    }, 100);
+    first_busy.get_future().wait();
+
+    // once the worker frees up, the late task is demoted below the second
+    // blocker and stays queued behind it
+    std::atomic<bool> ran{false};
+    auto handle = sched.schedule([&] { ran = true; }, 1,
+                                 std::chrono::steady_clock::now() - 1ms);
+    sched.schedule([&] {
+        second_busy.set_value();
+        release_second.get_future().wait();
+    }, 100);
+    release_first.set_value();
+    second_busy.get_future().wait();
+    for (int i = 0; i < 100 && sched.getDeadlineCounts().demoted == 0; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_EQ(sched.getDeadlineCounts().demoted, 1u);
+
+    EXPECT_TRUE(handle.reprioritize(5));
+    EXPECT_TRUE(handle.cancel());
+    release_second.set_value();
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(ran.load());
+}
+
+TEST(Scheduler, ReportsTimerJitter)
+{
+    scheduler::Scheduler sched{2};
+    std::atomic<int> runs{0};
+    auto handle = sched.scheduleRecurring([&] { runs.fetch_add(1); }, 1, 2ms);
+    std::this_thread::sleep_for(50ms);
+    handle.cancel();
+
+    auto jitter = sched.resetTimerJitterHistogram();
+    EXPECT_GE(jitter.count(), 5u);
+    EXPECT_GE(jitter.min(), 0);
+    EXPECT_EQ(sched.getTimerJitterHistogram().count(), 0u);
+}
+
+TEST(Scheduler, FixedDelayRunsNeverOverlap)
+{
+    scheduler::Scheduler sched{4};
+    std::atomic<int> running{0};
+    std::atomic<int> overlaps{0};
+    std::atomic<int> runs{0};
+    scheduler::RecurringOptions options;
+    options.cadence = scheduler::Cadence::FixedDelay;
+    options.slack = 2ms;
+    auto handle = sched.scheduleRecurring([&] {
+        if (running.fetch_add(1) != 0) overlaps.fetch_add(1);
+        std::this_thread::sleep_for(5ms);
+        running.fetch_sub(1);
+        runs.fetch_add(1);
+    }, 1, 1ms, options);
+    std::this_thread::sleep_for(100ms);
+    handle.cancel();
+
+    EXPECT_GE(runs.load(), 3);
+    EXPECT_EQ(overlaps.load(), 0);
+}
+
+TEST(Scheduler, RunsOnTheCheaperClocks)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 2;
+    options.clocks.enqueue = scheduler::ClockSource::Coarse;
+    options.clocks.latency = scheduler::ClockSource::Tsc;
+    options.clocks.deadline = scheduler::ClockSource::Tsc;
+    scheduler::Scheduler sched{options};
+
+    std::promise<void> done;
+    sched.schedule([&] { done.set_value(); }, 1,
+                   std::chrono::steady_clock::now() + 1s);
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(sched.getLatencyHistogram().count(), 1u);
+    EXPECT_EQ(sched.getDeadlineCounts().met, 1u);
+}
+
+TEST(Scheduler, ReportsMetrics)
+{
+    scheduler::Scheduler sched{2};
+    std::atomic<int> runs{0};
+    std::promise<void> done;
+    for (int i = 0; i < 10; ++i) {
+        sched.schedule([&] {
+            if (runs.fetch_add(1) == 9) done.set_value();
+        }, 0);
+    }
+    auto cancelled = sched.schedule([] {}, -100,
+                                    std::chrono::steady_clock::now() + 1h);
+    cancelled.cancel();
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+    std::this_thread::sleep_for(10ms);
+
+    auto metrics = sched.getMetrics();
+    EXPECT_EQ(metrics.submitted, 11u);
+    EXPECT_EQ(metrics.completed, 10u);
+    EXPECT_EQ(metrics.dispatched, 10u);
+    EXPECT_EQ(metrics.rejected, 0u);
+    EXPECT_EQ(metrics.in_flight, 0u);
+    EXPECT_EQ(metrics.queue_depth, 0u);
+    EXPECT_GT(metrics.dispatcher_wakeups, 0u);
+    EXPECT_EQ(metrics.latency.count(), 10u);
+    EXPECT_GT(metrics.uptime.count(), 0);
+    EXPECT_NE(scheduler::toPrometheusText(metrics).find(
+                  "scheduler_tasks_completed_total 10\n"),
+              std::string::npos);
+}
+
+TEST(Scheduler, ReportsParkedWorkers)
+{
+    scheduler::Scheduler sched{1};
+    // long enough for the idle worker to stop spinning and park
+    std::this_thread::sleep_for(20ms);
+    std::promise<void> done;
+    sched.schedule([&] { done.set_value(); }, 0);
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(1s));
+
+    auto metrics = sched.getMetrics();
+    EXPECT_GE(metrics.worker_wakeups, 1u);
+    EXPECT_GE(metrics.parked_time, 10ms);
+}
+
+#if SCHEDULER_TRACING
+TEST(Scheduler, WritesATraceOfEveryTask)
+{
+    std::string path = ::testing::TempDir() + "scheduler_trace.json";
+    scheduler::SchedulerOptions options;
+    options.threads = 2;
+    options.tracing = scheduler::TraceOptions{};
+    options.tracing->path = path;
+    {
+        scheduler::Scheduler sched{options};
+        std::atomic<int> runs{0};
+        std::promise<void> done;
+        for (int i = 0; i < 10; ++i) {
+            sched.schedule([&] {
+                if (runs.fetch_add(1) == 9) done.set_value();
+            }, i);
+        }
+        ASSERT_EQ(std::future_status::ready,
+                  done.get_future().wait_for(1s));
+        std::this_thread::sleep_for(10ms);
+
+        std::string live = ::testing::TempDir() + "scheduler_trace_live.json";
+        EXPECT_TRUE(sched.writeTrace(live));
+        std::remove(live.c_str());
+    }
+
+    std::ifstream file{path};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string json = contents.str();
+    size_t runs = 0;
+    for (size_t at = json.find("\"ph\":\"X\""); at != std::string::npos;
+         at = json.find("\"ph\":\"X\"", at + 1)) {
+        ++runs;
+    }
+    EXPECT_EQ(runs, 10u);
+    EXPECT_NE(json.find("\"priority\":9"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"pool\""), std::string::npos);
+    std::remove(path.c_str());
+}
+#endif
+
+TEST(Scheduler, TracesNothingUnlessAsked)
+{
+    scheduler::Scheduler sched{1};
+    EXPECT_FALSE(sched.writeTrace(::testing::TempDir() + "no_trace.json"));
+}
+
+TEST(Scheduler, SharesWorkersBetweenGroups)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.groups.resize(2);
+    scheduler::Scheduler sched{options};
+    EXPECT_EQ(sched.groupCount(), 2u);
+
+    std::promise<void> open;
+    auto gate = open.get_future().share();
+    sched.schedule([gate] { gate.wait(); }, 0);
+    std::this_thread::sleep_for(10ms);
+
+    std::mutex mutex;
+    std::vector<size_t> order;
+    std::promise<void> done;
+    std::atomic<int> left{60};
+    auto task = [&](size_t group) {
+        return [&, group] {
+            std::this_thread::sleep_for(100us);
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                order.push_back(group);
+            }
+            if (left.fetch_sub(1) == 1) done.set_value();
+        };
+    };
+    // the noisy tenant queues first and at higher priorities
+    for (int i = 0; i < 50; ++i) sched.schedule(task(0), 100);
+    for (int i = 0; i < 10; ++i) {
+        sched.schedule(task(1), 0, std::nullopt, scheduler::kAnyNode, 1);
+    }
+    open.set_value();
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(5s));
+
+    auto last = std::find(order.rbegin(), order.rend(), 1u);
+    size_t finished_at = size_t(order.rend() - last);
+    EXPECT_LE(finished_at, 30u);
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(sched.getGroupStats(0).completed, 51u);
+    EXPECT_EQ(sched.getGroupStats(1).completed, 10u);
+    EXPECT_EQ(sched.getGroupStats(1).latency.count(), 10u);
+    EXPECT_EQ(sched.getGroupStats(0).latency.count(), 51u);
+    EXPECT_GT(sched.getGroupStats(1).busy_time.count(), 0);
+}
+
+TEST(Scheduler, HoldsBackGroupsOutOfQuota)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.groups.resize(1);
+    options.groups[0].quota = scheduler::CpuQuota{1ms, 10ms};
+    scheduler::Scheduler sched{options};
+
+    std::promise<void> done;
+    std::atomic<int> left{3};
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        sched.schedule([&] {
+            std::this_thread::sleep_for(2ms);
+            if (left.fetch_sub(1) == 1) done.set_value();
+        }, 0);
+    }
+    ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(2s));
+    // every run uses up two periods' worth of budget
+    EXPECT_GE(std::chrono::steady_clock::now() - started, 20ms);
+    EXPECT_GE(sched.getGroupStats(0).throttled, 2u);
+}
+
+TEST(Scheduler, RejectsUnknownGroups)
+{
+    scheduler::Scheduler sched{1};
+    EXPECT_EQ(sched.groupCount(), 1u);
+    EXPECT_THROW(sched.schedule([] {}, 0, std::nullopt,
+                                scheduler::kAnyNode, 1),
+                 std::out_of_range);
+    std::vector<scheduler::BatchTask> batch(1);
+    batch[0].task = [] {};
+    batch[0].group = 3;
+    EXPECT_THROW(sched.scheduleBatch(batch), std::out_of_range);
+    EXPECT_THROW(sched.getGroupStats(1), std::out_of_range);
+
+    scheduler::SchedulerOptions options;
+    options.threads = 2;
+    options.groups.resize(2);
+    options.lanes = {{0, 1}};
+    EXPECT_THROW(scheduler::Scheduler{options}, std::invalid_argument);
+}
+
+namespace {
+// Keeps the only worker busy until open() so that tasks stay queued
+struct Gate {
+    std::promise<void> started;
+    std::promise<void> opened;
+    std::shared_future<void> wait = opened.get_future().share();
+
+    void block(scheduler::Scheduler& sched) {
+        sched.schedule([&started = started, wait = wait] {
+            started.set_value();
+            wait.wait();
+        }, 0);
+        started.get_future().wait();
+    }
+    void open() { opened.set_value(); }
+};
+}
+
+TEST(Scheduler, RefusesTasksBeyondTheLimits)
+{
+    std::mutex mutex;
+    std::vector<bool> pressure;
+    std::vector<int> rejected;
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.limits = scheduler::QueueLimits{};
+    options.limits->max_tasks = 3;
+    options.limits->on_reject = [&](scheduler::RejectedTask&& task) {
+        std::lock_guard<std::mutex> lock{mutex};
+        rejected.push_back(task.priority);
+    };
+    options.limits->on_pressure = [&](bool on) {
+        std::lock_guard<std::mutex> lock{mutex};
+        pressure.push_back(on);
+    };
+    scheduler::Scheduler sched{options};
+    Gate gate;
+    gate.block(sched);
+
+    std::atomic<int> runs{0};
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(sched.trySchedule([&] { ++runs; }, 1));
+    }
+    EXPECT_TRUE(sched.underPressure());
+    scheduler::InplaceTask extra{[&] { ++runs; }};
+    EXPECT_FALSE(sched.trySchedule(std::move(extra), 1));
+    EXPECT_TRUE(static_cast<bool>(extra));
+    EXPECT_FALSE(sched.schedule(std::move(extra), 7));
+    EXPECT_GT(sched.getMetrics().queue_bytes, 0u);
+
+    gate.open();
+    for (int i = 0; i < 100 && runs < 3; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(runs, 3);
+    EXPECT_FALSE(sched.underPressure());
+    auto metrics = sched.getMetrics();
+    EXPECT_EQ(metrics.refused, 2u);
+    EXPECT_EQ(metrics.queue_bytes, 0u);
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_EQ(rejected, std::vector<int>{7});
+    EXPECT_EQ(pressure, (std::vector<bool>{true, false}));
+}
+
+TEST(Scheduler, WaitsForRoomUpToATimeout)
+{
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.limits = scheduler::QueueLimits{};
+    options.limits->max_tasks = 1;
+    scheduler::Scheduler sched{options};
+    Gate gate;
+    gate.block(sched);
+
+    ASSERT_TRUE(sched.trySchedule([] {}, 0));
+    auto started = std::chrono::steady_clock::now();
+    EXPECT_FALSE(sched.tryScheduleFor(5ms, [] {}, 0));
+    EXPECT_GE(std::chrono::steady_clock::now() - started, 5ms);
+
+    std::thread opener([&] {
+        std::this_thread::sleep_for(20ms);
+        gate.open();
+    });
+    std::promise<void> ran;
+    EXPECT_TRUE(sched.tryScheduleFor(2s, [&] { ran.set_value(); }, 0));
+    EXPECT_EQ(std::future_status::ready, ran.get_future().wait_for(1s));
+    opener.join();
+}
+
+TEST(Scheduler, RefusesTheTailOfABatch)
+{
+    std::atomic<int> rejected{0};
+    scheduler::SchedulerOptions options;
+    options.threads = 1;
+    options.limits = scheduler::QueueLimits{};
+    options.limits->max_tasks = 2;
+    options.limits->on_reject = [&](scheduler::RejectedTask&&) {
+        ++rejected;
+    };
+    scheduler::Scheduler sched{options};
+    Gate gate;
+    gate.block(sched);
+
+    std::atomic<int> runs{0};
+    std::vector<scheduler::BatchTask> batch(5);
+    for (auto& entry : batch) entry.task = [&] { ++runs; };
+    sched.scheduleBatch(batch);
+    EXPECT_EQ(rejected, 3);
+    EXPECT_EQ(sched.getMetrics().queue_depth, 2u);
+    gate.open();
+}
+
+TEST(Scheduler, BatchAcrossLanesFillsHigherLanesFirst)
+{
+    std::mutex mutex;
+    std::vector<int> rejected;
+    scheduler::SchedulerOptions options;
+    options.threads = 2;
+    options.lanes = {{10, 1, false}, {0, 0}};
+    options.limits = scheduler::QueueLimits{};
+    options.limits->max_tasks = 4;
+    options.limits->on_reject = [&](scheduler::RejectedTask&& task) {
+        std::lock_guard<std::mutex> lock{mutex};
+        rejected.push_back(task.priority);
+    };
+    scheduler::Scheduler sched{options};
+    // one gate for the shared worker, then one for the reserved one
+    Gate shared;
+    shared.block(sched);
+    std::promise<void> reserved_started;
+    sched.schedule([&, wait = shared.wait] {
+        reserved_started.set_value();
+        wait.wait();
+    }, 10);
+    reserved_started.get_future().wait();
+
+    std::vector<scheduler::BatchTask> batch(6);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].task = [] {};
+        batch[i].priority = i % 2 == 0 ? 0 : 10;
+    }
+    sched.scheduleBatch(batch);
+    shared.open();
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_EQ(rejected, (std::vector<int>{0, 0}));
+}
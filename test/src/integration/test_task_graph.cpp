@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "scheduler/scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using scheduler::TaskGraph;
+
+TEST(TaskGraph, DiamondRunsInDependencyOrder)
+{
+    scheduler::Scheduler sched{4};
+    std::mutex mtx;
+    std::vector<char> order;
+    auto log = [&](char name) {
+        return [&, name] {
+            std::lock_guard<std::mutex> lock{mtx};
+            order.push_back(name);
+        };
+    };
+
+    TaskGraph graph;
+    auto a = graph.add(log('a'));
+    auto b = graph.add(log('b'));
+    auto c = graph.add(log('c'));
+    auto d = graph.add(log('d'));
+    graph.precede(a, {b, c});
+    graph.succeed(d, {b, c});
+
+    auto done = sched.submit(std::move(graph));
+    ASSERT_EQ(std::future_status::ready, done.wait_for(1s));
+    done.get();
+
+    ASSERT_EQ(order.size(), 4u);
+    EXPECT_EQ(order.front(), 'a');
+    EXPECT_EQ(order.back(), 'd');
+}
+
+TEST(TaskGraph, ChainStaysOnOneWorker)
+{
+    scheduler::Scheduler sched{4};
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+
+    TaskGraph graph;
+    TaskGraph::Node prev = graph.add([] {});
+    for (int i = 0; i < 50; ++i) {
+        auto next = graph.add([&] {
+            std::lock_guard<std::mutex> lock{mtx};
+            threads.insert(std::this_thread::get_id());
+        });
+        graph.precede(prev, next);
+        prev = next;
+    }
+    auto done = sched.submit(std::move(graph));
+    ASSERT_EQ(std::future_status::ready, done.wait_for(1s));
+    EXPECT_EQ(threads.size(), 1u);
+}
+
+TEST(TaskGraph, WideFanOutAndFanIn)
+{
+    scheduler::Scheduler sched{4};
+    std::atomic<int> leaves{0};
+    std::atomic<int> seen_at_join{-1};
+
+    TaskGraph graph;
+    auto root = graph.add([] {});
+    auto join = graph.add([&] { seen_at_join = leaves.load(); });
+    for (int i = 0; i < 200; ++i) {
+        auto leaf = graph.add([&] { leaves.fetch_add(1); }, i % 7);
+        graph.precede(root, leaf);
+        graph.precede(leaf, join);
+    }
+    auto done = sched.submit(std::move(graph));
+    ASSERT_EQ(std::future_status::ready, done.wait_for(1s));
+    EXPECT_EQ(leaves.load(), 200);
+    EXPECT_EQ(seen_at_join.load(), 200);
+}
+
+TEST(TaskGraph, ExceptionSkipsTheRestAndReachesTheFuture)
+{
+    scheduler::Scheduler sched{2};
+    std::atomic<bool> ran_after{false};
+
+    TaskGraph graph;
+    auto boom = graph.add([] { throw std::runtime_error("boom"); });
+    auto after = graph.add([&] { ran_after = true; });
+    graph.precede(boom, after);
+
+    auto done = sched.submit(std::move(graph));
+    ASSERT_EQ(std::future_status::ready, done.wait_for(1s));
+    EXPECT_THROW(done.get(), std::runtime_error);
+    EXPECT_FALSE(ran_after.load());
+}
+
+TEST(TaskGraph, RejectsCyclesAndUnknownNodes)
+{
+    scheduler::Scheduler sched{1};
+    TaskGraph graph;
+    auto a = graph.add([] {});
+    auto b = graph.add([] {});
+    graph.precede(a, b);
+    graph.precede(b, a);
+    EXPECT_THROW(sched.submit(std::move(graph)), std::invalid_argument);
+
+    TaskGraph other;
+    other.add([] {});
+    EXPECT_THROW(other.precede(0, 5), std::out_of_range);
+}
+
+TEST(TaskGraph, EmptyGraphIsDoneRightAway)
+{
+    scheduler::Scheduler sched{1};
+    auto done = sched.submit(TaskGraph{});
+    EXPECT_EQ(std::future_status::ready, done.wait_for(0s));
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "detail/bounded_queue_impl.h"
+#include "detail/task_queue_impl.h"
+#include <memory>
+#include <vector>
+
+using namespace scheduler::detail;
+
+namespace {
+std::shared_ptr<QueueBudget> budgetOf(size_t tasks)
+{
+    scheduler::QueueLimits limits;
+    limits.max_tasks = tasks;
+    return std::make_shared<QueueBudget>(limits);
+}
+
+// a one-off task without a deadline
+Task oneOff(scheduler::InplaceTask task, int priority, uint64_t seq)
+{
+    return Task(std::move(task), priority, seq, milliseconds{0},
+                time_point{}, std::nullopt);
+}
+}
+
+TEST(BoundedQueue, RefusesWhatDoesNotFit)
+{
+    auto budget = budgetOf(2);
+    BoundedQueue queue{std::make_shared<TaskQueue>(), budget};
+    int ran = 0;
+    EXPECT_TRUE(queue.tryPush(oneOff([] {}, 0, 0)));
+    EXPECT_TRUE(queue.tryPush(oneOff([] {}, 0, 1)));
+    Task refused = oneOff([&ran] { ++ran; }, 0, 2);
+    EXPECT_FALSE(queue.tryPush(std::move(refused)));
+    // a refused task is left as it was
+    refused.task();
+    EXPECT_EQ(ran, 1);
+    EXPECT_EQ(queue.size(), 2u);
+
+    ASSERT_TRUE(queue.pop());
+    EXPECT_EQ(budget->tasks(), 1u);
+    EXPECT_TRUE(queue.tryPush(std::move(refused)));
+}
+
+TEST(BoundedQueue, QueuesTheBatchPrefixThatFits)
+{
+    auto budget = budgetOf(3);
+    BoundedQueue queue{std::make_shared<TaskQueue>(), budget};
+    std::vector<Task> batch;
+    for (uint64_t seq = 0; seq < 5; ++seq) {
+        batch.push_back(oneOff([] {}, 0, seq));
+    }
+    EXPECT_EQ(queue.tryPushBatch(batch), 3u);
+    EXPECT_EQ(queue.size(), 3u);
+    EXPECT_TRUE(batch[3].task);
+    EXPECT_TRUE(batch[4].task);
+
+    // pushes from the scheduler itself are counted but never refused
+    queue.pushBatch(std::span{batch}.subspan(3));
+    EXPECT_EQ(budget->tasks(), 5u);
+}
+
+TEST(BoundedQueue, ErasedTasksGiveTheirRoomBack)
+{
+    auto budget = budgetOf(1);
+    BoundedQueue queue{std::make_shared<TaskQueue>(), budget};
+    auto state = std::make_shared<TaskState>();
+    ASSERT_TRUE(queue.tryPush(Task([] {}, 0, 0, milliseconds{0},
+                                   std::chrono::steady_clock::now(),
+                                   std::nullopt, state)));
+    EXPECT_FALSE(queue.tryPush(oneOff([] {}, 0, 1)));
+    EXPECT_TRUE(queue.erase(*state));
+    EXPECT_EQ(budget->tasks(), 0u);
+    EXPECT_EQ(budget->bytes(), 0u);
+}
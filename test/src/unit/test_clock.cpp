@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "detail/coarse_clock_impl.h"
+#include "detail/tsc_clock_impl.h"
+#include <chrono>
+#include <thread>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+TEST(TscClock, TracksSteadyClock)
+{
+    if (!TscClock::available()) GTEST_SKIP() << "no invariant TSC";
+    TscClock clock;
+    for (int i = 0; i < 5; ++i) {
+        auto before = std::chrono::steady_clock::now();
+        auto tsc = clock.now();
+        auto after = std::chrono::steady_clock::now();
+        EXPECT_GT(tsc, before - 200us);
+        EXPECT_LT(tsc, after + 200us);
+        std::this_thread::sleep_for(5ms);
+    }
+}
+
+TEST(TscClock, KeepsTrackingAcrossReanchors)
+{
+    if (!TscClock::available()) GTEST_SKIP() << "no invariant TSC";
+    TscClock clock;
+    auto first = clock.now();
+    std::this_thread::sleep_for(1100ms);
+    auto steady = std::chrono::steady_clock::now();
+    auto tsc = clock.now();
+    EXPECT_GT(tsc, first + 1s);
+    EXPECT_LT(tsc > steady ? tsc - steady : steady - tsc, 500us);
+}
+
+TEST(CoarseClock, LagsSteadyClockByAboutItsResolution)
+{
+    CoarseClock clock{1ms};
+    auto start = clock.now();
+    std::this_thread::sleep_for(20ms);
+    auto later = clock.now();
+    auto steady = std::chrono::steady_clock::now();
+
+    EXPECT_GT(later, start + 10ms);
+    EXPECT_LE(later, steady);
+    // generous: the ticker may be late on a loaded machine
+    EXPECT_LT(steady - later, 50ms);
+}
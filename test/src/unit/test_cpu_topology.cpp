@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "detail/cpu_topology.h"
+#include <set>
+
+using namespace scheduler;
+using namespace scheduler::detail;
+
+namespace {
+std::vector<NumaNode> twoSockets()
+{
+    return {{0, {0, 1, 2, 3}}, {1, {4, 5, 6, 7}}};
+}
+}
+
+TEST(CpuTopology, ParsesCpuLists)
+{
+    EXPECT_EQ(parseCpuList("0-3,8,10-11\n"),
+              (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parseCpuList("5"), (std::vector<int>{5}));
+    EXPECT_EQ(parseCpuList("3,1-2,2"), (std::vector<int>{1, 2, 3}));
+    EXPECT_TRUE(parseCpuList("").empty());
+    EXPECT_TRUE(parseCpuList("4-2").empty());
+    EXPECT_TRUE(parseCpuList("a-b").empty());
+}
+
+TEST(CpuTopology, DetectsAtLeastOneNode)
+{
+    auto nodes = detectNumaNodes();
+    ASSERT_FALSE(nodes.empty());
+    for (auto const& node : nodes) EXPECT_FALSE(node.cpus.empty());
+}
+
+TEST(CpuTopology, DefaultPlanLeavesWorkersUnbound)
+{
+    auto plan = planWorkers(4, WorkerPlacement{}, twoSockets());
+    ASSERT_EQ(plan.nodes.size(), 1u);
+    EXPECT_EQ(plan.nodes[0].id, kAnyNode);
+    ASSERT_EQ(plan.workers.size(), 4u);
+    for (auto const& worker : plan.workers) {
+        EXPECT_EQ(worker.node, 0u);
+        EXPECT_TRUE(worker.cpus.empty());
+    }
+}
+
+TEST(CpuTopology, PinnedPlanHandsOutCpusRoundRobin)
+{
+    WorkerPlacement placement;
+    placement.cpus = {6, 2, 3};
+    placement.pin = true;
+    auto plan = planWorkers(4, placement, twoSockets());
+    ASSERT_EQ(plan.nodes.size(), 1u);
+    EXPECT_EQ(plan.nodes[0].cpus, (std::vector<int>{2, 3, 6}));
+    std::vector<int> pinned;
+    for (auto const& worker : plan.workers) {
+        ASSERT_EQ(worker.cpus.size(), 1u);
+        pinned.push_back(worker.cpus[0]);
+    }
+    EXPECT_EQ(pinned, (std::vector<int>{2, 3, 6, 2}));
+}
+
+TEST(CpuTopology, NumaPlanSpreadsWorkersOverNodes)
+{
+    WorkerPlacement placement;
+    placement.numa = true;
+    auto plan = planWorkers(5, placement, twoSockets());
+    ASSERT_EQ(plan.nodes.size(), 2u);
+    EXPECT_EQ(plan.nodeIndex(1, 99), 1u);
+    EXPECT_EQ(plan.nodeIndex(7, 99), 99u);
+
+    size_t per_node[2] = {0, 0};
+    for (auto const& worker : plan.workers) {
+        ++per_node[worker.node];
+        // unpinned workers may run anywhere on their node
+        EXPECT_EQ(worker.cpus, plan.nodes[worker.node].cpus);
+    }
+    EXPECT_EQ(per_node[0], 3u);
+    EXPECT_EQ(per_node[1], 2u);
+}
+
+TEST(CpuTopology, NumaPlanDropsNodesOutsideTheCpuSet)
+{
+    WorkerPlacement placement;
+    placement.numa = true;
+    placement.pin = true;
+    placement.cpus = {4, 5};
+    auto plan = planWorkers(3, placement, twoSockets());
+    ASSERT_EQ(plan.nodes.size(), 1u);
+    EXPECT_EQ(plan.nodes[0].id, 1);
+    std::set<int> used;
+    for (auto const& worker : plan.workers) used.insert(worker.cpus.at(0));
+    EXPECT_EQ(used, (std::set<int>{4, 5}));
+}
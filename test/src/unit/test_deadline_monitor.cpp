@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "detail/deadline_monitor.h"
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+TEST(DeadlineMonitor, CountsMetAndMissedDeadlines)
+{
+    DeadlineMonitor monitor{std::nullopt};
+    auto t0 = std::chrono::steady_clock::now();
+    monitor.finished(0, 1ms, t0 + 1ms, t0 + 2ms);
+    monitor.finished(0, 3ms, t0 + 3ms, t0 + 2ms);
+    monitor.finished(0, 2ms, t0 + 2ms, t0 + 2ms);
+
+    auto counts = monitor.counts();
+    EXPECT_EQ(counts.met, 2u);
+    EXPECT_EQ(counts.missed, 1u);
+    EXPECT_EQ(counts.shed, 0u);
+}
+
+TEST(DeadlineMonitor, EverythingIsReachableWithoutAPolicy)
+{
+    DeadlineMonitor monitor{std::nullopt};
+    auto now = std::chrono::steady_clock::now();
+    EXPECT_FALSE(monitor.shedding());
+    EXPECT_TRUE(monitor.reachable(0, now - 1s, now));
+}
+
+TEST(DeadlineMonitor, LearnsRunTimesPerPriority)
+{
+    scheduler::DeadlinePolicy policy;
+    policy.initial_estimate = 100us;
+    DeadlineMonitor monitor{policy};
+    auto t0 = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(monitor.estimate(1), 100us);
+    monitor.finished(1, 8ms, t0 + 8ms, t0 + 1s);
+    EXPECT_EQ(monitor.estimate(1), 8ms);
+    // a sample moves the estimate by an eighth of the difference
+    monitor.finished(1, 16ms, t0 + 16ms, t0 + 1s);
+    EXPECT_EQ(monitor.estimate(1), 9ms);
+    // other classes keep the initial estimate
+    EXPECT_EQ(monitor.estimate(2), 100us);
+
+    EXPECT_TRUE(monitor.reachable(1, t0 + 9ms, t0));
+    EXPECT_FALSE(monitor.reachable(1, t0 + 8ms, t0));
+    EXPECT_TRUE(monitor.reachable(2, t0 + 8ms, t0));
+}
+
+TEST(DeadlineMonitor, PrioritiesOutsideTheTableShareItsEnds)
+{
+    scheduler::DeadlinePolicy policy;
+    DeadlineMonitor monitor{policy};
+    auto t0 = std::chrono::steady_clock::now();
+
+    monitor.finished(std::numeric_limits<int>::min(), 4ms, t0 + 4ms, t0 + 1s);
+    EXPECT_EQ(monitor.estimate(DeadlineMonitor::kMinClass - 1), 4ms);
+    monitor.finished(1000, 2ms, t0 + 2ms, t0 + 1s);
+    EXPECT_EQ(monitor.estimate(DeadlineMonitor::kMaxClass), 2ms);
+    EXPECT_EQ(monitor.estimate(0), 0ms);
+}
+
+TEST(DeadlineMonitor, WorkersSampleConcurrently)
+{
+    scheduler::DeadlinePolicy policy;
+    DeadlineMonitor monitor{policy};
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i) {
+        workers.emplace_back([&] {
+            for (int j = 0; j < 1000; ++j) {
+                monitor.finished(3, 5ms, t0 + 5ms, t0 + 4ms);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    EXPECT_EQ(monitor.estimate(3), 5ms);
+    EXPECT_EQ(monitor.counts().missed, 4000u);
+}
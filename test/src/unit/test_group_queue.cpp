@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "detail/group_queue_impl.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+namespace {
+class ManualClock : public IClock {
+public:
+    time_point now() const override { return now_; }
+    void advance(std::chrono::nanoseconds by) { now_ += by; }
+
+private:
+    time_point now_ = std::chrono::steady_clock::now();
+};
+
+Task inGroup(uint32_t group, int priority, uint64_t seq)
+{
+    Task task([] {}, priority, seq, milliseconds{0}, time_point{},
+              std::nullopt);
+    task.group = group;
+    return task;
+}
+
+scheduler::TaskGroup weighted(uint32_t weight)
+{
+    scheduler::TaskGroup group;
+    group.weight = weight;
+    return group;
+}
+}
+
+TEST(GroupQueue, SharesByWeight)
+{
+    auto clock = std::make_shared<ManualClock>();
+    GroupQueue queue{{weighted(1), weighted(3)}, clock};
+    uint64_t seq = 0;
+    // group 0 floods higher priorities, which does not buy it more turns
+    for (int i = 0; i < 100; ++i) queue.push(inGroup(0, 100, seq++));
+    for (int i = 0; i < 100; ++i) queue.push(inGroup(1, 0, seq++));
+    EXPECT_EQ(queue.size(), 200u);
+
+    size_t popped[2] = {0, 0};
+    for (int i = 0; i < 80; ++i) {
+        auto task = queue.pop();
+        ASSERT_TRUE(task);
+        ++popped[task->group];
+        queue.finished(task->group, 10us);
+    }
+    EXPECT_NEAR(double(popped[1]) / double(popped[0]), 3.0, 0.5);
+}
+
+TEST(GroupQueue, KeepsQueueOrderWithinAGroup)
+{
+    auto clock = std::make_shared<ManualClock>();
+    GroupQueue queue{{weighted(1)}, clock};
+    auto soon = clock->now() + 1ms;
+    queue.push(inGroup(0, 1, 0));
+    queue.push(inGroup(0, 5, 1));
+    Task urgent([] {}, 0, 2, milliseconds{0}, clock->now(), soon);
+    queue.push(std::move(urgent));
+
+    EXPECT_EQ(queue.pop()->sequence_number, 2u);
+    EXPECT_EQ(queue.pop()->sequence_number, 1u);
+    EXPECT_EQ(queue.pop()->sequence_number, 0u);
+    EXPECT_FALSE(queue.pop());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(GroupQueue, IdleGroupGetsNoCredit)
+{
+    auto clock = std::make_shared<ManualClock>();
+    GroupQueue queue{{weighted(1), weighted(1)}, clock};
+    uint64_t seq = 0;
+    for (int i = 0; i < 50; ++i) {
+        queue.push(inGroup(0, 0, seq++));
+        auto task = queue.pop();
+        queue.finished(task->group, 10us);
+    }
+    // group 1 was idle all along, then both are busy
+    for (int i = 0; i < 10; ++i) {
+        queue.push(inGroup(0, 0, seq++));
+        queue.push(inGroup(1, 0, seq++));
+    }
+    size_t popped[2] = {0, 0};
+    for (int i = 0; i < 10; ++i) {
+        auto task = queue.pop();
+        ++popped[task->group];
+        queue.finished(task->group, 10us);
+    }
+    EXPECT_EQ(popped[0], 5u);
+    EXPECT_EQ(popped[1], 5u);
+}
+
+TEST(GroupQueue, ThrottlesAGroupOutOfQuota)
+{
+    auto clock = std::make_shared<ManualClock>();
+    auto limited = weighted(1);
+    limited.quota = scheduler::CpuQuota{1ms, 10ms};
+    GroupQueue queue{{limited, weighted(1)}, clock};
+    for (uint64_t seq = 0; seq < 4; ++seq) queue.push(inGroup(0, 0, seq));
+
+    auto task = queue.pop();
+    queue.finished(task->group, 2500us);
+    auto stats = queue.stats(0);
+    EXPECT_EQ(stats.throttled, 1u);
+    EXPECT_EQ(stats.completed, 1u);
+    EXPECT_EQ(stats.busy_time, 2500us);
+    EXPECT_EQ(stats.queued, 3u);
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+    EXPECT_EQ(queue.size(), 3u);
+    // 1.5ms of overshoot take two more periods to pay back
+    ASSERT_TRUE(queue.nextRefill());
+    EXPECT_EQ(*queue.nextRefill(), clock->now() + 20ms);
+
+    // other groups are not held back
+    queue.push(inGroup(1, 0, 10));
+    EXPECT_EQ(queue.pop()->group, 1u);
+
+    clock->advance(10ms);
+    EXPECT_FALSE(queue.pop());
+    clock->advance(10ms);
+    EXPECT_FALSE(queue.empty());
+    EXPECT_TRUE(queue.pop());
+
+    queue.finished(0, 5ms);
+    EXPECT_FALSE(queue.pop());
+    queue.liftQuotas();
+    EXPECT_TRUE(queue.pop());
+}
+
+TEST(GroupQueue, HandlesFindTasksInAnyGroup)
+{
+    auto clock = std::make_shared<ManualClock>();
+    GroupQueue queue{{weighted(1), weighted(1)}, clock};
+    auto state = std::make_shared<TaskState>();
+    Task task([] {}, 0, 0, milliseconds{0}, clock->now(), std::nullopt,
+              state);
+    task.group = 1;
+    queue.push(std::move(task));
+    queue.push(inGroup(1, 5, 1));
+
+    EXPECT_TRUE(queue.reprioritize(*state, 10));
+    EXPECT_EQ(queue.peek()->get().sequence_number, 0u);
+    auto removed = queue.erase(*state);
+    ASSERT_TRUE(removed);
+    EXPECT_EQ(removed->group, 1u);
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_FALSE(queue.erase(*state));
+}
+
+TEST(GroupQueue, FinishedFromManyWorkersIsAllCounted)
+{
+    auto clock = std::make_shared<ManualClock>();
+    GroupQueue queue{{weighted(1), weighted(1)}, clock};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < 1000; ++i) {
+                queue.finished(uint32_t(t % 2), 10us);
+            }
+        });
+    }
+    // the dispatcher keeps popping meanwhile
+    for (uint64_t seq = 0; seq < 100; ++seq) {
+        queue.push(inGroup(uint32_t(seq % 2), 0, seq));
+        EXPECT_TRUE(queue.pop());
+    }
+    for (auto& worker : workers) worker.join();
+
+    for (uint32_t group = 0; group < 2; ++group) {
+        auto stats = queue.stats(group);
+        EXPECT_EQ(stats.completed, 2000u);
+        EXPECT_EQ(stats.busy_time, 20ms);
+    }
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "scheduler/inplace_task.h"
+#include <array>
+#include <memory>
+#include <thread>
+
+using scheduler::BasicInplaceTask;
+using scheduler::InplaceTask;
+
+namespace {
+struct Tracked {
+    int* destroyed;
+    explicit Tracked(int* d) : destroyed{d} {}
+    Tracked(Tracked&& other) noexcept : destroyed{other.destroyed}
+    {
+        other.destroyed = nullptr;
+    }
+    ~Tracked()
+    {
+        if (destroyed) ++*destroyed;
+    }
+};
+}
+
+TEST(InplaceTask, SmallCallableIsStoredInline)
+{
+    int calls = 0;
+    InplaceTask task{[&calls] { ++calls; }};
+    EXPECT_TRUE(static_cast<bool>(task));
+    EXPECT_TRUE(task.isInline());
+    EXPECT_EQ(task.pooledSize(), 0u);
+    task();
+    task();
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(InplaceTask, AcceptsMoveOnlyCaptures)
+{
+    auto value = std::make_unique<int>(41);
+    int seen = 0;
+    InplaceTask task{[v = std::move(value), &seen] { seen = *v + 1; }};
+    InplaceTask moved{std::move(task)};
+    EXPECT_FALSE(static_cast<bool>(task));
+    moved();
+    EXPECT_EQ(seen, 42);
+}
+
+TEST(InplaceTask, LargeCallableUsesPooledStorage)
+{
+    std::array<char, 200> payload{};
+    payload[199] = 7;
+    int seen = 0;
+    InplaceTask task{[payload, &seen] { seen = payload[199]; }};
+    EXPECT_FALSE(task.isInline());
+    EXPECT_GE(task.pooledSize(), sizeof(payload));
+
+    InplaceTask moved = std::move(task);
+    EXPECT_EQ(task.pooledSize(), 0u);
+    moved();
+    EXPECT_EQ(seen, 7);
+}
+
+TEST(InplaceTask, DestroysCallableExactlyOnce)
+{
+    int destroyed = 0;
+    {
+        InplaceTask task{[t = Tracked{&destroyed}] {}};
+        InplaceTask other{std::move(task)};
+        InplaceTask third;
+        third = std::move(other);
+        EXPECT_EQ(destroyed, 0);
+    }
+    EXPECT_EQ(destroyed, 1);
+
+    destroyed = 0;
+    {
+        std::array<char, 300> big{};
+        InplaceTask task{[t = Tracked{&destroyed}, big] { (void)big; }};
+        InplaceTask other{std::move(task)};
+    }
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(InplaceTask, ResetAndEmptyInvocation)
+{
+    InplaceTask task{[] {}};
+    task.reset();
+    EXPECT_FALSE(static_cast<bool>(task));
+    EXPECT_THROW(task(), std::bad_function_call);
+}
+
+TEST(InplaceTask, CapacityIsConfigurable)
+{
+    std::array<char, 100> payload{};
+    BasicInplaceTask<128> wide{[payload] { (void)payload; }};
+    BasicInplaceTask<64> narrow{[payload] { (void)payload; }};
+    EXPECT_TRUE(wide.isInline());
+    EXPECT_FALSE(narrow.isInline());
+}
+
+TEST(TaskStoragePool, RecyclesBlocksOnTheSameThread)
+{
+    void* first = scheduler::detail::allocateTaskStorage(100);
+    scheduler::detail::deallocateTaskStorage(first, 100);
+    void* second = scheduler::detail::allocateTaskStorage(120);
+    EXPECT_EQ(first, second);
+    scheduler::detail::deallocateTaskStorage(second, 120);
+}
+
+TEST(TaskStoragePool, BlocksMayBeFreedOnAnotherThread)
+{
+    std::vector<void*> blocks;
+    for (int i = 0; i < 500; ++i) {
+        blocks.push_back(scheduler::detail::allocateTaskStorage(256));
+    }
+    std::thread other([&] {
+        for (void* b : blocks) scheduler::detail::deallocateTaskStorage(b, 256);
+    });
+    other.join();
+    void* again = scheduler::detail::allocateTaskStorage(256);
+    EXPECT_NE(again, nullptr);
+    scheduler::detail::deallocateTaskStorage(again, 256);
+}
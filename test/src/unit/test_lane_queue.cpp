@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "detail/lane_queue_impl.h"
+#include "detail/task_queue_impl.h"
+#include <memory>
+#include <vector>
+
+using namespace scheduler::detail;
+
+namespace {
+std::shared_ptr<LaneQueue> makeLanes()
+{
+    // lane 0: 10 and up, lane 1: 0..9, lane 2: below 0
+    std::vector<std::shared_ptr<ITaskQueue>> lanes;
+    for (int i = 0; i < 3; ++i) lanes.push_back(std::make_shared<TaskQueue>());
+    return std::make_shared<LaneQueue>(std::vector<int>{10, 0, -100},
+                                       std::move(lanes));
+}
+
+// a one-off task without a deadline
+Task oneOff(scheduler::InplaceTask task, int priority, uint64_t seq)
+{
+    return Task(std::move(task), priority, seq, milliseconds{0},
+                time_point{}, std::nullopt);
+}
+}
+
+TEST(LaneQueue, RoutesByPriority)
+{
+    auto queue = makeLanes();
+    EXPECT_EQ(queue->laneOf(50), 0u);
+    EXPECT_EQ(queue->laneOf(10), 0u);
+    EXPECT_EQ(queue->laneOf(9), 1u);
+    EXPECT_EQ(queue->laneOf(0), 1u);
+    EXPECT_EQ(queue->laneOf(-1), 2u);
+    // below the lowest floor still lands in the lowest lane
+    EXPECT_EQ(queue->laneOf(-1000), 2u);
+
+    queue->push(oneOff([] {}, 5, 0));
+    std::vector<Task> batch;
+    batch.push_back(oneOff([] {}, 20, 1));
+    batch.push_back(oneOff([] {}, -5, 2));
+    batch.push_back(oneOff([] {}, 15, 3));
+    queue->pushBatch(batch);
+
+    EXPECT_EQ(queue->lane(0)->size(), 2u);
+    EXPECT_EQ(queue->lane(1)->size(), 1u);
+    EXPECT_EQ(queue->lane(2)->size(), 1u);
+    EXPECT_EQ(queue->size(), 4u);
+}
+
+TEST(LaneQueue, PopsHigherLanesFirst)
+{
+    auto queue = makeLanes();
+    auto soon = std::chrono::steady_clock::now();
+    // a deadline does not lift a task out of its lane
+    queue->push(Task([] {}, -5, 0, milliseconds{0}, soon, soon));
+    queue->push(oneOff([] {}, 5, 1));
+    queue->push(oneOff([] {}, 10, 2));
+
+    EXPECT_EQ(queue->peek()->get().sequence_number, 2u);
+    EXPECT_EQ(queue->pop()->sequence_number, 2u);
+    EXPECT_EQ(queue->pop()->sequence_number, 1u);
+    EXPECT_EQ(queue->pop()->sequence_number, 0u);
+    EXPECT_TRUE(queue->empty());
+}
+
+TEST(LaneQueue, HandleOperationsFindTheRightLane)
+{
+    auto queue = makeLanes();
+    auto low = makeTaskState();
+    auto high = makeTaskState();
+    queue->push(Task([] {}, -5, 0, milliseconds{0},
+                     std::chrono::steady_clock::now(), std::nullopt, low));
+    queue->push(Task([] {}, 20, 1, milliseconds{0},
+                     std::chrono::steady_clock::now(), std::nullopt, high));
+
+    EXPECT_TRUE(queue->reprioritize(*low, -50));
+    auto erased = queue->erase(*high);
+    ASSERT_TRUE(erased);
+    EXPECT_EQ(erased->sequence_number, 1u);
+    EXPECT_FALSE(queue->erase(*high));
+    EXPECT_EQ(queue->size(), 1u);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "detail/laned_thread_pool_impl.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+TEST(LanedThreadPool, CapsReservationsAndReportsCapacity)
+{
+    // lane 0 borrows, lane 1 does not, lane 2 has no reserved workers
+    LanedThreadPool pool{4, {{2, true}, {5, false}, {0, true}}};
+    EXPECT_EQ(pool.reservedWorkers(0), 2u);
+    // capped so that one worker stays unreserved
+    EXPECT_EQ(pool.reservedWorkers(1), 1u);
+    EXPECT_EQ(pool.reservedWorkers(2), 0u);
+
+    EXPECT_EQ(pool.laneCapacity(0), 3u);  // own two plus the shared one
+    EXPECT_EQ(pool.laneCapacity(1), 4u);  // lane 0 borrows down
+    EXPECT_EQ(pool.laneCapacity(2), 3u);  // lane 1 keeps to itself
+}
+
+TEST(LanedThreadPool, ReservedWorkerIsolatesItsLane)
+{
+    LanedThreadPool pool{2, {{1, false}, {0, true}}, IdlePolicy::cpuFrugal()};
+    pool.start();
+
+    // keep the shared worker busy with low lane work
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::vector<Job> low;
+    for (int i = 0; i < 4; ++i) low.emplace_back([gate] { gate.wait(); });
+    ASSERT_TRUE(pool.submitToLane(low, 1));
+    std::this_thread::sleep_for(20ms);
+
+    std::promise<void> urgent;
+    std::vector<Job> high;
+    high.emplace_back([&] { urgent.set_value(); });
+    ASSERT_TRUE(pool.submitToLane(high, 0));
+    EXPECT_EQ(std::future_status::ready,
+              urgent.get_future().wait_for(1s));
+
+    release.set_value();
+    pool.stop();
+}
+
+TEST(LanedThreadPool, BorrowingWorkerHelpsLowerLanes)
+{
+    LanedThreadPool pool{2, {{1, true}, {0, true}}, IdlePolicy::cpuFrugal()};
+    pool.start();
+
+    // both low jobs only finish together, which needs both workers
+    std::atomic<int> arrived{0};
+    std::promise<void> done;
+    std::vector<Job> low;
+    for (int i = 0; i < 2; ++i) {
+        low.emplace_back([&] {
+            arrived.fetch_add(1);
+            auto until = std::chrono::steady_clock::now() + 1s;
+            while (arrived.load() < 2 &&
+                   std::chrono::steady_clock::now() < until) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    ASSERT_TRUE(pool.submitToLane(low, 1));
+    pool.stop();
+    EXPECT_EQ(arrived.load(), 2);
+}
+
+TEST(LanedThreadPool, DrainsEveryLaneOnStop)
+{
+    std::atomic<int> ran{0};
+    {
+        LanedThreadPool pool{3, {{1, false}, {1, false}, {0, true}}};
+        pool.start();
+        for (size_t lane = 0; lane < 3; ++lane) {
+            std::vector<Job> jobs;
+            for (int i = 0; i < 10; ++i) jobs.emplace_back([&] { ran.fetch_add(1); });
+            ASSERT_TRUE(pool.submitToLane(jobs, lane));
+        }
+        pool.stop();
+        std::vector<Job> late;
+        late.emplace_back([] {});
+        EXPECT_FALSE(pool.submitToLane(late, 0));
+    }
+    EXPECT_EQ(ran.load(), 30);
+}
+
+// wakeFor() stops once the parkings it notified cover the jobs
+TEST(LanedThreadPool, ParkingReportsTheWorkersANotifyCovers)
+{
+    for (auto [count, covered] : {std::pair{1u, 1u}, std::pair{5u, 2u}}) {
+        WorkerParking parking{IdlePolicy::cpuFrugal()};
+        std::atomic<bool> done{false};
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 2; ++i) {
+            workers.emplace_back([&] {
+                while (!done.load()) parking.idle([&] { return done.load(); });
+            });
+        }
+        while (parking.idleWorkers() < 2) std::this_thread::sleep_for(1ms);
+
+        EXPECT_EQ(parking.notify(count), covered);
+
+        done.store(true);
+        parking.notifyAll();
+        for (auto& worker : workers) worker.join();
+        EXPECT_EQ(parking.notify(1), 0u);
+    }
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "scheduler/latency_histogram.h"
+#include <cstdint>
+
+using scheduler::LatencyHistogram;
+
+TEST(LatencyHistogram, EmptyHistogram)
+{
+    LatencyHistogram hist;
+    EXPECT_EQ(hist.count(), 0u);
+    EXPECT_EQ(hist.min(), 0);
+    EXPECT_EQ(hist.max(), 0);
+    EXPECT_EQ(hist.valueAtPercentile(99.0), 0);
+    EXPECT_DOUBLE_EQ(hist.mean(), 0.0);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact)
+{
+    for (int64_t v = 0; v < 128; ++v) {
+        auto bucket = LatencyHistogram::bucketIndex(v);
+        EXPECT_EQ(LatencyHistogram::bucketLowest(bucket), v);
+        EXPECT_EQ(LatencyHistogram::bucketHighest(bucket), v);
+    }
+}
+
+TEST(LatencyHistogram, BucketsCoverEveryValueWithBoundedError)
+{
+    int64_t expected_low = 0;
+    for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+        int64_t low = LatencyHistogram::bucketLowest(bucket);
+        int64_t high = LatencyHistogram::bucketHighest(bucket);
+        // buckets are contiguous and in order
+        ASSERT_EQ(low, expected_low) << "bucket " << bucket;
+        ASSERT_LE(low, high);
+        ASSERT_EQ(LatencyHistogram::bucketIndex(low), bucket);
+        ASSERT_EQ(LatencyHistogram::bucketIndex(high), bucket);
+        ASSERT_LE(double(high - low), double(low) / 64.0 + 1.0);
+        expected_low = high + 1;
+    }
+    EXPECT_EQ(expected_low, int64_t{1} << LatencyHistogram::kMaxValueBits);
+}
+
+TEST(LatencyHistogram, OutOfRangeValuesAreClamped)
+{
+    EXPECT_EQ(LatencyHistogram::bucketIndex(-5), 0u);
+    EXPECT_EQ(LatencyHistogram::bucketIndex(INT64_MAX),
+              LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogram, PercentilesOfATail)
+{
+    LatencyHistogram hist;
+    for (int i = 0; i < 990; ++i) hist.record(100);
+    for (int i = 0; i < 9; ++i) hist.record(5000);
+    hist.record(100000);
+
+    EXPECT_EQ(hist.valueAtPercentile(50.0), 100);
+    EXPECT_EQ(hist.valueAtPercentile(99.0), 100);
+    auto p999 = hist.valueAtPercentile(99.9);
+    EXPECT_GE(p999, 5000);
+    EXPECT_LE(p999, 5000 + 5000 / 64);
+    auto p100 = hist.valueAtPercentile(100.0);
+    EXPECT_GE(p100, 100000);
+    EXPECT_EQ(p100, hist.max());
+    EXPECT_EQ(hist.valueAtPercentile(0.0), 100);
+}
+
+TEST(LatencyHistogram, MergeAddsCounts)
+{
+    LatencyHistogram a;
+    LatencyHistogram b;
+    a.record(10);
+    b.record(20);
+    b.record(30);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 3u);
+    EXPECT_EQ(a.min(), 10);
+    EXPECT_EQ(a.max(), 30);
+    EXPECT_DOUBLE_EQ(a.mean(), 20.0);
+}
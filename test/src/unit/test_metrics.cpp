@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "scheduler/metrics.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace scheduler;
+
+namespace {
+MetricsSnapshot sample()
+{
+    MetricsSnapshot snapshot;
+    snapshot.submitted = 12;
+    snapshot.completed = 10;
+    snapshot.queue_depth = 2;
+    snapshot.busy_time = std::chrono::milliseconds{1500};
+    snapshot.parked_time = std::chrono::milliseconds{250};
+    snapshot.worker_wakeups = 7;
+    snapshot.latency.record(10);
+    snapshot.latency.record(30);
+    return snapshot;
+}
+
+std::string readSocket(std::string const& path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s",
+                  path.c_str());
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) != 0) {
+        close(fd);
+        return {};
+    }
+    std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, size_t(n));
+    }
+    close(fd);
+    return response;
+}
+}
+
+TEST(Metrics, RendersPrometheusText)
+{
+    auto text = toPrometheusText(sample(), "app");
+    EXPECT_NE(text.find("# TYPE app_tasks_submitted_total counter\n"
+                        "app_tasks_submitted_total 12\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE app_queue_depth gauge\napp_queue_depth 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("app_worker_busy_seconds_total 1.5\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("app_worker_parked_seconds_total 0.25\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("app_worker_wakeups_total 7\n"), std::string::npos);
+    EXPECT_NE(text.find("app_latency_microseconds{quantile=\"0.5\"} 10\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("app_latency_microseconds_count 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("app_latency_microseconds_sum 40\n"),
+              std::string::npos);
+}
+
+TEST(Metrics, WritesTheFileInOneStep)
+{
+    std::string path = ::testing::TempDir() + "scheduler_metrics.prom";
+    ASSERT_TRUE(writePrometheusFile(sample(), path));
+    std::ifstream file{path};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(contents.str(), toPrometheusText(sample()));
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(writePrometheusFile(sample(), "/nonexistent/dir/x.prom"));
+}
+
+TEST(Metrics, ServesSnapshotsOnAUnixSocket)
+{
+    std::string path = ::testing::TempDir() + "scheduler_metrics.sock";
+    int scrapes = 0;
+    {
+        MetricsServer server{path, [&] {
+            ++scrapes;
+            return sample();
+        }};
+        auto first = readSocket(path);
+        EXPECT_EQ(first.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+        EXPECT_NE(first.find("scheduler_tasks_completed_total 10\n"),
+                  std::string::npos);
+        EXPECT_FALSE(readSocket(path).empty());
+    }
+    EXPECT_EQ(scrapes, 2);
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include "detail/metrics_recorder.h"
+#include <thread>
+#include <vector>
+
+using namespace scheduler::detail;
+
+TEST(MetricsRecorder, SumsUpEveryThread)
+{
+    MetricsRecorder recorder;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) recorder.add(Counter::Completed);
+            recorder.add(Counter::BusyNanos, 50);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(recorder.total(Counter::Completed), 4000u);
+    EXPECT_EQ(recorder.total(Counter::BusyNanos), 200u);
+    EXPECT_EQ(recorder.total(Counter::Rejected), 0u);
+}
+
+TEST(MetricsRecorder, ExitedThreadsKeepTheirCounts)
+{
+    MetricsRecorder recorder;
+    for (int t = 0; t < 8; ++t) {
+        std::thread([&] { recorder.add(Counter::Submitted, 3); }).join();
+    }
+    EXPECT_EQ(recorder.total(Counter::Submitted), 24u);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "detail/multi_queue_impl.h"
+#include <chrono>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+using namespace scheduler::detail;
+
+namespace {
+Task makeTask(int priority, uint64_t seq)
+{
+    return Task([] {}, priority, seq, std::chrono::milliseconds{0},
+                std::chrono::steady_clock::now(), std::nullopt);
+}
+}
+
+TEST(MultiQueue, PopOnEmptyReturnsNullopt)
+{
+    MultiQueue queue{4};
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_FALSE(queue.peek().has_value());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MultiQueue, StrictModeMatchesTaskOrder)
+{
+    MultiQueue queue{8, MultiQueue::Mode::Strict};
+    auto now = std::chrono::steady_clock::now();
+    queue.push(makeTask(3, 1));
+    queue.push(makeTask(91, 2));
+    queue.push(Task([] {}, 89, 3, std::chrono::milliseconds{0}, now, now));
+    queue.push(Task([] {}, 90, 4, std::chrono::milliseconds{0}, now,
+                    now + std::chrono::milliseconds{1}));
+    EXPECT_EQ(queue.size(), 4u);
+
+    auto head = queue.peek();
+    ASSERT_TRUE(head.has_value());
+    EXPECT_EQ(head->get().priority, 89);
+
+    for (int expected : {89, 90, 91, 3}) {
+        auto t = queue.pop();
+        ASSERT_TRUE(t.has_value());
+        EXPECT_EQ(t->priority, expected);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MultiQueue, StrictModeFifoTieBreak)
+{
+    MultiQueue queue{4, MultiQueue::Mode::Strict};
+    for (uint64_t seq = 0; seq < 20; ++seq) queue.push(makeTask(5, seq));
+    for (uint64_t seq = 0; seq < 20; ++seq) {
+        auto t = queue.pop();
+        ASSERT_TRUE(t.has_value());
+        EXPECT_EQ(t->sequence_number, seq);
+    }
+}
+
+TEST(MultiQueue, RelaxedModeDrainsEverything)
+{
+    MultiQueue queue{4};
+    constexpr int N = 100;
+    for (int i = 0; i < N; ++i) queue.push(makeTask(i, i));
+    EXPECT_EQ(queue.size(), static_cast<size_t>(N));
+
+    std::set<uint64_t> seen;
+    while (auto t = queue.pop()) seen.insert(t->sequence_number);
+    EXPECT_EQ(seen.size(), static_cast<size_t>(N));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MultiQueue, RelaxedModeHeadsAreNearTheFront)
+{
+    // with a single shard the relaxed queue degenerates into a strict heap
+    MultiQueue queue{1};
+    for (int i = 0; i < 10; ++i) queue.push(makeTask(i, i));
+    for (int expected = 9; expected >= 0; --expected) {
+        auto t = queue.pop();
+        ASSERT_TRUE(t.has_value());
+        EXPECT_EQ(t->priority, expected);
+    }
+}
+
+TEST(MultiQueue, ConcurrentProducersAndConsumers)
+{
+    MultiQueue queue{8};
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 2000;
+    std::atomic<int> consumed{0};
+    std::atomic<bool> producing{true};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                queue.push(makeTask(i % 50, p * kPerProducer + i));
+            }
+        });
+    }
+    for (int c = 0; c < 4; ++c) {
+        threads.emplace_back([&] {
+            while (producing.load() || !queue.empty()) {
+                if (queue.pop()) consumed.fetch_add(1);
+            }
+        });
+    }
+    for (int p = 0; p < kProducers; ++p) threads[p].join();
+    producing.store(false);
+    for (size_t i = kProducers; i < threads.size(); ++i) threads[i].join();
+
+    EXPECT_EQ(consumed.load(), kProducers * kPerProducer);
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(MultiQueue, PushBatchSpreadsOverShards)
+{
+    MultiQueue queue{4, MultiQueue::Mode::Strict};
+    std::vector<Task> batch;
+    for (uint64_t seq = 0; seq < 100; ++seq) {
+        batch.push_back(makeTask(static_cast<int>(seq % 10), seq));
+    }
+    queue.pushBatch(batch);
+    EXPECT_EQ(queue.size(), 100u);
+
+    std::optional<Task> prev = queue.pop();
+    size_t popped = 1;
+    while (auto next = queue.pop()) {
+        EXPECT_FALSE(*prev < *next);
+        prev = std::move(next);
+        ++popped;
+    }
+    EXPECT_EQ(popped, 100u);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MultiQueue, EraseAndChangeDeadlineByState)
+{
+    MultiQueue queue{4, MultiQueue::Mode::Strict};
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<TaskState>> states;
+    for (uint64_t seq = 0; seq < 40; ++seq) {
+        auto state = makeTaskState();
+        states.push_back(state);
+        queue.push(Task([] {}, 1, seq, std::chrono::milliseconds{0}, now,
+                        std::nullopt, state));
+    }
+
+    for (uint64_t seq = 0; seq < 40; seq += 2) {
+        EXPECT_TRUE(queue.erase(*states[seq]).has_value());
+    }
+    EXPECT_EQ(queue.size(), 20u);
+    // a deadline moves the last task to the front
+    EXPECT_TRUE(queue.changeDeadline(*states[39], now));
+    EXPECT_EQ(queue.pop()->sequence_number, 39u);
+    EXPECT_FALSE(queue.changeDeadline(*states[39], now));
+
+    size_t popped = 0;
+    while (auto task = queue.pop()) {
+        EXPECT_EQ(task->sequence_number % 2, 1u);
+        ++popped;
+    }
+    EXPECT_EQ(popped, 19u);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "detail/queue_budget.h"
+#include "detail/task.h"
+#include <array>
+#include <vector>
+
+using namespace scheduler::detail;
+
+TEST(QueueBudget, NeverGoesPastACap)
+{
+    scheduler::QueueLimits limits;
+    limits.max_tasks = 3;
+    limits.max_bytes = 1000;
+    QueueBudget budget{limits};
+
+    EXPECT_TRUE(budget.tryAcquire(2, 400));
+    EXPECT_FALSE(budget.tryAcquire(2, 100));   // tasks
+    EXPECT_FALSE(budget.tryAcquire(1, 700));   // bytes
+    EXPECT_EQ(budget.tasks(), 2u);
+    EXPECT_EQ(budget.bytes(), 400u);
+    EXPECT_TRUE(budget.tryAcquire(1, 600));
+
+    // internal pushes always go through
+    budget.acquire(1, 10);
+    EXPECT_EQ(budget.tasks(), 4u);
+    budget.release(4, 1010);
+    EXPECT_EQ(budget.tasks(), 0u);
+    EXPECT_EQ(budget.bytes(), 0u);
+}
+
+TEST(QueueBudget, ReportsPressureBetweenWatermarks)
+{
+    std::vector<bool> changes;
+    scheduler::QueueLimits limits;
+    limits.max_tasks = 10;
+    limits.high_watermark = 0.8;
+    limits.low_watermark = 0.5;
+    limits.on_pressure = [&](bool on) { changes.push_back(on); };
+    QueueBudget budget{limits};
+
+    budget.acquire(7, 0);
+    EXPECT_FALSE(budget.pressured());
+    budget.acquire(1, 0);
+    EXPECT_TRUE(budget.pressured());
+    budget.release(2, 0);  // 6, still above the low mark
+    EXPECT_TRUE(budget.pressured());
+    budget.release(1, 0);
+    EXPECT_FALSE(budget.pressured());
+    budget.release(5, 0);
+    EXPECT_EQ(changes, (std::vector<bool>{true, false}));
+}
+
+TEST(QueueBudget, CountsPooledCallables)
+{
+    Task small([] {}, 0, 0, milliseconds{0}, time_point{}, std::nullopt);
+    std::array<char, 300> payload{};
+    Task large([payload] { (void)payload; }, 0, 1, milliseconds{0},
+               time_point{}, std::nullopt);
+    EXPECT_EQ(QueueBudget::footprint(small), sizeof(Task));
+    EXPECT_GE(QueueBudget::footprint(large), sizeof(Task) + payload.size());
+}
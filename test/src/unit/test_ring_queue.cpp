@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "detail/ring_queue.h"
+#include <memory>
+#include <string>
+
+using scheduler::detail::RingQueue;
+
+TEST(RingQueue, KeepsFifoOrderAcrossGrowth)
+{
+    RingQueue<int> queue;
+    EXPECT_TRUE(queue.empty());
+    // wrap the ring before it grows
+    for (int i = 0; i < 10; ++i) queue.push_back(int{i});
+    for (int i = 0; i < 8; ++i) queue.pop_front();
+    for (int i = 10; i < 100; ++i) queue.push_back(int{i});
+
+    EXPECT_EQ(queue.size(), 92u);
+    for (int i = 8; i < 100; ++i) {
+        ASSERT_EQ(queue.front(), i);
+        queue.pop_front();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(RingQueue, ReusesItsCapacity)
+{
+    RingQueue<std::string> queue;
+    for (int round = 0; round < 1000; ++round) {
+        for (int i = 0; i < 10; ++i) queue.emplace_back(20, 'x');
+        while (!queue.empty()) queue.pop_front();
+    }
+    EXPECT_EQ(queue.capacity(), 16u);
+}
+
+TEST(RingQueue, DestroysWhatIsLeft)
+{
+    auto tracked = std::make_shared<int>(0);
+    {
+        RingQueue<std::shared_ptr<int>> queue;
+        for (int i = 0; i < 40; ++i) queue.emplace_back(tracked);
+        EXPECT_EQ(tracked.use_count(), 41);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
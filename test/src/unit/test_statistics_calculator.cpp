@@ -3,6 +3,8 @@
 #include "detail/statistics_calculator_impl.h"
 #include <gtest/gtest.h>
 #include <limits>
+#include <thread>
+#include <vector>
 
 using namespace scheduler::detail;
 
@@ -38,3 +40,63 @@ TEST(StatisticsCalculator, MultipleSamples) {
     EXPECT_DOUBLE_EQ(mn, 50.0);
     EXPECT_DOUBLE_EQ(mx, 200.0);
 }
+
+TEST(StatisticsCalculator, HistogramPercentiles) {
+    StatisticsCalculator stats;
+    for (int64_t v = 1; v <= 100; ++v) stats.updateLatencyStatistics(v);
+
+    auto hist = stats.getLatencyHistogram();
+    EXPECT_EQ(hist.count(), 100u);
+    EXPECT_EQ(hist.valueAtPercentile(50.0), 50);
+    EXPECT_EQ(hist.valueAtPercentile(99.0), 99);
+    EXPECT_EQ(hist.valueAtPercentile(100.0), 100);
+    EXPECT_NEAR(hist.mean(), 50.5, 1e-9);
+}
+
+TEST(StatisticsCalculator, ResetStartsNewInterval) {
+    StatisticsCalculator stats;
+    stats.updateLatencyStatistics(10);
+    stats.updateLatencyStatistics(20);
+
+    auto first = stats.resetLatencyHistogram();
+    EXPECT_EQ(first.count(), 2u);
+    EXPECT_EQ(stats.getLatencyHistogram().count(), 0u);
+
+    stats.updateLatencyStatistics(30);
+    auto second = stats.resetLatencyHistogram();
+    EXPECT_EQ(second.count(), 1u);
+    EXPECT_EQ(second.min(), 30);
+
+    // the summary keeps covering everything
+    auto [avg, mn, mx] = stats.getLatencyStatistics();
+    EXPECT_DOUBLE_EQ(avg, 20.0);
+    EXPECT_DOUBLE_EQ(mn, 10.0);
+    EXPECT_DOUBLE_EQ(mx, 30.0);
+}
+
+TEST(StatisticsCalculator, MergesRecordersOfAllThreads) {
+    StatisticsCalculator stats;
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 10000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&stats, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                stats.updateLatencyStatistics(t * 1000 + i % 1000);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    auto hist = stats.getLatencyHistogram();
+    EXPECT_EQ(hist.count(), uint64_t(kThreads * kPerThread));
+    auto [avg, mn, mx] = stats.getLatencyStatistics();
+    EXPECT_DOUBLE_EQ(mn, 0.0);
+    EXPECT_DOUBLE_EQ(mx, 3999.0);
+
+    // recorders of exited threads are reused rather than added
+    std::thread([&stats] { stats.updateLatencyStatistics(1); }).join();
+    EXPECT_EQ(stats.getLatencyHistogram().count(),
+              uint64_t(kThreads * kPerThread + 1));
+}
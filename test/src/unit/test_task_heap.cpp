@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include "detail/task_heap.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace scheduler::detail;
+
+namespace {
+Task makeTask(int priority, uint64_t seq,
+              std::optional<time_point> deadline = std::nullopt)
+{
+    return Task([] {}, priority, seq, milliseconds{0},
+                std::chrono::steady_clock::now(), deadline);
+}
+
+// a one-off task without a deadline
+Task oneOff(scheduler::InplaceTask task, int priority, uint64_t seq)
+{
+    return Task(std::move(task), priority, seq, milliseconds{0},
+                time_point{}, std::nullopt);
+}
+}
+
+TEST(TaskKey, MatchesTaskOrdering)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<Task> tasks;
+    tasks.push_back(makeTask(0, 0));
+    tasks.push_back(makeTask(5, 1));
+    tasks.push_back(makeTask(-5, 2));
+    tasks.push_back(makeTask(INT_MAX, 3));
+    tasks.push_back(makeTask(INT_MIN, 4));
+    tasks.push_back(makeTask(5, 5));
+    tasks.push_back(makeTask(0, 6, now));
+    tasks.push_back(makeTask(9, 7, now));
+    tasks.push_back(makeTask(0, 8, now - std::chrono::seconds{1}));
+    tasks.push_back(makeTask(0, 9, time_point::max()));
+    tasks.push_back(makeTask(0, 10, time_point::min()));
+
+    for (auto const& a : tasks) {
+        for (auto const& b : tasks) {
+            // Task::operator< is "runs later", TaskKey::operator< "runs first"
+            EXPECT_EQ(a < b, TaskKey::of(b) < TaskKey::of(a))
+                << "seq " << a.sequence_number << " vs " << b.sequence_number;
+        }
+    }
+}
+
+TEST(TaskHeap, PopsInTaskOrder)
+{
+    TaskHeap heap;
+    std::vector<Task> expected;
+    std::mt19937 rng{7};
+    auto now = std::chrono::steady_clock::now();
+    for (uint64_t seq = 0; seq < 500; ++seq) {
+        int priority = static_cast<int>(rng() % 8);
+        std::optional<time_point> deadline;
+        if (rng() % 4 == 0) deadline = now + milliseconds{rng() % 16};
+        heap.push(makeTask(priority, seq, deadline));
+        expected.push_back(makeTask(priority, seq, deadline));
+    }
+    std::sort(expected.begin(), expected.end(),
+              [](Task const& a, Task const& b) { return b < a; });
+
+    ASSERT_EQ(heap.size(), expected.size());
+    for (auto const& want : expected) {
+        EXPECT_EQ(heap.top().sequence_number, want.sequence_number);
+        EXPECT_EQ(heap.pop().sequence_number, want.sequence_number);
+    }
+    EXPECT_TRUE(heap.empty());
+}
+
+TEST(TaskHeap, TopReferenceSurvivesOtherOperations)
+{
+    TaskHeap heap;
+    heap.push(makeTask(100, 0));
+    Task const& top = heap.top();
+    // enough pushes to grow the slab and the key vector several times
+    for (uint64_t seq = 1; seq < 300; ++seq) heap.push(makeTask(0, seq));
+    EXPECT_EQ(&heap.top(), &top);
+    EXPECT_EQ(top.priority, 100);
+}
+
+TEST(TaskHeap, ReusesSlotsAndDestroysLeftovers)
+{
+    int ran = 0;
+    auto counter = std::make_shared<int>(0);
+    {
+        TaskHeap heap;
+        for (int round = 0; round < 3; ++round) {
+            for (uint64_t seq = 0; seq < 100; ++seq) {
+                heap.push(oneOff([&ran] { ++ran; }, 0, seq));
+            }
+            while (!heap.empty()) heap.pop().task();
+        }
+        heap.push(oneOff([counter] {}, 0, 0));
+        EXPECT_EQ(counter.use_count(), 2);
+    }
+    EXPECT_EQ(ran, 300);
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(TaskHeap, PushBatchMatchesSinglePushes)
+{
+    // small batches into a big heap sift up, big batches heapify
+    for (size_t batch_size : {3u, 400u}) {
+        TaskHeap heap;
+        std::mt19937 rng{11};
+        uint64_t seq = 0;
+        for (; seq < 100; ++seq) {
+            heap.push(makeTask(static_cast<int>(rng() % 8), seq));
+        }
+        std::vector<Task> batch;
+        for (size_t i = 0; i < batch_size; ++i, ++seq) {
+            batch.push_back(makeTask(static_cast<int>(rng() % 8), seq));
+        }
+        heap.pushBatch(batch);
+        ASSERT_EQ(heap.size(), 100 + batch_size);
+
+        Task prev = heap.pop();
+        while (!heap.empty()) {
+            Task next = heap.pop();
+            EXPECT_FALSE(prev < next);
+            prev = std::move(next);
+        }
+    }
+}
+
+TEST(TaskHeap, EraseAndUpdateThroughState)
+{
+    TaskHeap heap;
+    std::mt19937 rng{3};
+    std::vector<std::shared_ptr<TaskState>> states;
+    for (uint64_t seq = 0; seq < 200; ++seq) {
+        auto state = makeTaskState();
+        states.push_back(state);
+        heap.push(Task([] {}, static_cast<int>(rng() % 16), seq, milliseconds{0},
+                       std::chrono::steady_clock::now(), std::nullopt, state));
+    }
+
+    // erase every third task, re-prioritize every other one
+    size_t expected = states.size();
+    for (size_t i = 0; i < states.size(); ++i) {
+        Task* task = heap.find(*states[i]);
+        ASSERT_NE(task, nullptr);
+        if (i % 3 == 0) {
+            EXPECT_EQ(heap.erase(*task).sequence_number, i);
+            EXPECT_EQ(heap.find(*states[i]), nullptr);
+            --expected;
+        } else if (i % 2 == 0) {
+            task->priority = static_cast<int>(rng() % 16);
+            heap.update(*task);
+        }
+    }
+    ASSERT_EQ(heap.size(), expected);
+
+    Task prev = heap.pop();
+    EXPECT_EQ(prev.state->slot, TaskState::kNoSlot);
+    while (!heap.empty()) {
+        Task next = heap.pop();
+        EXPECT_FALSE(prev < next);
+        EXPECT_NE(next.sequence_number % 3, 0u);
+        prev = std::move(next);
+    }
+}
+
+TEST(TaskHeap, FindIgnoresRecycledSlots)
+{
+    TaskHeap heap;
+    auto first = makeTaskState();
+    auto second = makeTaskState();
+    heap.push(Task([] {}, 0, 0, milliseconds{0},
+                   std::chrono::steady_clock::now(), std::nullopt, first));
+    heap.pop();
+    heap.push(Task([] {}, 0, 1, milliseconds{0},
+                   std::chrono::steady_clock::now(), std::nullopt, second));
+    EXPECT_EQ(heap.find(*first), nullptr);
+    EXPECT_NE(heap.find(*second), nullptr);
+}
@@ -5,6 +5,7 @@
 #include <thread>
 #include <unordered_set>
 #include <atomic>
+#include <vector>
 
 using namespace scheduler::detail;
 
@@ -188,3 +189,50 @@ TEST_F(TestTaskQueue, SizeReflectsPushesAndPops)
         EXPECT_EQ(task_queue->size(), static_cast<size_t>(i - 1));
     }
 }
+
+TEST_F(TestTaskQueue, PushBatchKeepsOrdering)
+{
+    auto now = std::chrono::steady_clock::now();
+    task_queue->push(Task([] {}, 5, 0, std::chrono::milliseconds{0}, now,
+                          std::nullopt));
+
+    std::vector<Task> batch;
+    for (int i = 1; i <= 20; ++i)
+    {
+        batch.emplace_back([] {}, i % 7, i, std::chrono::milliseconds{0}, now,
+                           std::nullopt);
+    }
+    task_queue->pushBatch(batch);
+    EXPECT_EQ(task_queue->size(), 21u);
+
+    std::optional<Task> prev = task_queue->pop();
+    ASSERT_TRUE(prev.has_value());
+    while (auto next = task_queue->pop())
+    {
+        EXPECT_FALSE(*prev < *next);
+        prev = std::move(next);
+    }
+}
+
+TEST_F(TestTaskQueue, EraseAndReprioritizeByState)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto low = makeTaskState();
+    auto gone = makeTaskState();
+    task_queue->push(Task([] {}, 1, 0, std::chrono::milliseconds{0}, now,
+                          std::nullopt, low));
+    task_queue->push(Task([] {}, 5, 1, std::chrono::milliseconds{0}, now,
+                          std::nullopt, gone));
+    task_queue->push(Task([] {}, 3, 2, std::chrono::milliseconds{0}, now,
+                          std::nullopt));
+
+    EXPECT_TRUE(task_queue->erase(*gone).has_value());
+    EXPECT_FALSE(task_queue->erase(*gone).has_value());
+    EXPECT_EQ(task_queue->size(), 2u);
+
+    EXPECT_TRUE(task_queue->reprioritize(*low, 9));
+    EXPECT_EQ(task_queue->pop()->sequence_number, 0u);
+
+    EXPECT_FALSE(task_queue->changeDeadline(*low, now));
+    EXPECT_EQ(task_queue->pop()->sequence_number, 2u);
+}
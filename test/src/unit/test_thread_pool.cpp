@@ -1,12 +1,16 @@
 #include <algorithm>
 #include <atomic>
 #include <future>
+#include <vector>
 #include <gmock/gmock.h>
 #include "detail/thread_pool_impl.h"
+#include "scheduler/blocking_scope.h"
+#include <sched.h>
 
 using ::testing::_;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
+using namespace scheduler;
 using namespace scheduler::detail;
 
 class ThreadPoolTest : public ::testing::Test
@@ -194,3 +198,273 @@ TEST_F(ThreadPoolTest, PendingTasksDrainedOnShutdown)
     // Wait for all of them to finish
     done.wait();
 }
+
+TEST_F(ThreadPoolTest, SubmitBatchRunsEveryJob)
+{
+    constexpr int N = 50;
+    CountDownLatch latch{N};
+    std::vector<Job> jobs;
+    for (int i = 0; i < N; ++i) jobs.emplace_back([&]{ latch.count_down(); });
+
+    ASSERT_TRUE(pool->submitBatch(jobs));
+    latch.wait();
+
+    pool->stop();
+    std::vector<Job> late;
+    late.emplace_back([]{});
+    EXPECT_FALSE(pool->submitBatch(late));
+}
+
+class ThreadPoolIdlePolicyTest : public ::testing::TestWithParam<IdlePolicy>
+{
+};
+
+// Alternates bursts with pauses long enough for every worker to park, so a
+// lost wakeup shows up as a hang
+TEST_P(ThreadPoolIdlePolicyTest, NoLostWakeupsAcrossParking)
+{
+    ThreadPool pool{3, GetParam()};
+    pool.start();
+    for (int round = 0; round < 20; ++round)
+    {
+        constexpr int N = 8;
+        CountDownLatch latch{N};
+        for (int i = 0; i < N; ++i)
+        {
+            ASSERT_TRUE(pool.submit([&]{ latch.count_down(); }));
+        }
+        latch.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    pool.stop();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Policies, ThreadPoolIdlePolicyTest,
+    ::testing::Values(IdlePolicy::latencyOptimized(), IdlePolicy::cpuFrugal(),
+                      IdlePolicy{16, 0}));
+
+TEST(ThreadPoolPlacement, PinnedWorkersStayOnTheirCpu)
+{
+    WorkerPlacement placement;
+    placement.cpus = {0};
+    placement.pin = true;
+    ThreadPool pool{2, IdlePolicy::cpuFrugal(), placement};
+    pool.start();
+
+    constexpr int N = 16;
+    CountDownLatch latch{N};
+    std::atomic<int> elsewhere{0};
+    for (int i = 0; i < N; ++i)
+    {
+        ASSERT_TRUE(pool.submit([&] {
+            if (sched_getcpu() != 0) elsewhere.fetch_add(1);
+            latch.count_down();
+        }));
+    }
+    latch.wait();
+    pool.stop();
+    EXPECT_EQ(elsewhere.load(), 0);
+}
+
+TEST(ThreadPoolPlacement, NodeHintsRunOnEveryNode)
+{
+    WorkerPlacement placement;
+    placement.numa = true;
+    ThreadPool pool{2, IdlePolicy::cpuFrugal(), placement};
+    pool.start();
+
+    // hints for nodes this host may not have fall back to any worker
+    constexpr int N = 8;
+    CountDownLatch latch{N * 3};
+    for (int node : {kAnyNode, pool.plan().nodes[0].id, 1000})
+    {
+        std::vector<Job> jobs;
+        for (int i = 0; i < N; ++i) jobs.emplace_back([&]{ latch.count_down(); });
+        ASSERT_TRUE(pool.submitToNode(jobs, node));
+    }
+    latch.wait();
+    pool.stop();
+}
+
+TEST(ThreadPoolElastic, GrowsUnderBacklogAndShrinksWhenIdle)
+{
+    ElasticThreads elastic;
+    elastic.min_threads = 1;
+    elastic.max_threads = 3;
+    elastic.grow_queue_depth = 1;
+    elastic.grow_wait = std::chrono::microseconds{100};
+    elastic.idle_timeout = std::chrono::milliseconds{30};
+    elastic.cooldown = std::chrono::milliseconds{5};
+    ThreadPool pool{1, IdlePolicy::cpuFrugal(), {}, elastic};
+    pool.start();
+    EXPECT_EQ(pool.threadCount(), 1u);
+    EXPECT_EQ(pool.laneCapacity(0), 3u);
+
+    // keep a backlog of blocked jobs until the pool stops growing
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    for (int round = 0; round < 10; ++round)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            ASSERT_TRUE(pool.submit([gate] { gate.wait(); }));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto busy = pool.workerCounts();
+    EXPECT_EQ(busy.live, 3u);
+    EXPECT_EQ(busy.grown, 2u);
+
+    release.set_value();
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (pool.threadCount() > 1 && std::chrono::steady_clock::now() < until)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    auto idle = pool.workerCounts();
+    EXPECT_EQ(idle.live, 1u);
+    EXPECT_EQ(idle.retired, 2u);
+
+    // a retired slot is reused when the load comes back
+    CountDownLatch latch{4};
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(pool.submit([&] { latch.count_down(); }));
+    }
+    latch.wait();
+    pool.stop();
+}
+
+TEST(ThreadPoolBlocking, CompensatesForBlockedWorker)
+{
+    ThreadPool pool{1, IdlePolicy::cpuFrugal(), {}, std::nullopt, 1};
+    size_t capacity_changes = 0;
+    pool.onCapacityChange([&] { ++capacity_changes; });
+    pool.start();
+    EXPECT_EQ(pool.laneCapacity(0), 1u);
+
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::promise<void> blocking;
+    ASSERT_TRUE(pool.submit([&, gate] {
+        BlockingScope scope;
+        BlockingScope nested;  // counts once
+        blocking.set_value();
+        gate.wait();
+    }));
+    blocking.get_future().wait();
+    EXPECT_EQ(pool.laneCapacity(0), 2u);
+    EXPECT_EQ(capacity_changes, 1u);
+
+    // the only regular worker is blocked, a compensating one runs this
+    std::promise<void> cpu;
+    ASSERT_TRUE(pool.submit([&] { cpu.set_value(); }));
+    ASSERT_EQ(std::future_status::ready,
+              cpu.get_future().wait_for(std::chrono::seconds(1)));
+    EXPECT_EQ(pool.workerCounts().compensating, 1u);
+    EXPECT_EQ(pool.workerCounts().live, 2u);
+
+    release.set_value();
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (pool.workerCounts().live > 1 &&
+           std::chrono::steady_clock::now() < until)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(pool.workerCounts().live, 1u);
+    EXPECT_EQ(pool.laneCapacity(0), 1u);
+    pool.stop();
+}
+
+TEST(ThreadPoolBlocking, CompensatesAgainAfterARegularWorkerRetired)
+{
+    ThreadPool pool{2, IdlePolicy::cpuFrugal(), {}, std::nullopt, 1};
+    pool.start();
+
+    // one worker blocks, the other is busy, the compensating one takes
+    // the third job
+    std::promise<void> unblock, unbusy, finish;
+    auto blocked_gate = unblock.get_future().share();
+    auto busy_gate = unbusy.get_future().share();
+    auto finish_gate = finish.get_future().share();
+    CountDownLatch started{3};
+    ASSERT_TRUE(pool.submit([&, blocked_gate] {
+        BlockingScope scope;
+        started.count_down();
+        blocked_gate.wait();
+    }));
+    ASSERT_TRUE(pool.submit([&, busy_gate] {
+        started.count_down();
+        busy_gate.wait();
+    }));
+    ASSERT_TRUE(pool.submit([&, finish_gate] {
+        started.count_down();
+        finish_gate.wait();
+    }));
+    started.wait();
+    EXPECT_EQ(pool.workerCounts().compensating, 1u);
+
+    // a regular worker goes idle first and retires in place of the
+    // compensating one, which is still busy
+    unbusy.set_value();
+    unblock.set_value();
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (pool.workerCounts().live > 2 &&
+           std::chrono::steady_clock::now() < until)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(pool.workerCounts().live, 2u);
+    finish.set_value();
+
+    // the slot the regular worker left is used for the next compensation
+    std::promise<void> unblock_again, unbusy_again;
+    auto blocked_again = unblock_again.get_future().share();
+    auto busy_again = unbusy_again.get_future().share();
+    CountDownLatch started_again{2};
+    ASSERT_TRUE(pool.submit([&, blocked_again] {
+        BlockingScope scope;
+        started_again.count_down();
+        blocked_again.wait();
+    }));
+    ASSERT_TRUE(pool.submit([&, busy_again] {
+        started_again.count_down();
+        busy_again.wait();
+    }));
+    started_again.wait();
+    std::promise<void> cpu;
+    ASSERT_TRUE(pool.submit([&] { cpu.set_value(); }));
+    EXPECT_EQ(std::future_status::ready,
+              cpu.get_future().wait_for(std::chrono::seconds(1)));
+    EXPECT_EQ(pool.workerCounts().compensating, 2u);
+
+    unblock_again.set_value();
+    unbusy_again.set_value();
+    pool.stop();
+}
+
+TEST(ThreadPoolBlocking, ScopeIsANoOpWithoutCompensation)
+{
+    {
+        BlockingScope outside_any_pool;
+    }
+    ThreadPool pool{1, IdlePolicy::cpuFrugal()};
+    pool.start();
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    ASSERT_TRUE(pool.submit([gate] {
+        BlockingScope scope;
+        gate.wait();
+    }));
+    std::promise<void> cpu;
+    ASSERT_TRUE(pool.submit([&] { cpu.set_value(); }));
+    auto ran = cpu.get_future();
+    EXPECT_EQ(std::future_status::timeout,
+              ran.wait_for(std::chrono::milliseconds(30)));
+    release.set_value();
+    EXPECT_EQ(std::future_status::ready,
+              ran.wait_for(std::chrono::seconds(1)));
+    EXPECT_EQ(pool.workerCounts().compensating, 0u);
+    pool.stop();
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "detail/thread_slot_cache.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace scheduler::detail;
+
+namespace {
+struct Counter {
+    std::atomic<uint64_t> value{0};
+    std::atomic<bool> owned{true};
+};
+
+Counter& local(ThreadSlotCache<Counter>& cache)
+{
+    return cache.local([] { return std::make_shared<Counter>(); });
+}
+}
+
+TEST(ThreadSlotCache, OneThreadWritingToManyRegistriesClaimsOnce)
+{
+    // like a worker recording into the latency of every task group
+    std::vector<std::unique_ptr<ThreadSlotCache<Counter>>> groups;
+    for (int i = 0; i < 12; ++i) {
+        groups.push_back(std::make_unique<ThreadSlotCache<Counter>>());
+    }
+    for (int round = 0; round < 100; ++round) {
+        for (auto& group : groups) ++local(*group).value;
+    }
+    for (auto& group : groups) {
+        EXPECT_EQ(group->claims(), 1u);
+        uint64_t total = 0;
+        group->forEach([&](Counter const& slot) { total += slot.value; });
+        EXPECT_EQ(total, 100u);
+    }
+}
+
+TEST(ThreadSlotCache, ExitedThreadHandsItsSlotBack)
+{
+    ThreadSlotCache<Counter> cache;
+    for (int t = 0; t < 4; ++t) {
+        std::thread([&] { ++local(cache).value; }).join();
+    }
+    size_t slots = 0;
+    uint64_t total = 0;
+    cache.forEach([&](Counter const& slot) {
+        ++slots;
+        total += slot.value;
+    });
+    EXPECT_EQ(slots, 1u);
+    EXPECT_EQ(total, 4u);
+    EXPECT_EQ(cache.claims(), 4u);
+}
+
+TEST(ThreadSlotCache, EntriesOfDestroyedRegistriesAreDropped)
+{
+    std::weak_ptr<Counter> orphan;
+    {
+        ThreadSlotCache<Counter> gone;
+        gone.local([&] {
+            auto slot = std::make_shared<Counter>();
+            orphan = slot;
+            return slot;
+        });
+    }
+    EXPECT_FALSE(orphan.expired());  // only the thread's cache holds it
+
+    ThreadSlotCache<Counter> next;
+    ++local(next).value;
+    EXPECT_TRUE(orphan.expired());
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "detail/system_clock_impl.h"
+#include "detail/task_queue_impl.h"
+#include "detail/timer_thread.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+class TimerThreadTest : public ::testing::Test
+{
+protected:
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<int> wakes{0};
+    std::shared_ptr<TimingWheel> wheel = std::make_shared<TimingWheel>(
+        sequence, 1ms, std::chrono::steady_clock::now());
+    std::shared_ptr<TaskQueue> queue = std::make_shared<TaskQueue>();
+    TimerThread thread{wheel, queue, std::make_shared<SystemClock>(),
+                       [this](size_t) { wakes.fetch_add(1); }};
+
+    void add(time_point at)
+    {
+        wheel->schedule(Task([] {}, 0, sequence++, 0ms, at, std::nullopt),
+                        at);
+        thread.rearm(at);
+    }
+
+    bool waitForQueue(size_t size, std::chrono::milliseconds limit)
+    {
+        auto until = std::chrono::steady_clock::now() + limit;
+        while (queue->size() < size) {
+            if (std::chrono::steady_clock::now() > until) return false;
+            std::this_thread::sleep_for(100us);
+        }
+        return true;
+    }
+};
+
+TEST_F(TimerThreadTest, MovesTimersIntoTheQueueWhenDue)
+{
+    thread.start();
+    auto start = std::chrono::steady_clock::now();
+    add(start + 20ms);
+    add(start + 20ms);
+
+    ASSERT_TRUE(waitForQueue(2, 1s));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    // both fires came in one wake
+    EXPECT_EQ(wakes.load(), 1);
+    EXPECT_EQ(thread.jitter().getLatencyHistogram().count(), 2u);
+}
+
+TEST_F(TimerThreadTest, EarlierTimerCutsTheSleepShort)
+{
+    thread.start();
+    auto start = std::chrono::steady_clock::now();
+    add(start + 10s);
+    add(start + 10ms);
+
+    ASSERT_TRUE(waitForQueue(1, 1s));
+    EXPECT_EQ(queue->size(), 1u);
+    EXPECT_EQ(wheel->size(), 1u);
+}
+
+TEST_F(TimerThreadTest, StopsWithTimersPending)
+{
+    thread.start();
+    add(std::chrono::steady_clock::now() + 10s);
+    thread.stop();
+    EXPECT_TRUE(queue->empty());
+}
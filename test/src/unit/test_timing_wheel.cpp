@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+#include "detail/timing_wheel.h"
+#include "detail/task_queue_impl.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+class TimingWheelTest : public ::testing::Test
+{
+protected:
+    std::atomic<uint64_t> sequence{0};
+    time_point origin = std::chrono::steady_clock::now();
+    TimingWheel wheel{sequence, 1ms, origin};
+    TaskQueue queue;
+
+    Task oneOff(int priority)
+    {
+        return Task([] {}, priority, sequence++, 0ms, origin, std::nullopt);
+    }
+};
+
+TEST_F(TimingWheelTest, FiresOnlyWhenDue)
+{
+    wheel.schedule(oneOff(1), origin + 10ms);
+    EXPECT_EQ(wheel.size(), 1u);
+
+    EXPECT_EQ(wheel.advance(origin + 9ms, queue), 0u);
+    EXPECT_TRUE(queue.empty());
+
+    EXPECT_EQ(wheel.advance(origin + 10ms, queue), 1u);
+    EXPECT_EQ(queue.size(), 1u);
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_FALSE(wheel.nextExpiry().has_value());
+}
+
+TEST_F(TimingWheelTest, PastTimerFiresOnNextAdvance)
+{
+    wheel.advance(origin + 100ms, queue);
+    wheel.schedule(oneOff(1), origin + 5ms);
+    ASSERT_TRUE(wheel.nextExpiry().has_value());
+    EXPECT_EQ(wheel.advance(origin + 100ms, queue), 1u);
+}
+
+TEST_F(TimingWheelTest, CascadesFromUpperLevels)
+{
+    // spans every level: 1 tick, a few level-1 slots, level 2 and level 3
+    std::vector<std::chrono::milliseconds> delays{
+        1ms, 63ms, 64ms, 65ms, 200ms, 4095ms, 4096ms, 5000ms, 300000ms};
+    for (auto d : delays) wheel.schedule(oneOff(1), origin + d);
+
+    size_t fired = 0;
+    for (auto d : delays) {
+        EXPECT_EQ(wheel.advance(origin + d - 1ms, queue), 0u) << d.count();
+        EXPECT_EQ(wheel.advance(origin + d, queue), 1u) << d.count();
+        ++fired;
+        EXPECT_EQ(queue.size(), fired);
+    }
+}
+
+TEST_F(TimingWheelTest, TimersBeyondTheTopLevelStillFire)
+{
+    auto far = std::chrono::milliseconds{(uint64_t{1} << 24) + 500};
+    wheel.schedule(oneOff(1), origin + far);
+    EXPECT_EQ(wheel.advance(origin + far - 1ms, queue), 0u);
+    EXPECT_EQ(wheel.advance(origin + far, queue), 1u);
+}
+
+TEST_F(TimingWheelTest, CancelRemovesTimer)
+{
+    auto id = wheel.schedule(oneOff(1), origin + 100ms);
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.cancel(id));
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(wheel.advance(origin + 1s, queue), 0u);
+}
+
+TEST_F(TimingWheelTest, CancelledSlotIsNotConfusedWithReuse)
+{
+    auto first = wheel.schedule(oneOff(1), origin + 100ms);
+    EXPECT_TRUE(wheel.cancel(first));
+    auto second = wheel.schedule(oneOff(2), origin + 100ms);
+    EXPECT_NE(first, second);
+    EXPECT_FALSE(wheel.cancel(first));
+    EXPECT_EQ(wheel.advance(origin + 100ms, queue), 1u);
+}
+
+TEST_F(TimingWheelTest, RecurringRearmsAtFixedRate)
+{
+    auto id = wheel.schedule(
+        Task([] {}, 3, sequence++, 10ms, origin, std::nullopt),
+        origin + 10ms);
+
+    EXPECT_EQ(wheel.advance(origin + 15ms, queue), 1u);
+    // 20ms and 30ms both elapsed since the last advance
+    EXPECT_EQ(wheel.advance(origin + 35ms, queue), 2u);
+    EXPECT_EQ(wheel.advance(origin + 40ms, queue), 1u);
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_EQ(queue.size(), 4u);
+
+    auto t = queue.pop();
+    ASSERT_TRUE(t.has_value());
+    EXPECT_EQ(t->priority, 3);
+
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_EQ(wheel.advance(origin + 100ms, queue), 0u);
+}
+
+TEST_F(TimingWheelTest, NextExpiryIsNeverLaterThanTheTimer)
+{
+    wheel.advance(origin + 17ms, queue);
+    wheel.schedule(oneOff(1), origin + 1000ms);
+    auto next = wheel.nextExpiry();
+    ASSERT_TRUE(next.has_value());
+    EXPECT_LE(*next, origin + 1000ms);
+    EXPECT_GT(*next, origin + 17ms);
+}
+
+TEST_F(TimingWheelTest, RespectsTickResolution)
+{
+    TimingWheel coarse{sequence, 10ms, origin};
+    EXPECT_EQ(coarse.tickResolution(), 10ms);
+    coarse.schedule(oneOff(1), origin + 15ms);
+    // rounded up to the next tick, never early
+    EXPECT_EQ(coarse.advance(origin + 15ms, queue), 0u);
+    EXPECT_EQ(coarse.advance(origin + 20ms, queue), 1u);
+}
+
+TEST_F(TimingWheelTest, ReprioritizeAppliesToLaterFires)
+{
+    auto id = wheel.schedule(
+        Task([] {}, 1, sequence++, 10ms, origin, std::nullopt), origin + 10ms);
+
+    wheel.advance(origin + 10ms, queue);
+    EXPECT_EQ(queue.pop()->priority, 1);
+
+    EXPECT_TRUE(wheel.reprioritize(id, 7));
+    EXPECT_TRUE(wheel.changeDeadline(id, origin + 1s));
+    wheel.advance(origin + 20ms, queue);
+    auto fired = queue.pop();
+    ASSERT_TRUE(fired.has_value());
+    EXPECT_EQ(fired->priority, 7);
+    EXPECT_EQ(fired->deadline, origin + 1s);
+
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.reprioritize(id, 3));
+}
+
+TEST_F(TimingWheelTest, SlackLinesUpNearbyTimers)
+{
+    scheduler::RecurringOptions options;
+    options.slack = 10ms;  // fires move to multiples of 8ms
+    wheel.schedule(Task([] {}, 1, sequence++, 16ms, origin, std::nullopt),
+                   origin + 3ms, options);
+    wheel.schedule(Task([] {}, 1, sequence++, 16ms, origin, std::nullopt),
+                   origin + 5ms, options);
+
+    EXPECT_EQ(wheel.advance(origin + 7ms, queue), 0u);
+    EXPECT_EQ(wheel.nextExpiry(), origin + 8ms);
+    EXPECT_EQ(wheel.advance(origin + 8ms, queue), 2u);
+    // next fires are due at 19ms and 21ms and share the 24ms tick
+    EXPECT_EQ(wheel.advance(origin + 23ms, queue), 0u);
+    EXPECT_EQ(wheel.advance(origin + 24ms, queue), 2u);
+}
+
+TEST_F(TimingWheelTest, SkipsFiresMissedDuringAStall)
+{
+    scheduler::RecurringOptions options;
+    options.missed = scheduler::MissedFires::Skip;
+    wheel.schedule(Task([] {}, 1, sequence++, 10ms, origin, std::nullopt),
+                   origin + 10ms, options);
+
+    // 10ms through 50ms are all due; only one of them runs
+    EXPECT_EQ(wheel.advance(origin + 55ms, queue), 1u);
+    // and the schedule goes on at 60ms, not 55ms + 10ms
+    EXPECT_EQ(wheel.advance(origin + 59ms, queue), 0u);
+    EXPECT_EQ(wheel.advance(origin + 60ms, queue), 1u);
+}
+
+TEST(TimingWheel, FixedDelayWaitsForTheRunToReturn)
+{
+    std::atomic<uint64_t> sequence{0};
+    auto origin = std::chrono::steady_clock::now();
+    auto wheel = std::make_shared<TimingWheel>(sequence, 1ms, origin);
+    TaskQueue queue;
+    std::vector<time_point> resumed;
+    wheel->onResume([&](time_point at) { resumed.push_back(at); });
+
+    scheduler::RecurringOptions options;
+    options.cadence = scheduler::Cadence::FixedDelay;
+    int runs = 0;
+    auto id = wheel->schedule(
+        Task([&] { ++runs; }, 1, sequence++, 10ms, origin, std::nullopt),
+        origin + 10ms, options);
+
+    EXPECT_EQ(wheel->advance(origin + 10ms, queue), 1u);
+    // off the wheel while the fire is out
+    EXPECT_EQ(wheel->advance(origin + 100ms, queue), 0u);
+    EXPECT_FALSE(wheel->nextExpiry().has_value());
+    EXPECT_EQ(wheel->size(), 1u);
+
+    auto before = std::chrono::steady_clock::now();
+    queue.pop()->task();
+    EXPECT_EQ(runs, 1);
+    ASSERT_EQ(resumed.size(), 1u);
+    EXPECT_GE(resumed[0], before + 10ms);
+    EXPECT_TRUE(wheel->nextExpiry().has_value());
+
+    EXPECT_TRUE(wheel->cancel(id));
+    EXPECT_EQ(wheel->size(), 0u);
+}
+
+TEST(TimingWheel, FixedDelayIsTimedByTheWheelsClock)
+{
+    class ManualClock : public IClock {
+    public:
+        time_point now() const override { return now_; }
+        time_point now_ = std::chrono::steady_clock::now() + 1h;
+    };
+    auto clock = std::make_shared<ManualClock>();
+    std::atomic<uint64_t> sequence{0};
+    auto origin = clock->now();
+    auto wheel = std::make_shared<TimingWheel>(sequence, 1ms, origin, clock);
+    TaskQueue queue;
+    std::vector<time_point> resumed;
+    wheel->onResume([&](time_point at) { resumed.push_back(at); });
+
+    scheduler::RecurringOptions options;
+    options.cadence = scheduler::Cadence::FixedDelay;
+    wheel->schedule(Task([] {}, 1, sequence++, 10ms, origin, std::nullopt),
+                    origin + 10ms, options);
+    wheel->advance(origin + 10ms, queue);
+
+    clock->now_ = origin + 25ms;
+    queue.pop()->task();
+    ASSERT_EQ(resumed.size(), 1u);
+    EXPECT_EQ(resumed[0], origin + 35ms);
+}
+
+TEST_F(TimingWheelTest, OverrunningFixedRateRunsNeverOverlap)
+{
+    std::promise<void> entered;
+    std::promise<void> leave;
+    std::shared_future<void> left = leave.get_future().share();
+    std::atomic<int> inside{0};
+    std::atomic<int> overlaps{0};
+    std::vector<int> seen;
+    // state of the callable itself, shared by every fire
+    wheel.schedule(Task([&, count = 0]() mutable {
+                            if (inside.fetch_add(1) != 0) overlaps.fetch_add(1);
+                            seen.push_back(++count);
+                            if (count == 1) {
+                                entered.set_value();
+                                left.wait();
+                            }
+                            inside.fetch_sub(1);
+                        },
+                        1, sequence++, 1ms, origin, std::nullopt),
+                   origin + 1ms);
+
+    ASSERT_EQ(wheel.advance(origin + 3ms, queue), 3u);
+    auto first = queue.pop();
+    std::thread runner([&] { first->task(); });
+    entered.get_future().wait();
+    // due while the first run is still going: left to it
+    queue.pop()->task();
+    queue.pop()->task();
+    EXPECT_EQ(seen.size(), 1u);
+
+    leave.set_value();
+    runner.join();
+    EXPECT_EQ(seen, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(overlaps.load(), 0);
+}
+
+TEST_F(TimingWheelTest, OverrunWithSkippedFiresRunsOnceMore)
+{
+    scheduler::RecurringOptions options;
+    options.missed = scheduler::MissedFires::Skip;
+    std::promise<void> entered;
+    std::promise<void> leave;
+    std::shared_future<void> left = leave.get_future().share();
+    int runs = 0;
+    wheel.schedule(Task([&] {
+                            if (++runs == 1) {
+                                entered.set_value();
+                                left.wait();
+                            }
+                        },
+                        1, sequence++, 1ms, origin, std::nullopt),
+                   origin + 1ms, options);
+
+    // one fire per advance, as the wheel skips only within a single call
+    for (int tick = 1; tick <= 3; ++tick) {
+        wheel.advance(origin + std::chrono::milliseconds{tick}, queue);
+    }
+    ASSERT_EQ(queue.size(), 3u);
+    auto first = queue.pop();
+    std::thread runner([&] { first->task(); });
+    entered.get_future().wait();
+    queue.pop()->task();
+    queue.pop()->task();
+
+    leave.set_value();
+    runner.join();
+    EXPECT_EQ(runs, 2);
+}
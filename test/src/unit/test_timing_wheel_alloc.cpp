@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "detail/timing_wheel.h"
+#include "detail/task_queue_impl.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+namespace {
+std::atomic<size_t> allocations{0};
+}
+
+// counts what reaches the global allocator; the replacement applies to the
+// whole binary, which is why this test is kept apart from test_timing_wheel
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+
+TEST(TimingWheel, RecurringFiresDoNotAllocate)
+{
+    std::atomic<uint64_t> sequence{0};
+    auto origin = std::chrono::steady_clock::now();
+    auto wheel = std::make_shared<TimingWheel>(sequence, 1ms, origin);
+    TaskQueue queue;
+    int runs = 0;
+    wheel->schedule(Task([&] { ++runs; }, 1, sequence++, 1ms, origin,
+                         std::nullopt, makeTaskState()),
+                    origin + 1ms);
+
+    auto cycle = [&](int tick) {
+        wheel->advance(origin + std::chrono::milliseconds{tick}, queue);
+        auto fire = queue.pop();
+        fire->task();
+    };
+    // first fires size the wheel's and the queue's buffers
+    for (int tick = 1; tick <= 100; ++tick) cycle(tick);
+
+    auto before = allocations.load();
+    for (int tick = 101; tick <= 1100; ++tick) cycle(tick);
+    EXPECT_EQ(allocations.load() - before, 0u);
+    EXPECT_EQ(runs, 1100);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "detail/tracer.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace scheduler::detail;
+using namespace std::chrono_literals;
+
+namespace {
+size_t occurrences(std::string const& text, std::string const& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos;
+         at = text.find(needle, at + 1)) {
+        ++count;
+    }
+    return count;
+}
+}
+
+TEST(Tracer, JoinsDispatchAndRunOfATask)
+{
+    auto origin = std::chrono::steady_clock::now();
+    Tracer tracer{16};
+    tracer.dispatched(7, origin + 1ms, origin + 3ms, 5, 1);
+    std::thread([&] { tracer.ran(7, origin + 4ms, origin + 6ms); }).join();
+
+    auto json = tracer.render();
+    EXPECT_EQ(occurrences(json, "\"ph\":\"X\""), 1u);
+    EXPECT_NE(json.find("\"args\":{\"task\":7,\"priority\":5,\"lane\":1}"),
+              std::string::npos);
+    EXPECT_NE(json.find("\"dur\":2000.000"), std::string::npos);
+    EXPECT_EQ(occurrences(json, "\"name\":\"queued\""), 2u);
+    EXPECT_EQ(occurrences(json, "\"name\":\"pool\""), 2u);
+    EXPECT_NE(json.find("\"name\":\"dispatcher 1\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"worker 2\""), std::string::npos);
+}
+
+TEST(Tracer, KeepsTheLatestEventsOfAThread)
+{
+    auto origin = std::chrono::steady_clock::now();
+    Tracer tracer{4};
+    for (uint64_t task = 0; task < 10; ++task) {
+        tracer.ran(task, origin, origin + 1us);
+    }
+    auto json = tracer.render();
+    EXPECT_EQ(occurrences(json, "\"ph\":\"X\""), 4u);
+    EXPECT_EQ(json.find("\"task\":5}"), std::string::npos);
+    EXPECT_NE(json.find("\"task\":6}"), std::string::npos);
+    EXPECT_NE(json.find("\"task\":9}"), std::string::npos);
+}
+
+TEST(Tracer, RendersWhileThreadsRecord)
+{
+    Tracer tracer{64};
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        uint64_t task = 0;
+        while (!stop.load()) {
+            auto now = std::chrono::steady_clock::now();
+            tracer.ran(task++, now, now);
+        }
+    });
+    for (int i = 0; i < 100; ++i) {
+        auto json = tracer.render();
+        EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+        EXPECT_LE(occurrences(json, "\"ph\":\"X\""), 64u);
+    }
+    stop = true;
+    writer.join();
+}
+
+TEST(Tracer, WritesAFile)
+{
+    Tracer tracer{16};
+    auto now = std::chrono::steady_clock::now();
+    tracer.ran(1, now, now);
+    std::string path = ::testing::TempDir() + "tracer_test.json";
+    ASSERT_TRUE(tracer.write(path));
+    std::ifstream file{path};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(contents.str(), tracer.render());
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(tracer.write("/nonexistent/dir/trace.json"));
+}
@@ -0,0 +1,214 @@
+#include <atomic>
+#include <future>
+#include <set>
+#include <gmock/gmock.h>
+#include "detail/chase_lev_deque.h"
+#include "detail/work_stealing_thread_pool_impl.h"
+
+using ::testing::InvokeWithoutArgs;
+using namespace scheduler::detail;
+
+TEST(ChaseLevDeque, OwnerPopsLifoThiefStealsFifo)
+{
+    ChaseLevDeque<int> deque{2};
+    int values[4] = {0, 1, 2, 3};
+    for (int& v : values) deque.push(&v);
+
+    EXPECT_EQ(deque.size(), 4u);
+    EXPECT_EQ(*deque.steal(), 0);
+    EXPECT_EQ(*deque.pop(), 3);
+    EXPECT_EQ(*deque.steal(), 1);
+    EXPECT_EQ(*deque.pop(), 2);
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(ChaseLevDeque, ConcurrentStealsTakeEveryItemOnce)
+{
+    constexpr int N = 10000;
+    ChaseLevDeque<int> deque{16};
+    std::vector<int> values(N);
+    std::atomic<int> taken{0};
+    std::atomic<bool> done{false};
+    std::vector<std::vector<int*>> stolen(3);
+
+    std::vector<std::thread> thieves;
+    for (size_t i = 0; i < stolen.size(); ++i) {
+        thieves.emplace_back([&, i]{
+            while (!done.load() || !deque.empty()) {
+                if (int* v = deque.steal()) {
+                    stolen[i].push_back(v);
+                    taken.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    std::vector<int*> popped;
+    for (int i = 0; i < N; ++i) {
+        deque.push(&values[i]);
+        if (i % 3 == 0) {
+            if (int* v = deque.pop()) {
+                popped.push_back(v);
+                taken.fetch_add(1);
+            }
+        }
+    }
+    while (int* v = deque.pop()) {
+        popped.push_back(v);
+        taken.fetch_add(1);
+    }
+    done.store(true);
+    for (auto& t : thieves) t.join();
+
+    std::set<int*> unique(popped.begin(), popped.end());
+    for (auto& s : stolen) unique.insert(s.begin(), s.end());
+    EXPECT_EQ(taken.load(), N);
+    EXPECT_EQ(unique.size(), static_cast<size_t>(N));
+}
+
+class WorkStealingThreadPoolTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        pool = std::make_unique<WorkStealingThreadPool>(4);
+        pool->start();
+    }
+    void TearDown() override
+    {
+        pool->stop();
+    }
+
+    std::unique_ptr<WorkStealingThreadPool> pool;
+};
+
+struct MockTask
+{
+    MOCK_METHOD(void, run, ());
+};
+
+TEST_F(WorkStealingThreadPoolTest, ExternalSubmitRuns)
+{
+    std::promise<void> p;
+    MockTask m;
+    EXPECT_CALL(m, run()).WillOnce(InvokeWithoutArgs([&]{ p.set_value(); }));
+
+    ASSERT_TRUE(pool->submit([&]{ m.run(); }));
+    ASSERT_EQ(std::future_status::ready,
+              p.get_future().wait_for(std::chrono::seconds(1)));
+}
+
+TEST_F(WorkStealingThreadPoolTest, NestedSubmitsRunAndGetStolen)
+{
+    constexpr int N = 200;
+    std::atomic<int> counter{0};
+    std::promise<void> p;
+
+    // one job fans out into slow children on its local deque, idle workers
+    // have to steal them
+    ASSERT_TRUE(pool->submit([&]{
+        for (int i = 0; i < N; ++i) {
+            pool->submit([&]{
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                if (counter.fetch_add(1) + 1 == N) p.set_value();
+            });
+        }
+    }));
+
+    ASSERT_EQ(std::future_status::ready,
+              p.get_future().wait_for(std::chrono::seconds(5)));
+    EXPECT_GT(pool->stealCount(), 0u);
+    EXPECT_GT(pool->idleCount(), 0u);
+}
+
+TEST_F(WorkStealingThreadPoolTest, ExceptionInOneTaskDoesNotBlockOthers)
+{
+    std::promise<void> p;
+    ASSERT_TRUE(pool->submit([]{ throw std::runtime_error("fail"); }));
+    ASSERT_TRUE(pool->submit([&]{ p.set_value(); }));
+    ASSERT_EQ(std::future_status::ready,
+              p.get_future().wait_for(std::chrono::seconds(1)));
+}
+
+TEST_F(WorkStealingThreadPoolTest, NoTasksRunAfterStop)
+{
+    pool->stop();
+    EXPECT_FALSE(pool->submit([]{ FAIL(); }));
+}
+
+TEST_F(WorkStealingThreadPoolTest, PendingTasksDrainedOnShutdown)
+{
+    constexpr int N = 50;
+    std::atomic<int> counter{0};
+    for (int i = 0; i < N; ++i) {
+        ASSERT_TRUE(pool->submit([&]{
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            counter.fetch_add(1);
+        }));
+    }
+    pool->stop();
+    EXPECT_EQ(counter.load(), N);
+}
+
+TEST_F(WorkStealingThreadPoolTest, SubmitBatchFromOutsideAndInside)
+{
+    constexpr int N = 64;
+    std::atomic<int> counter{0};
+    std::promise<void> p;
+    auto bump = [&]{
+        if (counter.fetch_add(1) + 1 == 2 * N) p.set_value();
+    };
+
+    std::vector<Job> outer;
+    for (int i = 0; i < N - 1; ++i) outer.emplace_back(bump);
+    // one job fans out a nested batch onto its own deque
+    outer.emplace_back([&]{
+        std::vector<Job> inner;
+        for (int i = 0; i < N; ++i) inner.emplace_back(bump);
+        pool->submitBatch(inner);
+        bump();
+    });
+    ASSERT_TRUE(pool->submitBatch(outer));
+    ASSERT_EQ(std::future_status::ready,
+              p.get_future().wait_for(std::chrono::seconds(2)));
+}
+
+TEST(WorkStealingThreadPool, CpuFrugalPoolParksAndWakes)
+{
+    WorkStealingThreadPool pool{2, IdlePolicy::cpuFrugal()};
+    pool.start();
+    for (int round = 0; round < 10; ++round) {
+        std::promise<void> p;
+        ASSERT_TRUE(pool.submit([&]{ p.set_value(); }));
+        ASSERT_EQ(std::future_status::ready,
+                  p.get_future().wait_for(std::chrono::seconds(1)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_GT(pool.idleCount(), 0u);
+    pool.stop();
+}
+
+TEST(WorkStealingThreadPool, NumaPlacementRunsNodeHintedJobs)
+{
+    scheduler::WorkerPlacement placement;
+    placement.numa = true;
+    placement.pin = true;
+    WorkStealingThreadPool pool{3, IdlePolicy::cpuFrugal(), placement};
+    pool.start();
+
+    std::atomic<int> ran{0};
+    std::promise<void> done;
+    constexpr int N = 12;
+    std::vector<Job> jobs;
+    for (int i = 0; i < N; ++i) {
+        jobs.emplace_back([&]{
+            if (ran.fetch_add(1) + 1 == N) done.set_value();
+        });
+    }
+    ASSERT_TRUE(pool.submitToNode(jobs, pool.plan().nodes[0].id));
+    ASSERT_EQ(std::future_status::ready,
+              done.get_future().wait_for(std::chrono::seconds(1)));
+    pool.stop();
+}